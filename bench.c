@@ -0,0 +1,771 @@
+/*****************************************************************************/
+/* Benchmark for the solver library.                                         */
+/*                                                                           */
+/* Each corpus is a file of puzzles in the batch format, one per line.  The  */
+/* puzzles are solved one at a time, first a few times over to warm up and   */
+/* then for a number of timed trials, and the time each one takes, loading   */
+/* included, is recorded.  For each corpus we report the mean, median, 99th  */
+/* percentile and worst of those times, and how many puzzles a second that   */
+/* comes to.  The results can be saved to a file, and compared with a saved  */
+/* baseline to catch regressions.                                            */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include "sudoku.h"
+#include "input.h"
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define TRUE 1
+#define FALSE 0
+
+#define LINE_LENGTH 1024
+#define MAX_CORPORA 64
+#define NAME_LENGTH 64
+#define OPTIONS_LENGTH 512
+
+/*****************************************************************************/
+/* Defaults: trials, warm-up passes, and how much worse (in percent) a       */
+/* result can be than the baseline before it counts as a regression.         */
+/*****************************************************************************/
+#define DEFAULT_TRIALS 5
+#define DEFAULT_WARMUP 1
+#define DEFAULT_THRESHOLD 10.0
+
+/*****************************************************************************/
+/* Results for one corpus.  Times are in microseconds.                       */
+/*****************************************************************************/
+struct result
+{
+  char name[NAME_LENGTH];
+  long puzzles;
+  long solved;
+  double mean;
+  double p50;
+  double p99;
+  double max;
+  double per_second;
+};
+
+/*****************************************************************************/
+/* One line of a result file.                                                */
+/*****************************************************************************/
+#define RESULT_FORMAT \
+  "corpus=%s puzzles=%ld solved=%ld mean_us=%.2f p50_us=%.2f p99_us=%.2f " \
+  "max_us=%.2f per_second=%.1f\n"
+#define RESULT_SCAN \
+  "corpus=%63s puzzles=%ld solved=%ld mean_us=%lf p50_us=%lf p99_us=%lf " \
+  "max_us=%lf per_second=%lf"
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+static char (*read_corpus(const char *, long *))[SUDOKU_CELLS + 2];
+static int run_corpus(sudoku_solver_t *,
+                      const char *,
+                      int,
+                      int,
+                      struct result *);
+static int compare_latency(const void *, const void *);
+static int write_results(const char *,
+                         const char *,
+                         const struct result *,
+                         int);
+static int read_results(const char *, struct result *, int *);
+static int compare_results(const struct result *,
+                           int,
+                           const struct result *,
+                           int,
+                           double);
+static int check_metric(const char *,
+                        const char *,
+                        double,
+                        double,
+                        int,
+                        int,
+                        double);
+static double now_seconds(void);
+
+int main (int argc, char *argv[])
+{
+  struct result results[MAX_CORPORA];
+  struct result baseline[MAX_CORPORA];
+  char options[OPTIONS_LENGTH] = "";
+  int num_results = 0;
+  int num_baseline = 0;
+  int trials = DEFAULT_TRIALS;
+  int warmup = DEFAULT_WARMUP;
+  double threshold = DEFAULT_THRESHOLD;
+  const char *output = NULL;
+  const char *baseline_file = NULL;
+  const char *value;
+  const char *restart = sudoku_restart_name(0);
+  long restart_nodes = SUDOKU_RESTART_NODES;
+  int ii;
+  int rc = TRUE;
+  sudoku_solver_t *sv;
+
+  sv = sudoku_init();
+
+  if (sv == NULL)
+  {
+    printf("Out of memory\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  /***************************************************************************/
+  /* "--compare OLD NEW" just compares two saved result files.               */
+  /***************************************************************************/
+  if ((argc >= 4) &&
+      (strcmp(argv[1], "--compare") == 0))
+  {
+    if (argc > 4)
+    {
+      threshold = (strncmp(argv[4], "--threshold=", 12) == 0) ?
+                  atof(argv[4] + 12) : -1;
+    }
+
+    rc = ((threshold >= 0) &&
+          (read_results(argv[2], baseline, &num_baseline) == TRUE) &&
+          (read_results(argv[3], results, &num_results) == TRUE));
+
+    if (rc == TRUE)
+    {
+      rc = compare_results(baseline,
+                           num_baseline,
+                           results,
+                           num_results,
+                           threshold);
+    }
+    goto EXIT;
+  }
+
+  /***************************************************************************/
+  /* Pick out the options, keeping a note of the ones that configure the     */
+  /* solver to go in the result file.  The rest of the arguments are the     */
+  /* corpora.                                                                */
+  /***************************************************************************/
+  for (ii=1; (ii < argc) && (argv[ii][0] == '-'); ii++)
+  {
+    if (strncmp(argv[ii], "--trials=", 9) == 0)
+    {
+      trials = atoi(argv[ii] + 9);
+      continue;
+    }
+    else if (strncmp(argv[ii], "--warmup=", 9) == 0)
+    {
+      warmup = atoi(argv[ii] + 9);
+      continue;
+    }
+    else if (strncmp(argv[ii], "--output=", 9) == 0)
+    {
+      output = argv[ii] + 9;
+      continue;
+    }
+    else if (strncmp(argv[ii], "--baseline=", 11) == 0)
+    {
+      baseline_file = argv[ii] + 11;
+      continue;
+    }
+    else if (strncmp(argv[ii], "--threshold=", 12) == 0)
+    {
+      threshold = atof(argv[ii] + 12);
+      continue;
+    }
+    else if (strncmp(argv[ii], "--engine=", 9) == 0)
+    {
+      rc = sudoku_set_engine(sv, argv[ii] + 9);
+    }
+    else if (strncmp(argv[ii], "--kernel=", 9) == 0)
+    {
+      rc = sudoku_set_kernel(sv, argv[ii] + 9);
+    }
+    else if (strncmp(argv[ii], "--branch=", 9) == 0)
+    {
+      rc = sudoku_set_branching(sv, argv[ii] + 9);
+    }
+    else if (strncmp(argv[ii], "--rules=", 8) == 0)
+    {
+      rc = sudoku_set_rules(sv, argv[ii] + 8);
+    }
+    else if ((strncmp(argv[ii], "--restarts=", 11) == 0) ||
+             (strncmp(argv[ii], "--restart-nodes=", 16) == 0))
+    {
+      if (argv[ii][9] == 's')
+      {
+        restart = argv[ii] + 11;
+      }
+      else
+      {
+        restart_nodes = atol(argv[ii] + 16);
+      }
+      rc = sudoku_set_restarts(sv, restart, restart_nodes);
+    }
+    else if (strncmp(argv[ii], "--seed=", 7) == 0)
+    {
+      rc = sudoku_set_seed(sv, strtoul(argv[ii] + 7, NULL, 10));
+    }
+    else if (strcmp(argv[ii], "--portfolio") == 0)
+    {
+      rc = sudoku_set_portfolio(sv, TRUE);
+    }
+    else if (strncmp(argv[ii], "-j", 2) == 0)
+    {
+      /***********************************************************************/
+      /* Number of threads, as "-j N" or "-jN".                              */
+      /***********************************************************************/
+      value = argv[ii] + 2;
+
+      if ((*value == '\0') &&
+          (ii + 1 < argc))
+      {
+        value = argv[++ii];
+      }
+      rc = sudoku_set_threads(sv, atoi(value));
+    }
+    else
+    {
+      rc = FALSE;
+    }
+
+    if (rc == FALSE)
+    {
+      printf("Bad option %s\n", argv[ii]);
+      goto EXIT;
+    }
+
+    /*************************************************************************/
+    /* Note the option, writing "-j N" as "-jN".                             */
+    /*************************************************************************/
+    if (strlen(options) + strlen(argv[ii]) + 4 < sizeof(options))
+    {
+      strcat(options, " ");
+      strcat(options, (argv[ii][0] != '-') ? "-j" : "");
+      strcat(options, argv[ii]);
+    }
+  }
+
+  if ((ii == argc) ||
+      (argc - ii > MAX_CORPORA) ||
+      (trials < 1) ||
+      (warmup < 0) ||
+      (threshold < 0))
+  {
+    /*************************************************************************/
+    /* Print usage information.                                              */
+    /*************************************************************************/
+    printf("Use: sudoku-bench [--trials=N] [--warmup=N] [--output=FILE]\n"
+           "                  [--baseline=FILE] [--threshold=PCT]\n"
+           "                  [solver options] corpus.txt...\n");
+    printf("     (times every puzzle in each corpus, one per line, over N "
+           "trials\n");
+    printf("     after N warm-up passes; defaults %d and %d)\n",
+           DEFAULT_TRIALS,
+           DEFAULT_WARMUP);
+    printf("     --output saves the results, and --baseline compares them "
+           "with\n");
+    printf("     saved results, flagging anything more than PCT%% worse "
+           "(default %.0f%%).\n",
+           DEFAULT_THRESHOLD);
+    printf("     The solver options are sudoku's --engine, --kernel, "
+           "--branch,\n");
+    printf("     --rules, --restarts, --restart-nodes, --seed, --portfolio "
+           "and -jN.\n");
+    printf("  or sudoku-bench --compare OLD NEW [--threshold=PCT]\n");
+    printf("     (compares two saved result files)\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  if ((baseline_file != NULL) &&
+      (read_results(baseline_file, baseline, &num_baseline) == FALSE))
+  {
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  /***************************************************************************/
+  /* Run each corpus in turn.                                                */
+  /***************************************************************************/
+  printf("%-14s %8s %8s %10s %10s %10s %10s %12s\n",
+         "corpus",
+         "puzzles",
+         "solved",
+         "mean us",
+         "p50 us",
+         "p99 us",
+         "max us",
+         "puzzles/s");
+
+  for (; ii < argc; ii++)
+  {
+    if (run_corpus(sv, argv[ii], warmup, trials, &results[num_results]) ==
+                                                                        FALSE)
+    {
+      rc = FALSE;
+      goto EXIT;
+    }
+
+    printf("%-14s %8ld %8ld %10.2f %10.2f %10.2f %10.2f %12.1f\n",
+           results[num_results].name,
+           results[num_results].puzzles,
+           results[num_results].solved,
+           results[num_results].mean,
+           results[num_results].p50,
+           results[num_results].p99,
+           results[num_results].max,
+           results[num_results].per_second);
+    (void)fflush(stdout);
+    num_results++;
+  }
+
+  if ((output != NULL) &&
+      (write_results(output, options, results, num_results) == FALSE))
+  {
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  if (baseline_file != NULL)
+  {
+    rc = compare_results(baseline,
+                         num_baseline,
+                         results,
+                         num_results,
+                         threshold);
+  }
+
+EXIT:
+
+  if (sv != NULL)
+  {
+    sudoku_free(sv);
+  }
+
+  return (rc ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/*****************************************************************************/
+/* Reads a corpus into memory, skipping blank lines and lines starting with  */
+/* '#' as batch mode does.  Returns NULL, having said why, if it can't.      */
+/*****************************************************************************/
+static char (*read_corpus(const char *file_name, long *count))[SUDOKU_CELLS + 2]
+{
+  struct input in;
+  const char *line;
+  char (*puzzles)[SUDOKU_CELLS + 2] = NULL;
+  char (*bigger)[SUDOKU_CELLS + 2];
+  long room = 0;
+  size_t len;
+  size_t offset;
+  int opened;
+
+  *count = 0;
+  opened = input_open(&in, file_name);
+
+  if (opened == FALSE)
+  {
+    printf("Failed to open corpus %s\n", file_name);
+    goto EXIT;
+  }
+
+  while (input_line(&in, &line, &len, &offset) == TRUE)
+  {
+    if ((len == 0) ||
+        (line[0] == '#') ||
+        (input_blank(line, len) == TRUE))
+    {
+      continue;
+    }
+
+    if (*count == room)
+    {
+      room = (room == 0) ? 1024 : (room * 2);
+      bigger = realloc(puzzles, sizeof(*puzzles) * room);
+
+      if (bigger == NULL)
+      {
+        printf("Out of memory\n");
+        free(puzzles);
+        puzzles = NULL;
+        goto EXIT;
+      }
+      puzzles = bigger;
+    }
+
+    /*************************************************************************/
+    /* Keep the puzzle and the character after it, which the library         */
+    /* checks.                                                               */
+    /*************************************************************************/
+    if (len > (SUDOKU_CELLS+1))
+    {
+      len = SUDOKU_CELLS+1;
+    }
+    memcpy(puzzles[*count], line, len);
+    puzzles[*count][len] = '\0';
+    (*count)++;
+  }
+
+  if (*count == 0)
+  {
+    printf("No puzzles in corpus %s\n", file_name);
+    free(puzzles);
+    puzzles = NULL;
+  }
+
+EXIT:
+
+  if (opened == TRUE)
+  {
+    input_close(&in);
+  }
+
+  return (puzzles);
+}
+
+/*****************************************************************************/
+/* Times every puzzle of a corpus.  The corpus is named after its file, less */
+/* any directory and extension.  Throughput is worked out from the time      */
+/* spent solving, not the time spent in between.                             */
+/*****************************************************************************/
+static int run_corpus(sudoku_solver_t *sv,
+                      const char *file_name,
+                      int warmup,
+                      int trials,
+                      struct result *result)
+{
+  char (*puzzles)[SUDOKU_CELLS + 2];
+  double *latency = NULL;
+  double total = 0;
+  double start;
+  long count;
+  long num;
+  long jj;
+  int ii;
+  int status;
+  const char *name;
+  size_t len;
+  int rc = TRUE;
+
+  puzzles = read_corpus(file_name, &count);
+
+  if (puzzles == NULL)
+  {
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  latency = malloc(sizeof(*latency) * count * trials);
+
+  if (latency == NULL)
+  {
+    printf("Out of memory\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  name = strrchr(file_name, '/');
+  name = (name == NULL) ? file_name : (name + 1);
+  len = strcspn(name, ".");
+  if (len >= NAME_LENGTH)
+  {
+    len = NAME_LENGTH - 1;
+  }
+  memcpy(result->name, name, len);
+  result->name[len] = '\0';
+  result->puzzles = count;
+  result->solved = 0;
+
+  for (ii=0; ii < warmup; ii++)
+  {
+    for (jj=0; jj < count; jj++)
+    {
+      if (sudoku_load_line(sv, puzzles[jj]) == TRUE)
+      {
+        (void)sudoku_solve(sv);
+      }
+    }
+  }
+
+  for (ii=0, num=0; ii < trials; ii++)
+  {
+    for (jj=0; jj < count; jj++, num++)
+    {
+      start = now_seconds();
+      status = SUDOKU_BAD_INPUT;
+      if (sudoku_load_line(sv, puzzles[jj]) == TRUE)
+      {
+        status = sudoku_solve(sv);
+      }
+      latency[num] = (now_seconds() - start) * 1e6;
+      total += latency[num];
+
+      if ((ii == 0) &&
+          (status == SUDOKU_SOLVED))
+      {
+        result->solved++;
+      }
+    }
+  }
+
+  /***************************************************************************/
+  /* Percentiles are by nearest rank.                                        */
+  /***************************************************************************/
+  qsort(latency, (size_t)num, sizeof(*latency), compare_latency);
+  result->mean = total / num;
+  result->p50 = latency[((num + 1) / 2) - 1];
+  result->p99 = latency[((num * 99) + 99) / 100 - 1];
+  result->max = latency[num - 1];
+  result->per_second = (total > 0) ? (num / (total / 1e6)) : 0.0;
+
+EXIT:
+
+  free(puzzles);
+  free(latency);
+
+  return (rc);
+}
+
+static int compare_latency(const void *aa, const void *bb)
+{
+  double xx = *(const double *)aa;
+  double yy = *(const double *)bb;
+
+  return ((xx > yy) - (xx < yy));
+}
+
+/*****************************************************************************/
+/* Result files hold a line per corpus, in RESULT_FORMAT.  Lines starting    */
+/* with '#' are comments: the first notes the solver options used.           */
+/*****************************************************************************/
+static int write_results(const char *file_name,
+                         const char *options,
+                         const struct result *results,
+                         int num_results)
+{
+  FILE *file;
+  int ii;
+  int rc;
+
+  file = fopen(file_name, "w");
+
+  if (file == NULL)
+  {
+    printf("Failed to open output file %s\n", file_name);
+    return (FALSE);
+  }
+
+  fprintf(file, "# sudoku-bench options:%s\n", options);
+
+  for (ii=0; ii < num_results; ii++)
+  {
+    fprintf(file,
+            RESULT_FORMAT,
+            results[ii].name,
+            results[ii].puzzles,
+            results[ii].solved,
+            results[ii].mean,
+            results[ii].p50,
+            results[ii].p99,
+            results[ii].max,
+            results[ii].per_second);
+  }
+
+  rc = (ferror(file) == 0);
+
+  if ((fclose(file) != 0) ||
+      (rc == FALSE))
+  {
+    printf("Failed to write output file %s\n", file_name);
+    rc = FALSE;
+  }
+
+  return (rc);
+}
+
+static int read_results(const char *file_name,
+                        struct result *results,
+                        int *num_results)
+{
+  char line[LINE_LENGTH];
+  struct result *result;
+  FILE *file;
+  int rc = TRUE;
+
+  *num_results = 0;
+  file = fopen(file_name, "r");
+
+  if (file == NULL)
+  {
+    printf("Failed to open result file %s\n", file_name);
+    return (FALSE);
+  }
+
+  while ((rc == TRUE) &&
+         (fgets(line, sizeof(line), file) != NULL))
+  {
+    if ((line[strspn(line, " \t\r\n")] == '\0') ||
+        (line[0] == '#'))
+    {
+      continue;
+    }
+
+    result = &results[*num_results];
+
+    if ((*num_results == MAX_CORPORA) ||
+        (sscanf(line,
+                RESULT_SCAN,
+                result->name,
+                &result->puzzles,
+                &result->solved,
+                &result->mean,
+                &result->p50,
+                &result->p99,
+                &result->max,
+                &result->per_second) != 8))
+    {
+      printf("Bad line in result file %s: %s", file_name, line);
+      rc = FALSE;
+    }
+    (*num_results)++;
+  }
+
+  (void)fclose(file);
+  return (rc);
+}
+
+/*****************************************************************************/
+/* Compares results with a baseline, corpus by corpus, and flags any metric  */
+/* more than threshold percent worse.  The worst case is too noisy to judge  */
+/* by, so it's shown but never flagged.  Returns FALSE if anything was.      */
+/*****************************************************************************/
+static int compare_results(const struct result *old,
+                           int num_old,
+                           const struct result *cur,
+                           int num_cur,
+                           double threshold)
+{
+  const struct result *base;
+  int ii;
+  int jj;
+  int regressions = 0;
+
+  printf("\n%-14s %-10s %12s %12s %9s\n",
+         "corpus",
+         "metric",
+         "baseline",
+         "current",
+         "change");
+
+  for (ii=0; ii < num_cur; ii++)
+  {
+    for (jj=0, base=NULL; (jj < num_old) && (base == NULL); jj++)
+    {
+      if (strcmp(old[jj].name, cur[ii].name) == 0)
+      {
+        base = &old[jj];
+      }
+    }
+
+    if (base == NULL)
+    {
+      printf("%-14s not in the baseline\n", cur[ii].name);
+      continue;
+    }
+
+    if ((base->puzzles != cur[ii].puzzles) ||
+        (base->solved != cur[ii].solved))
+    {
+      /***********************************************************************/
+      /* Either the corpus changed or the solver is getting different        */
+      /* answers.  The timings can't be compared either way.                 */
+      /***********************************************************************/
+      printf("%-14s solved %ld of %ld, baseline %ld of %ld  REGRESSION\n",
+             cur[ii].name,
+             cur[ii].solved,
+             cur[ii].puzzles,
+             base->solved,
+             base->puzzles);
+      regressions++;
+      continue;
+    }
+
+    regressions += check_metric(cur[ii].name, "mean_us",
+                                base->mean, cur[ii].mean,
+                                TRUE, TRUE, threshold);
+    regressions += check_metric(cur[ii].name, "p50_us",
+                                base->p50, cur[ii].p50,
+                                TRUE, TRUE, threshold);
+    regressions += check_metric(cur[ii].name, "p99_us",
+                                base->p99, cur[ii].p99,
+                                TRUE, TRUE, threshold);
+    regressions += check_metric(cur[ii].name, "max_us",
+                                base->max, cur[ii].max,
+                                TRUE, FALSE, threshold);
+    regressions += check_metric(cur[ii].name, "per_second",
+                                base->per_second, cur[ii].per_second,
+                                FALSE, TRUE, threshold);
+  }
+
+  printf("%d regression%s (threshold %.1f%%)\n",
+         regressions,
+         (regressions == 1) ? "" : "s",
+         threshold);
+
+  return (regressions == 0);
+}
+
+/*****************************************************************************/
+/* Prints one metric against its baseline.  Returns 1 if it counts and is    */
+/* more than threshold percent worse, which for latencies means higher and   */
+/* for throughput lower.                                                     */
+/*****************************************************************************/
+static int check_metric(const char *name,
+                        const char *metric,
+                        double old,
+                        double cur,
+                        int lower_is_better,
+                        int counts,
+                        double threshold)
+{
+  double change;
+  int regressed;
+
+  change = (old > 0) ? (((cur - old) * 100) / old) : 0.0;
+  regressed = counts &&
+              (lower_is_better ? (change > threshold) : (change < -threshold));
+
+  printf("%-14s %-10s %12.2f %12.2f %+8.1f%%%s\n",
+         name,
+         metric,
+         old,
+         cur,
+         change,
+         regressed ? "  REGRESSION" : "");
+
+  return (regressed ? 1 : 0);
+}
+
+/*****************************************************************************/
+/* Returns a wall-clock time in seconds for timing runs.  Standard C only    */
+/* offers processor time, so use a monotonic clock where POSIX provides one. */
+/*****************************************************************************/
+static double now_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec + (now.tv_nsec / 1e9));
+#else
+  return ((double)clock() / CLOCKS_PER_SEC);
+#endif
+}
@@ -0,0 +1,592 @@
+/*****************************************************************************/
+/* Result cache.  See cache.h, and sudoku.h for the public interface.        */
+/*                                                                           */
+/* Add #define NO_THREADS to build without POSIX threads.                    */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+#include "cache.h"
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define SIZE SUDOKU_SIZE
+#define BLOCK_SIZE 3
+#define TRUE 1
+#define FALSE 0
+
+/*****************************************************************************/
+/* Grids are kept two entries to a byte, the first in the low 4 bits.        */
+/*****************************************************************************/
+#define PACKED_SIZE ((SUDOKU_CELLS + 1) / 2)
+
+/*****************************************************************************/
+/* Exported caches start with the magic string, and then have a record for   */
+/* each entry, least recently used first: the canonical puzzle and its       */
+/* solution, packed, then the number of solutions and the limit it was       */
+/* solved with, 4 bytes each, least significant first.  Counts too big for   */
+/* that are kept as the biggest there is room for, which only makes them     */
+/* less useful.                                                              */
+/*****************************************************************************/
+#define MAGIC "SUDOKUC1"
+#define MAGIC_SIZE 8
+#define RECORD_SIZE ((2 * PACKED_SIZE) + 8)
+#define MAX_COUNT 0x7fffffffL
+
+/*****************************************************************************/
+/* Lock macros.  These do nothing without threads.                           */
+/*****************************************************************************/
+#ifdef NO_THREADS
+#define LOCK(C)
+#define UNLOCK(C)
+#else
+#define LOCK(C) (void)pthread_mutex_lock(&(C)->lock)
+#define UNLOCK(C) (void)pthread_mutex_unlock(&(C)->lock)
+#endif
+
+/*****************************************************************************/
+/* An entry.  Entries are linked, by index (-1 for none), into a list from   */
+/* most to least recently used and into their hash bucket's chain.           */
+/*****************************************************************************/
+struct entry
+{
+  unsigned char puzzle[PACKED_SIZE];
+  unsigned char solution[PACKED_SIZE];
+  long solutions;
+  long limit;
+  long newer;
+  long older;
+  long chain;
+};
+
+struct sudoku_cache
+{
+  struct entry *entries;
+  long capacity;
+  long used;
+  long newest;
+  long oldest;
+  long *buckets;
+  unsigned long mask;
+  long hits;
+  long misses;
+#ifndef NO_THREADS
+  pthread_mutex_t lock;
+#endif
+};
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+static void keep(sudoku_cache_t *,
+                 const unsigned char *,
+                 const unsigned char *,
+                 long,
+                 long);
+static long find(const sudoku_cache_t *, const unsigned char *);
+static unsigned long hash(const unsigned char *);
+static void unlink_entry(sudoku_cache_t *, long);
+static void link_newest(sudoku_cache_t *, long);
+static void pack(const int *, unsigned char *);
+static void unpack(const unsigned char *, int *);
+static int valid_record(const unsigned char *);
+static void put_count(unsigned char *, long);
+static long get_count(const unsigned char *);
+
+/*****************************************************************************/
+/* Creates a cache that holds up to capacity results.                        */
+/*****************************************************************************/
+sudoku_cache_t *sudoku_cache_init(long capacity)
+{
+  sudoku_cache_t *cache;
+  unsigned long num_buckets = 1;
+  unsigned long ii;
+
+  if (capacity < 1)
+  {
+    return (NULL);
+  }
+
+  cache = calloc(1, sizeof(*cache));
+
+  if (cache == NULL)
+  {
+    return (NULL);
+  }
+
+  while (num_buckets < (unsigned long)capacity)
+  {
+    num_buckets *= 2;
+  }
+
+  cache->entries = malloc((size_t)capacity * sizeof(*cache->entries));
+  cache->buckets = malloc((size_t)num_buckets * sizeof(*cache->buckets));
+
+  if ((cache->entries == NULL) ||
+      (cache->buckets == NULL))
+  {
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+    return (NULL);
+  }
+
+  for (ii=0; ii < num_buckets; ii++)
+  {
+    cache->buckets[ii] = -1;
+  }
+  cache->mask = num_buckets - 1;
+  cache->capacity = capacity;
+  cache->newest = -1;
+  cache->oldest = -1;
+#ifndef NO_THREADS
+  (void)pthread_mutex_init(&cache->lock, NULL);
+#endif
+
+  return (cache);
+}
+
+void sudoku_cache_free(sudoku_cache_t *cache)
+{
+  if (cache != NULL)
+  {
+#ifndef NO_THREADS
+    (void)pthread_mutex_destroy(&cache->lock);
+#endif
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+  }
+  return;
+}
+
+void sudoku_cache_stats(sudoku_cache_t *cache,
+                        long *entries,
+                        long *hits,
+                        long *misses)
+{
+  LOCK(cache);
+  *entries = cache->used;
+  *hits = cache->hits;
+  *misses = cache->misses;
+  UNLOCK(cache);
+  return;
+}
+
+/*****************************************************************************/
+/* Writes the entries out, least recently used first, so that importing      */
+/* them again leaves them in the same order.                                 */
+/*****************************************************************************/
+size_t sudoku_cache_export(sudoku_cache_t *cache,
+                           unsigned char *buffer,
+                           size_t size)
+{
+  const struct entry *entry;
+  unsigned char *pos = buffer;
+  size_t needed;
+  long ee;
+
+  LOCK(cache);
+  needed = MAGIC_SIZE + ((size_t)cache->used * RECORD_SIZE);
+
+  if ((buffer != NULL) &&
+      (size >= needed))
+  {
+    memcpy(pos, MAGIC, MAGIC_SIZE);
+    pos += MAGIC_SIZE;
+
+    for (ee=cache->oldest; ee >= 0; ee=entry->newer)
+    {
+      entry = &cache->entries[ee];
+      memcpy(pos, entry->puzzle, PACKED_SIZE);
+      memcpy(pos + PACKED_SIZE, entry->solution, PACKED_SIZE);
+      put_count(pos + (2 * PACKED_SIZE), entry->solutions);
+      put_count(pos + (2 * PACKED_SIZE) + 4, entry->limit);
+      pos += RECORD_SIZE;
+    }
+  }
+  UNLOCK(cache);
+
+  return (needed);
+}
+
+/*****************************************************************************/
+/* Reads entries back in.  Every record is checked before any is kept, so a  */
+/* damaged export changes nothing.                                           */
+/*****************************************************************************/
+long sudoku_cache_import(sudoku_cache_t *cache,
+                         const unsigned char *data,
+                         size_t size)
+{
+  const unsigned char *pos;
+  long num;
+  long ii;
+
+  if ((size < MAGIC_SIZE) ||
+      (memcmp(data, MAGIC, MAGIC_SIZE) != 0) ||
+      (((size - MAGIC_SIZE) % RECORD_SIZE) != 0))
+  {
+    return (-1);
+  }
+
+  num = (long)((size - MAGIC_SIZE) / RECORD_SIZE);
+
+  for (ii=0, pos=data + MAGIC_SIZE; ii < num; ii++, pos += RECORD_SIZE)
+  {
+    if (valid_record(pos) == FALSE)
+    {
+      return (-1);
+    }
+  }
+
+  LOCK(cache);
+  for (ii=0, pos=data + MAGIC_SIZE; ii < num; ii++, pos += RECORD_SIZE)
+  {
+    keep(cache,
+         pos,
+         pos + PACKED_SIZE,
+         get_count(pos + (2 * PACKED_SIZE)),
+         get_count(pos + (2 * PACKED_SIZE) + 4));
+  }
+  UNLOCK(cache);
+
+  return (num);
+}
+
+/*****************************************************************************/
+/* An entry found with a limit at least as high as the one asked for, or     */
+/* with fewer solutions than its limit (so all of them), says how many there */
+/* are up to the limit asked for.                                            */
+/*****************************************************************************/
+int cache_find(sudoku_cache_t *cache,
+               const int *puzzle,
+               long limit,
+               int *solution,
+               long *solutions)
+{
+  unsigned char key[PACKED_SIZE];
+  struct entry *entry;
+  long ee;
+  int rc = FALSE;
+
+  pack(puzzle, key);
+
+  LOCK(cache);
+  ee = find(cache, key);
+
+  if (ee >= 0)
+  {
+    entry = &cache->entries[ee];
+
+    if ((entry->limit >= limit) ||
+        (entry->solutions < entry->limit))
+    {
+      *solutions = (entry->solutions < limit) ? entry->solutions : limit;
+      unpack(entry->solution, solution);
+      unlink_entry(cache, ee);
+      link_newest(cache, ee);
+      rc = TRUE;
+    }
+  }
+
+  if (rc == TRUE)
+  {
+    cache->hits++;
+  }
+  else
+  {
+    cache->misses++;
+  }
+  UNLOCK(cache);
+
+  return (rc);
+}
+
+void cache_keep(sudoku_cache_t *cache,
+                const int *puzzle,
+                const int *solution,
+                long solutions,
+                long limit)
+{
+  unsigned char key[PACKED_SIZE];
+  unsigned char packed[PACKED_SIZE];
+
+  pack(puzzle, key);
+  pack(solution, packed);
+
+  LOCK(cache);
+  keep(cache,
+       key,
+       packed,
+       (solutions < MAX_COUNT) ? solutions : MAX_COUNT,
+       (limit < MAX_COUNT) ? limit : MAX_COUNT);
+  UNLOCK(cache);
+  return;
+}
+
+/*****************************************************************************/
+/* Keeps a result as the most recently used entry.  A puzzle already there   */
+/* keeps whichever result says more: the one solved with the higher limit,   */
+/* unless the other has all the solutions.  If the cache is full, the least  */
+/* recently used entry makes way.  Call with the lock held.                  */
+/*****************************************************************************/
+static void keep(sudoku_cache_t *cache,
+                 const unsigned char *puzzle,
+                 const unsigned char *solution,
+                 long solutions,
+                 long limit)
+{
+  struct entry *entry;
+  long *link;
+  long ee;
+
+  ee = find(cache, puzzle);
+
+  if (ee >= 0)
+  {
+    entry = &cache->entries[ee];
+    unlink_entry(cache, ee);
+    link_newest(cache, ee);
+
+    if ((entry->solutions < entry->limit) ||
+        ((limit <= entry->limit) &&
+         (solutions == limit)))
+    {
+      return;
+    }
+  }
+  else
+  {
+    if (cache->used < cache->capacity)
+    {
+      ee = cache->used++;
+    }
+    else
+    {
+      /***********************************************************************/
+      /* Take the oldest entry out of its chain and reuse it.                */
+      /***********************************************************************/
+      ee = cache->oldest;
+      unlink_entry(cache, ee);
+
+      for (link=&cache->buckets[hash(cache->entries[ee].puzzle) & cache->mask];
+           *link != ee;
+           link=&cache->entries[*link].chain)
+      {
+      }
+      *link = cache->entries[ee].chain;
+    }
+
+    entry = &cache->entries[ee];
+    memcpy(entry->puzzle, puzzle, PACKED_SIZE);
+    entry->chain = cache->buckets[hash(puzzle) & cache->mask];
+    cache->buckets[hash(puzzle) & cache->mask] = ee;
+    link_newest(cache, ee);
+  }
+
+  memcpy(entry->solution, solution, PACKED_SIZE);
+  entry->solutions = solutions;
+  entry->limit = limit;
+  return;
+}
+
+/*****************************************************************************/
+/* The index of the entry for a puzzle, or -1 if there isn't one.            */
+/*****************************************************************************/
+static long find(const sudoku_cache_t *cache, const unsigned char *puzzle)
+{
+  long ee;
+
+  for (ee=cache->buckets[hash(puzzle) & cache->mask];
+       (ee >= 0) &&
+       (memcmp(cache->entries[ee].puzzle, puzzle, PACKED_SIZE) != 0);
+       ee=cache->entries[ee].chain)
+  {
+  }
+  return (ee);
+}
+
+/*****************************************************************************/
+/* FNV-1a hash of a packed puzzle.                                           */
+/*****************************************************************************/
+static unsigned long hash(const unsigned char *puzzle)
+{
+  unsigned long hh = 2166136261ul;
+  int ii;
+
+  for (ii=0; ii < PACKED_SIZE; ii++)
+  {
+    hh = ((hh ^ puzzle[ii]) * 16777619ul) & 0xfffffffful;
+  }
+  return (hh);
+}
+
+/*****************************************************************************/
+/* Takes an entry out of the list by use, and puts it back at the front.     */
+/*****************************************************************************/
+static void unlink_entry(sudoku_cache_t *cache, long ee)
+{
+  struct entry *entry = &cache->entries[ee];
+
+  if (entry->newer >= 0)
+  {
+    cache->entries[entry->newer].older = entry->older;
+  }
+  else
+  {
+    cache->newest = entry->older;
+  }
+
+  if (entry->older >= 0)
+  {
+    cache->entries[entry->older].newer = entry->newer;
+  }
+  else
+  {
+    cache->oldest = entry->newer;
+  }
+  return;
+}
+
+static void link_newest(sudoku_cache_t *cache, long ee)
+{
+  struct entry *entry = &cache->entries[ee];
+
+  entry->newer = -1;
+  entry->older = cache->newest;
+
+  if (cache->newest >= 0)
+  {
+    cache->entries[cache->newest].newer = ee;
+  }
+  else
+  {
+    cache->oldest = ee;
+  }
+  cache->newest = ee;
+  return;
+}
+
+/*****************************************************************************/
+/* Packing grids two entries to a byte, and unpacking them.                  */
+/*****************************************************************************/
+static void pack(const int *values, unsigned char *packed)
+{
+  int ii;
+
+  for (ii=0; ii + 1 < SUDOKU_CELLS; ii += 2)
+  {
+    packed[ii / 2] = (unsigned char)(values[ii] | (values[ii+1] << 4));
+  }
+  if (ii < SUDOKU_CELLS)
+  {
+    packed[ii / 2] = (unsigned char)values[ii];
+  }
+  return;
+}
+
+static void unpack(const unsigned char *packed, int *values)
+{
+  int ii;
+
+  for (ii=0; ii < SUDOKU_CELLS; ii++)
+  {
+    values[ii] = (packed[ii / 2] >> (4 * (ii % 2))) & 0xf;
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Checks an exported record: the counts make sense, and the solution is a   */
+/* solution of the puzzle, or all unknown if there isn't one.                */
+/*****************************************************************************/
+static int valid_record(const unsigned char *record)
+{
+  int puzzle[SUDOKU_CELLS];
+  int solution[SUDOKU_CELLS];
+  unsigned int seen[3 * SIZE];
+  long solutions = get_count(record + (2 * PACKED_SIZE));
+  long limit = get_count(record + (2 * PACKED_SIZE) + 4);
+  int ii;
+  unsigned int bit;
+
+  unpack(record, puzzle);
+  unpack(record + PACKED_SIZE, solution);
+  memset(seen, 0, sizeof(seen));
+
+  if ((limit < 1) ||
+      (solutions < 0) ||
+      (solutions > limit))
+  {
+    return (FALSE);
+  }
+
+  for (ii=0; ii < SUDOKU_CELLS; ii++)
+  {
+    if ((puzzle[ii] > SIZE) ||
+        ((solutions == 0) && (solution[ii] != 0)) ||
+        ((solutions > 0) &&
+         ((solution[ii] < 1) ||
+          (solution[ii] > SIZE) ||
+          ((puzzle[ii] != 0) && (puzzle[ii] != solution[ii])))))
+    {
+      return (FALSE);
+    }
+
+    if (solutions > 0)
+    {
+      /***********************************************************************/
+      /* No value twice in a row, column or block.                           */
+      /***********************************************************************/
+      bit = 1u << solution[ii];
+
+      if ((seen[ii / SIZE] & bit) ||
+          (seen[SIZE + (ii % SIZE)] & bit) ||
+          (seen[(2 * SIZE) +
+                (((ii / SIZE) / BLOCK_SIZE) * BLOCK_SIZE) +
+                ((ii % SIZE) / BLOCK_SIZE)] & bit))
+      {
+        return (FALSE);
+      }
+      seen[ii / SIZE] |= bit;
+      seen[SIZE + (ii % SIZE)] |= bit;
+      seen[(2 * SIZE) +
+           (((ii / SIZE) / BLOCK_SIZE) * BLOCK_SIZE) +
+           ((ii % SIZE) / BLOCK_SIZE)] |= bit;
+    }
+  }
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Counts as 4 bytes, least significant first.                               */
+/*****************************************************************************/
+static void put_count(unsigned char *pos, long count)
+{
+  int ii;
+
+  for (ii=0; ii < 4; ii++)
+  {
+    pos[ii] = (unsigned char)(((unsigned long)count >> (8 * ii)) & 0xff);
+  }
+  return;
+}
+
+static long get_count(const unsigned char *pos)
+{
+  unsigned long count = 0;
+  int ii;
+
+  for (ii=0; ii < 4; ii++)
+  {
+    count |= (unsigned long)pos[ii] << (8 * ii);
+  }
+  return ((count > (unsigned long)MAX_COUNT) ? -1 : (long)count);
+}
@@ -0,0 +1,25 @@
+/*****************************************************************************/
+/* Result cache, used by the library to look up puzzles it has seen before.  */
+/* The public parts are in sudoku.h; these are the ones the solver uses.     */
+/*                                                                           */
+/* Entries are keyed by the puzzle's canonical form (see canon.h) and hold   */
+/* the canonical form's solution, so one entry answers for every puzzle that */
+/* can be turned into the same one.  The cache holds up to a fixed number,   */
+/* throwing away the least recently used when it's full.  It may be shared   */
+/* by any number of contexts, on any threads: it's guarded by a lock.        */
+/*****************************************************************************/
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "sudoku.h"
+
+/*****************************************************************************/
+/* cache_find() looks for a canonical puzzle, solved looking for up to limit */
+/* solutions.  Returns 1, with the number found and the first solution (if   */
+/* any), if the entry there says how many there are.  cache_keep() keeps the */
+/* result of solving a canonical puzzle looking for up to limit solutions.   */
+/*****************************************************************************/
+int cache_find(sudoku_cache_t *, const int *, long, int *, long *);
+void cache_keep(sudoku_cache_t *, const int *, const int *, long, long);
+
+#endif
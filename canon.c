@@ -0,0 +1,460 @@
+/*****************************************************************************/
+/* Canonical forms of puzzles.  See canon.h.                                 */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include "canon.h"
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define SIZE SUDOKU_SIZE
+#define BLOCK_SIZE 3
+#define TRUE 1
+#define FALSE 0
+
+/*****************************************************************************/
+/* Tied columns to start with: each stack's three.                           */
+/*****************************************************************************/
+#define TIED_STACKS 0x1b6
+
+/*****************************************************************************/
+/* The orders three things can go in.  The first num_orders[N] of them are   */
+/* the orders of the first N, leaving the rest where they are.               */
+/*****************************************************************************/
+static const unsigned char orders[6][BLOCK_SIZE] =
+{
+  {0, 1, 2}, {1, 0, 2}, {0, 2, 1}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+};
+static const int num_orders[BLOCK_SIZE + 1] = {1, 1, 2, 6};
+
+/*****************************************************************************/
+/* A group of tied columns as the next row sorts it: the columns with        */
+/* unknown entries, then those with values already labelled, by label, then  */
+/* those with new values.                                                    */
+/*****************************************************************************/
+struct group
+{
+  int end;
+  int num_unknown;
+  int num_old;
+  int num_new;
+  unsigned char cols[BLOCK_SIZE];
+};
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+static long place_row(const unsigned char *,
+                      const struct canon_state *,
+                      int,
+                      int,
+                      unsigned char *,
+                      int *,
+                      struct canon_state *,
+                      long);
+static long add_orders(const unsigned char *,
+                       struct canon_state *,
+                       unsigned short,
+                       int,
+                       struct canon_state *,
+                       long);
+static void sort_group(const unsigned char *,
+                       const struct canon_state *,
+                       unsigned short,
+                       int,
+                       struct group *);
+
+int canon_form(struct canon_work *work,
+               const int *values,
+               int *canonical,
+               struct canon *transform)
+{
+  unsigned char grid[2][SUDOKU_CELLS];
+  unsigned char best[SIZE];
+  int counts[BLOCK_SIZE];
+  struct canon_state seed;
+  struct canon_state *from = work->states[0];
+  struct canon_state *to = work->states[1];
+  struct canon_state *swap;
+  const struct canon_state *state;
+  int have_best = FALSE;
+  long num = 0;
+  long num_from;
+  long ss;
+  int level;
+  int band;
+  int tt;
+  int rr;
+  int ii;
+  int jj;
+
+  /***************************************************************************/
+  /* The puzzle both ways round, to save working out where entries are.      */
+  /***************************************************************************/
+  for (ii=0; ii < SUDOKU_CELLS; ii++)
+  {
+    grid[0][ii] = (unsigned char)values[ii];
+    grid[1][((ii % SIZE) * SIZE) + (ii / SIZE)] = (unsigned char)values[ii];
+  }
+
+  /***************************************************************************/
+  /* The first row can be any row.  The smallest it can be has its stacks in */
+  /* order of how many clues they have, so only those orders are tried.      */
+  /***************************************************************************/
+  for (tt=0; (tt < 2) && (num >= 0); tt++)
+  {
+    for (rr=0; (rr < SIZE) && (num >= 0); rr++)
+    {
+      for (ii=0; ii < BLOCK_SIZE; ii++)
+      {
+        counts[ii] = 0;
+        for (jj=0; jj < BLOCK_SIZE; jj++)
+        {
+          counts[ii] += (grid[tt][(rr * SIZE) + (ii * BLOCK_SIZE) + jj] != 0);
+        }
+      }
+
+      for (ii=0; (ii < 6) && (num >= 0); ii++)
+      {
+        if ((counts[orders[ii][0]] > counts[orders[ii][1]]) ||
+            (counts[orders[ii][1]] > counts[orders[ii][2]]))
+        {
+          continue;
+        }
+
+        memset(&seed, 0, sizeof(seed));
+        seed.transposed = (unsigned char)tt;
+        seed.tied = TIED_STACKS;
+
+        for (jj=0; jj < SIZE; jj++)
+        {
+          seed.cols[jj] = (unsigned char)
+            ((orders[ii][jj / BLOCK_SIZE] * BLOCK_SIZE) + (jj % BLOCK_SIZE));
+        }
+        num = place_row(grid[tt], &seed, 0, rr, best, &have_best, to, num);
+      }
+    }
+  }
+
+  /***************************************************************************/
+  /* Then each row in turn.  The rows of a band stay together, so the first  */
+  /* row of a band can come from any band not used yet, and the others from  */
+  /* the same band.                                                          */
+  /***************************************************************************/
+  for (level=1; (level < SIZE) && (num > 0); level++)
+  {
+    for (jj=0; jj < SIZE; jj++)
+    {
+      canonical[((level - 1) * SIZE) + jj] = best[jj];
+    }
+
+    swap = from;
+    from = to;
+    to = swap;
+    num_from = num;
+    num = 0;
+    have_best = FALSE;
+
+    for (ss=0; (ss < num_from) && (num >= 0); ss++)
+    {
+      state = &from[ss];
+      band = state->rows[level-1] / BLOCK_SIZE;
+
+      for (rr=0; (rr < SIZE) && (num >= 0); rr++)
+      {
+        if (((state->used_rows >> rr) & 1) ||
+            (((level % BLOCK_SIZE) == 0) ?
+             ((state->used_rows & (7 << (rr - (rr % BLOCK_SIZE)))) != 0) :
+             ((rr / BLOCK_SIZE) != band)))
+        {
+          continue;
+        }
+
+        num = place_row(grid[state->transposed],
+                        state,
+                        level,
+                        rr,
+                        best,
+                        &have_best,
+                        to,
+                        num);
+      }
+    }
+  }
+
+  if (num <= 0)
+  {
+    return (FALSE);
+  }
+
+  for (jj=0; jj < SIZE; jj++)
+  {
+    canonical[((SIZE - 1) * SIZE) + jj] = best[jj];
+  }
+
+  /***************************************************************************/
+  /* Any of the ways left will do.  Values the puzzle doesn't have take the  */
+  /* labels left over, in order.                                             */
+  /***************************************************************************/
+  state = &to[0];
+
+  for (ii=0; ii < SIZE; ii++)
+  {
+    for (jj=0; jj < SIZE; jj++)
+    {
+      transform->cell[(ii * SIZE) + jj] = (unsigned char)
+        (state->transposed ? ((state->cols[jj] * SIZE) + state->rows[ii]) :
+                             ((state->rows[ii] * SIZE) + state->cols[jj]));
+    }
+  }
+
+  memcpy(transform->label, state->label, sizeof(transform->label));
+  jj = state->next_label;
+
+  for (ii=1; ii <= SIZE; ii++)
+  {
+    if (transform->label[ii] == 0)
+    {
+      transform->label[ii] = (unsigned char)++jj;
+    }
+  }
+  return (TRUE);
+}
+
+void canon_map(const struct canon *transform,
+               const int *values,
+               int *canonical)
+{
+  int nn;
+
+  for (nn=0; nn < SUDOKU_CELLS; nn++)
+  {
+    canonical[nn] = transform->label[values[transform->cell[nn]]];
+  }
+  return;
+}
+
+void canon_unmap(const struct canon *transform,
+                 const int *canonical,
+                 int *values)
+{
+  int value[SIZE + 1];
+  int nn;
+
+  for (nn=0; nn <= SIZE; nn++)
+  {
+    value[transform->label[nn]] = nn;
+  }
+
+  for (nn=0; nn < SUDOKU_CELLS; nn++)
+  {
+    values[transform->cell[nn]] = value[canonical[nn]];
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Tries row rr of the grid as the row at the given level after a state.  If */
+/* it comes out no bigger than the best row so far, adds the states for each */
+/* way of getting it to those in to[], first throwing those away if it's     */
+/* smaller.  Returns the new number of states, or -1 if there are too many.  */
+/*****************************************************************************/
+static long place_row(const unsigned char *grid,
+                      const struct canon_state *state,
+                      int level,
+                      int rr,
+                      unsigned char *best,
+                      int *have_best,
+                      struct canon_state *to,
+                      long num)
+{
+  struct canon_state next;
+  struct group group;
+  unsigned char row[SIZE];
+  int label = state->next_label;
+  int cmp = (*have_best == TRUE) ? 0 : -1;
+  int start;
+  int jj;
+
+  /***************************************************************************/
+  /* Sort each group of tied columns to make the row as small as it can be,  */
+  /* giving up as soon as it's bigger than the best.                         */
+  /***************************************************************************/
+  for (start=0; (start < SIZE) && (cmp <= 0); start=group.end)
+  {
+    sort_group(grid + (rr * SIZE), state, state->tied, start, &group);
+
+    for (jj=start; jj < group.end; jj++)
+    {
+      row[jj] = (unsigned char)
+        ((jj < start + group.num_unknown) ? 0 :
+         (jj < start + group.num_unknown + group.num_old) ?
+         state->label[grid[(rr * SIZE) + group.cols[jj - start]]] :
+         ++label);
+
+      if (cmp == 0)
+      {
+        cmp = (row[jj] < best[jj]) ? -1 : (row[jj] > best[jj]);
+      }
+    }
+  }
+
+  if (cmp > 0)
+  {
+    return (num);
+  }
+
+  if (cmp < 0)
+  {
+    memcpy(best, row, SIZE);
+    *have_best = TRUE;
+    num = 0;
+  }
+
+  memcpy(&next, state, sizeof(next));
+  next.rows[level] = (unsigned char)rr;
+  next.used_rows |= (unsigned short)(1 << rr);
+
+  return (add_orders(grid + (rr * SIZE), &next, state->tied, 0, to, num));
+}
+
+/*****************************************************************************/
+/* Adds a state for each way of sorting the groups of tied columns from the  */
+/* one starting at start onwards, for the new row, whose entries are in      */
+/* row[].  The columns with new values can go in any order, and each order   */
+/* labels them differently, so each is a separate state.  Those with unknown */
+/* entries stay tied.  Returns the new number of states, or -1 if there are  */
+/* too many.                                                                 */
+/*****************************************************************************/
+static long add_orders(const unsigned char *row,
+                       struct canon_state *state,
+                       unsigned short tied,
+                       int start,
+                       struct canon_state *to,
+                       long num)
+{
+  struct group group;
+  int fixed;
+  int ii;
+  int jj;
+
+  if (start == SIZE)
+  {
+    if (num == CANON_STATES)
+    {
+      return (-1);
+    }
+
+    memcpy(&to[num], state, sizeof(*state));
+    return (num + 1);
+  }
+
+  sort_group(row, state, tied, start, &group);
+  fixed = group.num_unknown + group.num_old;
+
+  for (jj=start; jj < group.end; jj++)
+  {
+    state->tied &= (unsigned short)~(1 << jj);
+
+    if ((jj > start) &&
+        (jj < start + group.num_unknown))
+    {
+      state->tied |= (unsigned short)(1 << jj);
+    }
+  }
+
+  for (jj=0; jj < fixed; jj++)
+  {
+    state->cols[start + jj] = group.cols[jj];
+  }
+
+  for (ii=0; (ii < num_orders[group.num_new]) && (num >= 0); ii++)
+  {
+    for (jj=0; jj < group.num_new; jj++)
+    {
+      state->cols[start + fixed + jj] = group.cols[fixed + orders[ii][jj]];
+      state->label[row[state->cols[start + fixed + jj]]] =
+        ++state->next_label;
+    }
+
+    num = add_orders(row, state, tied, group.end, to, num);
+
+    for (jj=0; jj < group.num_new; jj++)
+    {
+      state->label[row[state->cols[start + fixed + jj]]] = 0;
+    }
+    state->next_label = (unsigned char)(state->next_label - group.num_new);
+  }
+  return (num);
+}
+
+/*****************************************************************************/
+/* Sorts the group of tied columns starting at start (as tied says) for the  */
+/* new row, whose entries are in row[].                                      */
+/*****************************************************************************/
+static void sort_group(const unsigned char *row,
+                       const struct canon_state *state,
+                       unsigned short tied,
+                       int start,
+                       struct group *group)
+{
+  unsigned char col;
+  int ii;
+  int jj;
+  int pos = 0;
+
+  for (group->end=start+1;
+       (group->end < SIZE) && ((tied >> group->end) & 1);
+       group->end++)
+  {
+  }
+
+  /***************************************************************************/
+  /* Unknown entries first, then the old values by label, then the new.      */
+  /***************************************************************************/
+  for (ii=start; ii < group->end; ii++)
+  {
+    if (row[state->cols[ii]] == 0)
+    {
+      group->cols[pos++] = state->cols[ii];
+    }
+  }
+  group->num_unknown = pos;
+
+  for (ii=start; ii < group->end; ii++)
+  {
+    col = state->cols[ii];
+
+    if ((row[col] != 0) &&
+        (state->label[row[col]] != 0))
+    {
+      for (jj=pos;
+           (jj > group->num_unknown) &&
+           (state->label[row[group->cols[jj-1]]] > state->label[row[col]]);
+           jj--)
+      {
+        group->cols[jj] = group->cols[jj-1];
+      }
+      group->cols[jj] = col;
+      pos++;
+    }
+  }
+  group->num_old = pos - group->num_unknown;
+
+  for (ii=start; ii < group->end; ii++)
+  {
+    col = state->cols[ii];
+
+    if ((row[col] != 0) &&
+        (state->label[row[col]] == 0))
+    {
+      group->cols[pos++] = col;
+    }
+  }
+  group->num_new = pos - group->num_unknown - group->num_old;
+  return;
+}
@@ -0,0 +1,73 @@
+/*****************************************************************************/
+/* Canonical forms of puzzles, used by the library's result cache.  Not part */
+/* of the public interface.                                                  */
+/*                                                                           */
+/* Relabelling the values, permuting the rows within a band, the bands, the  */
+/* columns within a stack and the stacks, and transposing, all turn a puzzle */
+/* into another that is solved the same way.  The canonical form of a puzzle */
+/* is the one of all those it can be turned into that comes first, reading   */
+/* its entries row by row with 0 for unknown, so two puzzles have the same   */
+/* canonical form exactly when one can be turned into the other.             */
+/*                                                                           */
+/* The search for it goes a row at a time, keeping only the ways of getting  */
+/* the smallest rows so far.  Puzzles with hardly any clues tie in too many  */
+/* ways to keep track of, and get no canonical form.                         */
+/*****************************************************************************/
+#ifndef CANON_H
+#define CANON_H
+
+#include "sudoku.h"
+
+/*****************************************************************************/
+/* Most ways of getting the smallest rows kept at once.                      */
+/*****************************************************************************/
+#define CANON_STATES 2048
+
+/*****************************************************************************/
+/* A transformation: entry N of the canonical form comes from entry          */
+/* cell[N] of the puzzle, and value V of the puzzle is label[V] in it.       */
+/*****************************************************************************/
+struct canon
+{
+  unsigned char cell[SUDOKU_CELLS];
+  unsigned char label[SUDOKU_SIZE + 1];
+};
+
+/*****************************************************************************/
+/* One way of getting the smallest rows so far: whether the puzzle was       */
+/* transposed, the rows picked so far and the order of the columns, the      */
+/* labels given to the values seen so far and the next label to give.        */
+/*                                                                           */
+/* Columns of a stack that the rows so far don't tell apart are left tied,   */
+/* and only put in order once a row does: bit N of tied is set if column N   */
+/* is tied with column N-1.                                                  */
+/*****************************************************************************/
+struct canon_state
+{
+  unsigned char transposed;
+  unsigned char next_label;
+  unsigned short used_rows;
+  unsigned short tied;
+  unsigned char rows[SUDOKU_SIZE];
+  unsigned char cols[SUDOKU_SIZE];
+  unsigned char label[SUDOKU_SIZE + 1];
+};
+
+/*****************************************************************************/
+/* Room for the search, two levels of states.                                */
+/*****************************************************************************/
+struct canon_work
+{
+  struct canon_state states[2][CANON_STATES];
+};
+
+/*****************************************************************************/
+/* canon_form() finds a puzzle's canonical form and the transformation that  */
+/* gives it, returning 0 if it can't.  canon_map() applies a transformation  */
+/* to a grid, and canon_unmap() undoes it.                                   */
+/*****************************************************************************/
+int canon_form(struct canon_work *, const int *, int *, struct canon *);
+void canon_map(const struct canon *, const int *, int *);
+void canon_unmap(const struct canon *, const int *, int *);
+
+#endif
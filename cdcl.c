@@ -0,0 +1,1067 @@
+/*****************************************************************************/
+/* Conflict-driven search with nogood learning.  See cdcl.h.                 */
+/*                                                                           */
+/* Add #define DEBUG for debug build.                                        */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "cdcl.h"
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define SIZE SUDOKU_SIZE
+#define TRUE 1
+#define FALSE 0
+#define NONE (-1)
+
+/*****************************************************************************/
+/* Assert macro.                                                             */
+/*****************************************************************************/
+#ifdef DEBUG
+#define ASSERT(X) assert(X)
+#else
+#define ASSERT(X)
+#endif
+
+/*****************************************************************************/
+/* With a time limit, the clock is only read once every this many search     */
+/* nodes.                                                                    */
+/*****************************************************************************/
+#define CLOCK_INTERVAL 64
+
+/*****************************************************************************/
+/* Statement S says entry S / SIZE holds value (S % SIZE) + 1.  Literal 2S   */
+/* says it's true and 2S + 1 that it's false.  A statement's value is TRUE,  */
+/* FALSE or UNSET, and so is a literal's.                                    */
+/*****************************************************************************/
+#define STATEMENT(N,V) (((N) * SIZE) + (V))
+#define HOLDS(S) (2 * (S))
+#define LACKS(S) ((2 * (S)) + 1)
+#define LIT_STATEMENT(L) ((L) >> 1)
+#define NOT(L) ((L) ^ 1)
+#define UNSET 2
+#define LIT_VALUE(C,L) \
+  (((C)->value[LIT_STATEMENT(L)] == UNSET) ? UNSET : \
+   ((C)->value[LIT_STATEMENT(L)] ^ ((L) & 1)))
+
+/*****************************************************************************/
+/* Why a literal was made true.  NO_REASON is a guess or a given value.      */
+/* Otherwise it's one of these, with a number saying which:                  */
+/*                                                                           */
+/*   BY_LITERAL  a literal made true (the number), saying an entry holds a   */
+/*               value, so it holds no other and its peers don't hold that   */
+/*   BY_ENTRY    an entry (row * SIZE + column) with no other value left     */
+/*   BY_UNIT     a value with no other place left in a unit (unit * SIZE +   */
+/*               value - 1)                                                  */
+/*   BY_NOGOOD   a nogood with every other literal false                     */
+/*                                                                           */
+/* The reason is the same as a set of literals, all false but the one it     */
+/* made true; see reason_literals().                                         */
+/*****************************************************************************/
+#define NO_REASON (-1)
+#define BY_LITERAL 0
+#define BY_ENTRY 1
+#define BY_UNIT 2
+#define BY_NOGOOD 3
+#define REASON(K,D) (((D) << 2) | (K))
+#define REASON_KIND(R) ((R) & 3)
+#define REASON_DATA(R) ((R) >> 2)
+
+/*****************************************************************************/
+/* Nogoods spanning this many levels of guessing or fewer are never          */
+/* forgotten.                                                                */
+/*****************************************************************************/
+#define GLUE_SPAN 2
+
+/*****************************************************************************/
+/* How recently each entry has been in a contradiction is halved every this  */
+/* many contradictions.                                                      */
+/*****************************************************************************/
+#define DECAY_INTERVAL 256
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+static int propagate(struct cdcl *, const struct units *);
+static int at_least_one(struct cdcl *, const struct units *, int);
+static int watch_nogoods(struct cdcl *, const struct units *, int);
+static int imply(struct cdcl *, const struct units *, int, int);
+static int reason_literals(const struct cdcl *,
+                           const struct units *,
+                           int,
+                           int,
+                           short *);
+static int learn(struct cdcl *, const struct units *, int *, int *);
+static int redundant(struct cdcl *, const struct units *, int);
+static int assert_nogood(struct cdcl *,
+                         const struct units *,
+                         int,
+                         int,
+                         int);
+static int flip(struct cdcl *, const struct units *);
+static int flipped_level(const struct cdcl *);
+static void backjump(struct cdcl *, int);
+static int add_nogood(struct cdcl *, int, int);
+static void forget(struct cdcl *, int);
+static int pick(const struct cdcl *);
+static int over_budget(struct cdcl *);
+static double now_seconds(void);
+
+/*****************************************************************************/
+/* Solves a puzzle.  The givens are assigned before any guessing, at level   */
+/* 0, and so is anything that follows from them alone, which is never        */
+/* undone: if that runs into a contradiction there are no (more) solutions.  */
+/*****************************************************************************/
+long cdcl_solve(struct cdcl *cdcl,
+                const struct units *units,
+                const int *values,
+                int *solution,
+                long limit)
+{
+  int nn;
+  int vv;
+  int ll;
+  int statement;
+  int size;
+  int jump;
+  int span;
+  int floor;
+
+  memset(cdcl->value, UNSET, sizeof(cdcl->value));
+  memset(cdcl->seen, FALSE, sizeof(cdcl->seen));
+  memset(cdcl->level_seen, FALSE, sizeof(cdcl->level_seen));
+  memset(cdcl->activity, 0, sizeof(cdcl->activity));
+
+  for (ll=0; ll < CDCL_LITS; ll++)
+  {
+    cdcl->watch[ll] = NONE;
+  }
+
+  cdcl->num_nogoods = 0;
+  cdcl->pool_used = 0;
+  cdcl->trail_top = 0;
+  cdcl->queue_head = 0;
+  cdcl->cur_level = 0;
+  cdcl->level_start[0] = 0;
+  cdcl->max_depth = 0;
+  cdcl->num_solutions = 0;
+  cdcl->limit = limit;
+  cdcl->guesses = 0;
+  cdcl->backtracks = 0;
+  cdcl->backjumps = 0;
+  cdcl->nogoods = 0;
+  cdcl->forgotten = 0;
+  cdcl->nodes = 0;
+  cdcl->exceeded = FALSE;
+
+  for (nn=0; nn < SUDOKU_CELLS; nn++)
+  {
+    if ((values[nn] != 0) &&
+        (imply(cdcl,
+               units,
+               HOLDS(STATEMENT(nn, values[nn] - 1)),
+               NO_REASON) == FALSE))
+    {
+      goto EXIT;
+    }
+  }
+
+  if (over_budget(cdcl) == TRUE)
+  {
+    goto EXIT;
+  }
+
+  for (;;)
+  {
+    if (propagate(cdcl, units) == FALSE)
+    {
+      /***********************************************************************/
+      /* A contradiction.  Unless it follows from the givens, learn a        */
+      /* nogood from it and jump back to where that forces something new.    */
+      /***********************************************************************/
+      if (cdcl->cur_level == 0)
+      {
+        break;
+      }
+      cdcl->backtracks++;
+
+      if ((cdcl->backtracks % DECAY_INTERVAL) == 0)
+      {
+        for (nn=0; nn < SUDOKU_CELLS; nn++)
+        {
+          cdcl->activity[nn] /= 2;
+        }
+      }
+
+      /***********************************************************************/
+      /* Everything under a level that is the other way of a guess has been  */
+      /* tried once that level runs into a contradiction, and jumping back   */
+      /* past such a level would try it again.                               */
+      /***********************************************************************/
+      floor = flipped_level(cdcl);
+
+      if (floor == cdcl->cur_level)
+      {
+        if (flip(cdcl, units) == FALSE)
+        {
+          break;
+        }
+        continue;
+      }
+
+      size = learn(cdcl, units, &jump, &span);
+
+      if (jump < floor)
+      {
+        jump = floor;
+
+        if (size == 1)
+        {
+          cdcl->learned[size++] =
+            (short)NOT(cdcl->trail[cdcl->level_start[floor]]);
+        }
+      }
+      cdcl->backjumps += cdcl->cur_level - 1 - jump;
+      cdcl->nogoods++;
+
+      if (assert_nogood(cdcl, units, size, jump, span) == FALSE)
+      {
+        break;
+      }
+      continue;
+    }
+
+    statement = pick(cdcl);
+
+    if (statement == NONE)
+    {
+      /***********************************************************************/
+      /* Every entry holds a value: a solution.  Unless that's as many as    */
+      /* we're looking for, carry on with the other way of the latest guess. */
+      /***********************************************************************/
+      if (cdcl->num_solutions == 0)
+      {
+        for (nn=0; nn < SUDOKU_CELLS; nn++)
+        {
+          for (vv=0; cdcl->value[STATEMENT(nn, vv)] != TRUE; vv++)
+          {
+          }
+          solution[nn] = vv + 1;
+        }
+      }
+      cdcl->num_solutions++;
+
+      if (cdcl->num_solutions >= cdcl->limit)
+      {
+        break;
+      }
+      cdcl->backtracks++;
+
+      if (flip(cdcl, units) == FALSE)
+      {
+        break;
+      }
+      continue;
+    }
+
+    /*************************************************************************/
+    /* Guess, at a new level.                                                */
+    /*************************************************************************/
+    if (over_budget(cdcl) == TRUE)
+    {
+      break;
+    }
+
+    ASSERT(cdcl->cur_level < SUDOKU_CELLS);
+    cdcl->cur_level++;
+    cdcl->level_start[cdcl->cur_level] = cdcl->trail_top;
+    cdcl->flipped[cdcl->cur_level] = FALSE;
+    cdcl->guesses++;
+
+    if (cdcl->max_depth < cdcl->cur_level)
+    {
+      cdcl->max_depth = cdcl->cur_level;
+    }
+    (void)imply(cdcl, units, HOLDS(statement), NO_REASON);
+  }
+
+EXIT:
+
+  return (cdcl->num_solutions);
+}
+
+/*****************************************************************************/
+/* Works through the literals made true since last time, making true         */
+/* whatever they force.  Returns FALSE at the first contradiction, with the  */
+/* literals that make it in conflict[], all false.                           */
+/*****************************************************************************/
+static int propagate(struct cdcl *cdcl, const struct units *units)
+{
+  int lit;
+  int nn;
+  int value;
+  int vv;
+  int kk;
+
+  while (cdcl->queue_head < cdcl->trail_top)
+  {
+    lit = cdcl->trail[cdcl->queue_head++];
+    nn = LIT_STATEMENT(lit) / SIZE;
+    value = LIT_STATEMENT(lit) % SIZE;
+
+    if (lit == HOLDS(LIT_STATEMENT(lit)))
+    {
+      /***********************************************************************/
+      /* The entry holds the value, so it holds no other, and its peers      */
+      /* don't hold this one.                                                */
+      /***********************************************************************/
+      for (vv=0; vv < SIZE; vv++)
+      {
+        if ((vv != value) &&
+            (imply(cdcl,
+                   units,
+                   LACKS(STATEMENT(nn, vv)),
+                   REASON(BY_LITERAL, lit)) == FALSE))
+        {
+          return (FALSE);
+        }
+      }
+
+      for (kk=0; kk < units->num_peers[nn]; kk++)
+      {
+        if (imply(cdcl,
+                  units,
+                  LACKS(STATEMENT(units->peers[nn][kk], value)),
+                  REASON(BY_LITERAL, lit)) == FALSE)
+        {
+          return (FALSE);
+        }
+      }
+    }
+    else
+    {
+      /***********************************************************************/
+      /* The entry doesn't hold the value, which may leave it only one, or   */
+      /* leave the value only one place in one of its units.                 */
+      /***********************************************************************/
+      if (at_least_one(cdcl, units, REASON(BY_ENTRY, nn)) == FALSE)
+      {
+        return (FALSE);
+      }
+
+      for (kk=0; kk < units->num_of[nn]; kk++)
+      {
+        if (at_least_one(cdcl,
+                         units,
+                         REASON(BY_UNIT,
+                                (units->of[nn][kk] * SIZE) + value)) == FALSE)
+        {
+          return (FALSE);
+        }
+      }
+    }
+
+    if (watch_nogoods(cdcl, units, NOT(lit)) == FALSE)
+    {
+      return (FALSE);
+    }
+  }
+
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Checks that one of the values of an entry, or one of the places for a     */
+/* value in a unit, given as a reason, is still open, and makes it true if   */
+/* it's the only one.                                                        */
+/*****************************************************************************/
+static int at_least_one(struct cdcl *cdcl,
+                        const struct units *units,
+                        int reason)
+{
+  int count;
+  int open = NONE;
+  int kk;
+
+  count = reason_literals(cdcl, units, reason, NONE, cdcl->conflict);
+
+  for (kk=0; kk < count; kk++)
+  {
+    switch (LIT_VALUE(cdcl, cdcl->conflict[kk]))
+    {
+      case TRUE:
+        return (TRUE);
+
+      case UNSET:
+        if (open != NONE)
+        {
+          return (TRUE);
+        }
+        open = cdcl->conflict[kk];
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if (open == NONE)
+  {
+    cdcl->conflict_size = count;
+    return (FALSE);
+  }
+
+  return (imply(cdcl, units, open, reason));
+}
+
+/*****************************************************************************/
+/* Visits the nogoods watching a literal that has just become false.  Each   */
+/* watches another literal instead if it has one that isn't false, or if     */
+/* not, makes its other watched literal true.                                */
+/*****************************************************************************/
+static int watch_nogoods(struct cdcl *cdcl,
+                         const struct units *units,
+                         int lit)
+{
+  int *link = &cdcl->watch[lit];
+  int nogood;
+  int side;
+  int other;
+  int kk;
+  short *lits;
+
+  while ((nogood = *link) != NONE)
+  {
+    lits = &cdcl->pool[cdcl->start[nogood]];
+    side = (lits[0] == lit) ? 0 : 1;
+    other = lits[1 - side];
+
+    if (LIT_VALUE(cdcl, other) != TRUE)
+    {
+      for (kk=2;
+           (kk < cdcl->size[nogood]) && (LIT_VALUE(cdcl, lits[kk]) == FALSE);
+           kk++)
+      {
+      }
+
+      if (kk < cdcl->size[nogood])
+      {
+        /*********************************************************************/
+        /* Move the watch, taking the nogood off this literal's list.        */
+        /*********************************************************************/
+        lits[side] = lits[kk];
+        lits[kk] = (short)lit;
+        *link = cdcl->next[nogood][side];
+        cdcl->next[nogood][side] = cdcl->watch[lits[side]];
+        cdcl->watch[lits[side]] = nogood;
+        continue;
+      }
+
+      if (imply(cdcl, units, other, REASON(BY_NOGOOD, nogood)) == FALSE)
+      {
+        return (FALSE);
+      }
+    }
+    link = &cdcl->next[nogood][side];
+  }
+
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Makes a literal true, at the current level, for the given reason.  If     */
+/* it's already false that's a contradiction: returns FALSE with the         */
+/* reason's literals in conflict[].                                          */
+/*****************************************************************************/
+static int imply(struct cdcl *cdcl,
+                 const struct units *units,
+                 int lit,
+                 int reason)
+{
+  int statement = LIT_STATEMENT(lit);
+
+  switch (LIT_VALUE(cdcl, lit))
+  {
+    case TRUE:
+      return (TRUE);
+
+    case FALSE:
+      cdcl->conflict_size = (reason == NO_REASON) ? 0 :
+        reason_literals(cdcl, units, reason, lit, cdcl->conflict);
+      return (FALSE);
+
+    default:
+      break;
+  }
+
+  cdcl->value[statement] = (unsigned char)((lit == HOLDS(statement)) ?
+                                           TRUE : FALSE);
+  cdcl->level[statement] = (short)cdcl->cur_level;
+  cdcl->reason[statement] = reason;
+  cdcl->trail[cdcl->trail_top++] = (short)lit;
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Lists a reason's literals, returning how many.  For BY_LITERAL, lit is    */
+/* the literal it made true.                                                 */
+/*****************************************************************************/
+static int reason_literals(const struct cdcl *cdcl,
+                           const struct units *units,
+                           int reason,
+                           int lit,
+                           short *lits)
+{
+  int data = REASON_DATA(reason);
+  int kk;
+
+  ASSERT(reason != NO_REASON);
+
+  switch (REASON_KIND(reason))
+  {
+    case BY_LITERAL:
+      lits[0] = (short)lit;
+      lits[1] = (short)NOT(data);
+      return (2);
+
+    case BY_ENTRY:
+      for (kk=0; kk < SIZE; kk++)
+      {
+        lits[kk] = (short)HOLDS(STATEMENT(data, kk));
+      }
+      return (SIZE);
+
+    case BY_UNIT:
+      for (kk=0; kk < SIZE; kk++)
+      {
+        lits[kk] = (short)HOLDS(STATEMENT(units->entries[data / SIZE][kk],
+                                          data % SIZE));
+      }
+      return (SIZE);
+
+    default:
+      memcpy(lits,
+             &cdcl->pool[cdcl->start[data]],
+             cdcl->size[data] * sizeof(lits[0]));
+      return (cdcl->size[data]);
+  }
+}
+
+/*****************************************************************************/
+/* Learns a nogood from the contradiction in conflict[].  Working back       */
+/* along the trail, each literal made true at the current level that led to  */
+/* the contradiction is replaced by the literals that forced it, until just  */
+/* one is left: the first unique implication point.  The nogood is that      */
+/* literal, made false, in learned[0], and the literals from earlier levels  */
+/* that were met on the way, less any forced by the others.  Returns its     */
+/* size, with the level to jump back to (the latest level of the others, in  */
+/* learned[1]) and the number of levels it spans.                            */
+/*****************************************************************************/
+static int learn(struct cdcl *cdcl,
+                 const struct units *units,
+                 int *jump,
+                 int *span)
+{
+  int size = 1;
+  int pending = 0;
+  int index = cdcl->trail_top - 1;
+  int count = cdcl->conflict_size;
+  int lit = NONE;
+  int statement;
+  int kk;
+  int ll;
+
+  for (;;)
+  {
+    for (kk=0; kk < count; kk++)
+    {
+      statement = LIT_STATEMENT(cdcl->conflict[kk]);
+
+      if ((cdcl->seen[statement] == FALSE) &&
+          (cdcl->level[statement] > 0) &&
+          ((lit == NONE) || (statement != LIT_STATEMENT(lit))))
+      {
+        cdcl->seen[statement] = TRUE;
+        cdcl->activity[statement / SIZE]++;
+
+        if (cdcl->level[statement] == cdcl->cur_level)
+        {
+          pending++;
+        }
+        else
+        {
+          cdcl->learned[size++] = cdcl->conflict[kk];
+        }
+      }
+    }
+
+    /*************************************************************************/
+    /* The latest literal met that hasn't been replaced yet.                 */
+    /*************************************************************************/
+    while (cdcl->seen[LIT_STATEMENT(cdcl->trail[index])] == FALSE)
+    {
+      index--;
+    }
+    lit = cdcl->trail[index--];
+    cdcl->seen[LIT_STATEMENT(lit)] = FALSE;
+
+    if (--pending == 0)
+    {
+      break;
+    }
+
+    count = reason_literals(cdcl,
+                            units,
+                            cdcl->reason[LIT_STATEMENT(lit)],
+                            lit,
+                            cdcl->conflict);
+  }
+  cdcl->learned[0] = (short)NOT(lit);
+
+  /***************************************************************************/
+  /* Move literals forced by the rest to the end, to be left out, and then   */
+  /* find the level to jump to and put the literal from it second, to be     */
+  /* watched.                                                                */
+  /***************************************************************************/
+  for (kk=1, ll=1; kk < size; kk++)
+  {
+    if (redundant(cdcl, units, cdcl->learned[kk]) == FALSE)
+    {
+      lit = cdcl->learned[ll];
+      cdcl->learned[ll++] = cdcl->learned[kk];
+      cdcl->learned[kk] = (short)lit;
+    }
+  }
+
+  for (kk=1; kk < size; kk++)
+  {
+    cdcl->seen[LIT_STATEMENT(cdcl->learned[kk])] = FALSE;
+  }
+  size = ll;
+
+  *jump = 0;
+  *span = 1;
+  cdcl->level_seen[cdcl->cur_level] = TRUE;
+
+  for (kk=1; kk < size; kk++)
+  {
+    statement = LIT_STATEMENT(cdcl->learned[kk]);
+
+    if (cdcl->level_seen[cdcl->level[statement]] == FALSE)
+    {
+      cdcl->level_seen[cdcl->level[statement]] = TRUE;
+      (*span)++;
+    }
+
+    if (cdcl->level[statement] > *jump)
+    {
+      *jump = cdcl->level[statement];
+      lit = cdcl->learned[1];
+      cdcl->learned[1] = cdcl->learned[kk];
+      cdcl->learned[kk] = (short)lit;
+    }
+  }
+
+  cdcl->level_seen[cdcl->cur_level] = FALSE;
+
+  for (kk=1; kk < size; kk++)
+  {
+    cdcl->level_seen[cdcl->level[LIT_STATEMENT(cdcl->learned[kk])]] = FALSE;
+  }
+
+  return (size);
+}
+
+/*****************************************************************************/
+/* Whether a literal of the nogood being learned can be left out, because    */
+/* the literals that forced it are all in the nogood already, or follow from */
+/* the givens.                                                               */
+/*****************************************************************************/
+static int redundant(struct cdcl *cdcl, const struct units *units, int lit)
+{
+  int reason = cdcl->reason[LIT_STATEMENT(lit)];
+  int statement;
+  int count;
+  int kk;
+
+  if (reason == NO_REASON)
+  {
+    return (FALSE);
+  }
+
+  count = reason_literals(cdcl, units, reason, NOT(lit), cdcl->conflict);
+
+  for (kk=0; kk < count; kk++)
+  {
+    statement = LIT_STATEMENT(cdcl->conflict[kk]);
+
+    if ((statement != LIT_STATEMENT(lit)) &&
+        (cdcl->seen[statement] == FALSE) &&
+        (cdcl->level[statement] > 0))
+    {
+      return (FALSE);
+    }
+  }
+
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Jumps back to a level and keeps the nogood in learned[], whose first      */
+/* literal is then the only one not false, making that true.  A nogood of    */
+/* one literal just holds from level 0 on.  Returns FALSE if there's no room */
+/* for it, which means the search has to give up.                            */
+/*****************************************************************************/
+static int assert_nogood(struct cdcl *cdcl,
+                         const struct units *units,
+                         int size,
+                         int jump,
+                         int span)
+{
+  int nogood;
+
+  backjump(cdcl, jump);
+
+  if (size == 1)
+  {
+    ASSERT(jump == 0);
+    return (imply(cdcl, units, cdcl->learned[0], NO_REASON));
+  }
+
+  nogood = add_nogood(cdcl, size, span);
+
+  if (nogood == NONE)
+  {
+    cdcl->exceeded = TRUE;
+    return (FALSE);
+  }
+
+  return (imply(cdcl, units, cdcl->learned[0], REASON(BY_NOGOOD, nogood)));
+}
+
+/*****************************************************************************/
+/* Undoes the latest guess not yet tried both ways, and everything after it, */
+/* and tries the other way, as a level of its own.  Returns FALSE if there's */
+/* no such guess, so the search is over.                                     */
+/*****************************************************************************/
+static int flip(struct cdcl *cdcl, const struct units *units)
+{
+  int level = cdcl->cur_level;
+  int lit;
+
+  while ((level > 0) &&
+         (cdcl->flipped[level] == TRUE))
+  {
+    level--;
+  }
+
+  if (level == 0)
+  {
+    return (FALSE);
+  }
+
+  lit = cdcl->trail[cdcl->level_start[level]];
+  backjump(cdcl, level - 1);
+  cdcl->cur_level = level;
+  cdcl->level_start[level] = cdcl->trail_top;
+  cdcl->flipped[level] = TRUE;
+
+  return (imply(cdcl, units, NOT(lit), NO_REASON));
+}
+
+/*****************************************************************************/
+/* The latest level that is the other way of a guess, or 0 if none is.       */
+/*****************************************************************************/
+static int flipped_level(const struct cdcl *cdcl)
+{
+  int level;
+
+  for (level=cdcl->cur_level;
+       (level > 0) && (cdcl->flipped[level] == FALSE);
+       level--)
+  {
+  }
+
+  return (level);
+}
+
+/*****************************************************************************/
+/* Undoes everything after the given level.                                  */
+/*****************************************************************************/
+static void backjump(struct cdcl *cdcl, int level)
+{
+  int kk;
+
+  for (kk=cdcl->trail_top - 1; kk >= cdcl->level_start[level + 1]; kk--)
+  {
+    cdcl->value[LIT_STATEMENT(cdcl->trail[kk])] = UNSET;
+  }
+
+  cdcl->trail_top = cdcl->level_start[level + 1];
+  cdcl->queue_head = cdcl->trail_top;
+  cdcl->cur_level = level;
+  return;
+}
+
+/*****************************************************************************/
+/* Keeps the nogood in learned[], watching its first two literals, making    */
+/* room if need be.  Returns its number, or NONE if there's no room even     */
+/* after forgetting all that can be.                                         */
+/*****************************************************************************/
+static int add_nogood(struct cdcl *cdcl, int size, int span)
+{
+  int nogood;
+  int side;
+
+  if ((cdcl->num_nogoods == CDCL_NOGOODS) ||
+      (cdcl->pool_used + size > CDCL_LITERALS))
+  {
+    forget(cdcl, FALSE);
+  }
+
+  if ((cdcl->num_nogoods == CDCL_NOGOODS) ||
+      (cdcl->pool_used + size > CDCL_LITERALS))
+  {
+    forget(cdcl, TRUE);
+  }
+
+  if ((cdcl->num_nogoods == CDCL_NOGOODS) ||
+      (cdcl->pool_used + size > CDCL_LITERALS))
+  {
+    return (NONE);
+  }
+
+  nogood = cdcl->num_nogoods++;
+  cdcl->start[nogood] = cdcl->pool_used;
+  cdcl->size[nogood] = (short)size;
+  cdcl->span[nogood] = (unsigned char)span;
+  memcpy(&cdcl->pool[cdcl->pool_used],
+         cdcl->learned,
+         size * sizeof(cdcl->learned[0]));
+  cdcl->pool_used += size;
+
+  for (side=0; side < 2; side++)
+  {
+    cdcl->next[nogood][side] = cdcl->watch[cdcl->learned[side]];
+    cdcl->watch[cdcl->learned[side]] = nogood;
+  }
+
+  return (nogood);
+}
+
+/*****************************************************************************/
+/* Forgets half of the nogoods that can go, those spanning the most levels   */
+/* first and then the oldest, and packs the rest down.  Nogoods that are the */
+/* reason for a current literal always stay, and so do those spanning        */
+/* GLUE_SPAN levels or fewer unless all is TRUE.                             */
+/*****************************************************************************/
+static void forget(struct cdcl *cdcl, int all)
+{
+  unsigned char stays[CDCL_NOGOODS];
+  int moved[CDCL_NOGOODS];
+  int spans[SUDOKU_CELLS + 2];
+  int candidates = 0;
+  int target;
+  int threshold;
+  int extra;
+  int kept = 0;
+  int used = 0;
+  int nogood;
+  int reason;
+  int side;
+  int kk;
+
+  memset(stays, FALSE, sizeof(stays));
+  memset(spans, 0, sizeof(spans));
+
+  for (kk=0; kk < cdcl->trail_top; kk++)
+  {
+    reason = cdcl->reason[LIT_STATEMENT(cdcl->trail[kk])];
+
+    if ((reason != NO_REASON) &&
+        (REASON_KIND(reason) == BY_NOGOOD))
+    {
+      stays[REASON_DATA(reason)] = TRUE;
+    }
+  }
+
+  for (nogood=0; nogood < cdcl->num_nogoods; nogood++)
+  {
+    if ((all == FALSE) &&
+        (cdcl->span[nogood] <= GLUE_SPAN))
+    {
+      stays[nogood] = TRUE;
+    }
+
+    if (stays[nogood] == FALSE)
+    {
+      spans[cdcl->span[nogood]]++;
+      candidates++;
+    }
+  }
+
+  /***************************************************************************/
+  /* Find the span from which to forget, and how many at that span.          */
+  /***************************************************************************/
+  target = (candidates + 1) / 2;
+  extra = target;
+
+  for (threshold=SUDOKU_CELLS + 1; (threshold > 0) && (extra > 0); threshold--)
+  {
+    if (spans[threshold] >= extra)
+    {
+      break;
+    }
+    extra -= spans[threshold];
+  }
+
+  /***************************************************************************/
+  /* Pack down the nogoods that stay, in order.                              */
+  /***************************************************************************/
+  for (nogood=0; nogood < cdcl->num_nogoods; nogood++)
+  {
+    if ((stays[nogood] == FALSE) &&
+        ((cdcl->span[nogood] > threshold) ||
+         ((cdcl->span[nogood] == threshold) && (extra-- > 0))))
+    {
+      cdcl->forgotten++;
+      continue;
+    }
+
+    memmove(&cdcl->pool[used],
+            &cdcl->pool[cdcl->start[nogood]],
+            cdcl->size[nogood] * sizeof(cdcl->pool[0]));
+    cdcl->start[kept] = used;
+    cdcl->size[kept] = cdcl->size[nogood];
+    cdcl->span[kept] = cdcl->span[nogood];
+    moved[nogood] = kept;
+    used += cdcl->size[kept];
+    kept++;
+  }
+
+  cdcl->num_nogoods = kept;
+  cdcl->pool_used = used;
+
+  for (kk=0; kk < cdcl->trail_top; kk++)
+  {
+    reason = cdcl->reason[LIT_STATEMENT(cdcl->trail[kk])];
+
+    if ((reason != NO_REASON) &&
+        (REASON_KIND(reason) == BY_NOGOOD))
+    {
+      cdcl->reason[LIT_STATEMENT(cdcl->trail[kk])] =
+        REASON(BY_NOGOOD, moved[REASON_DATA(reason)]);
+    }
+  }
+
+  /***************************************************************************/
+  /* And watch them all again.                                               */
+  /***************************************************************************/
+  for (kk=0; kk < CDCL_LITS; kk++)
+  {
+    cdcl->watch[kk] = NONE;
+  }
+
+  for (nogood=0; nogood < kept; nogood++)
+  {
+    for (side=0; side < 2; side++)
+    {
+      kk = cdcl->pool[cdcl->start[nogood] + side];
+      cdcl->next[nogood][side] = cdcl->watch[kk];
+      cdcl->watch[kk] = nogood;
+    }
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Chooses where to guess: the entry with the fewest values left, breaking   */
+/* ties by which has been in contradictions most recently, and its lowest    */
+/* value.  Returns NONE if every entry holds a value.                        */
+/*****************************************************************************/
+static int pick(const struct cdcl *cdcl)
+{
+  int best = NONE;
+  int best_count = SIZE + 1;
+  int best_entry = 0;
+  int count;
+  int first;
+  int nn;
+  int vv;
+
+  for (nn=0; nn < SUDOKU_CELLS; nn++)
+  {
+    count = 0;
+    first = NONE;
+
+    for (vv=0; vv < SIZE; vv++)
+    {
+      if (cdcl->value[STATEMENT(nn, vv)] == TRUE)
+      {
+        break;
+      }
+
+      if (cdcl->value[STATEMENT(nn, vv)] == UNSET)
+      {
+        if (count++ == 0)
+        {
+          first = STATEMENT(nn, vv);
+        }
+      }
+    }
+
+    if ((vv == SIZE) &&
+        ((count < best_count) ||
+         ((count == best_count) &&
+          (cdcl->activity[nn] > cdcl->activity[best_entry]))))
+    {
+      ASSERT(count > 1);
+      best = first;
+      best_count = count;
+      best_entry = nn;
+    }
+  }
+
+  return (best);
+}
+
+/*****************************************************************************/
+/* Counts a search node against the budget, reading the clock only every so  */
+/* often.  Returns TRUE once the budget is exceeded.                         */
+/*****************************************************************************/
+static int over_budget(struct cdcl *cdcl)
+{
+  cdcl->nodes++;
+
+  if (((cdcl->max_nodes > 0) &&
+       (cdcl->nodes > cdcl->max_nodes)) ||
+      ((cdcl->deadline > 0) &&
+       ((cdcl->nodes % CLOCK_INTERVAL) == 0) &&
+       (now_seconds() > cdcl->deadline)))
+  {
+    cdcl->exceeded = TRUE;
+  }
+
+  return (cdcl->exceeded);
+}
+
+/*****************************************************************************/
+/* Returns a wall-clock time in seconds, on the same clock as the library's. */
+/*****************************************************************************/
+static double now_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec + (now.tv_nsec / 1e9));
+#else
+  return ((double)clock() / CLOCKS_PER_SEC);
+#endif
+}
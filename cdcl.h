@@ -0,0 +1,152 @@
+/*****************************************************************************/
+/* Conflict-driven search with nogood learning, used by the library's "cdcl" */
+/* engine.  Not part of the public interface.                                */
+/*                                                                           */
+/* The puzzle is a set of true-or-false statements, "entry N holds value V", */
+/* and the search assigns them as the logic engine would fix and eliminate   */
+/* candidates: it guesses at the entry with the fewest candidates and        */
+/* pushes the consequences out through the units (see units.h), fixing       */
+/* entries down to one candidate and values down to one place in a unit.     */
+/* Each statement assigned by propagation remembers why: the guess or fixed  */
+/* value that eliminated it, or the entry, the unit or the nogood that had   */
+/* nowhere else left for it.                                                 */
+/*                                                                           */
+/* When an entry or a unit runs out of places, the search follows those      */
+/* reasons back from the contradiction to the one assignment at the latest   */
+/* level of guessing that led to it (the first unique implication point)     */
+/* and learns a nogood: a set of assignments that can't all hold.  It then   */
+/* jumps straight back to the latest earlier level any of the nogood's       */
+/* other assignments was made at, rather than just undoing the last guess,   */
+/* and the nogood forces the opposite of that one assignment there.          */
+/* Nogoods are watched, two assignments to each, so they cost nothing until  */
+/* all but one of their assignments hold.                                    */
+/*                                                                           */
+/* The nogoods are kept in fixed-size tables.  When those are full, half of  */
+/* those that could go are forgotten: the ones spanning the most levels of   */
+/* guessing, oldest first.  Nogoods spanning two or fewer levels are kept,   */
+/* as are those that are the reason for a current assignment.                */
+/*                                                                           */
+/* When counting solutions, the search carries on from each one by trying    */
+/* the other way of its latest guess not yet tried both ways, at a level of  */
+/* its own, and never jumps back past such a level until everything under    */
+/* it has been tried, so no solution is found twice.                         */
+/*****************************************************************************/
+#ifndef CDCL_H
+#define CDCL_H
+
+#include "sudoku.h"
+#include "units.h"
+
+/*****************************************************************************/
+/* One statement for each value of each entry, and a literal for each of     */
+/* those being true or false.                                                */
+/*****************************************************************************/
+#define CDCL_VARS (SUDOKU_CELLS * SUDOKU_SIZE)
+#define CDCL_LITS (2 * CDCL_VARS)
+
+/*****************************************************************************/
+/* Room for nogoods: how many, and how many literals in all.                 */
+/*****************************************************************************/
+#define CDCL_NOGOODS 2048
+#define CDCL_LITERALS 32768
+
+struct cdcl
+{
+  /***************************************************************************/
+  /* Each statement's value (see cdcl.c), the level of guessing it was       */
+  /* assigned at and why.                                                    */
+  /***************************************************************************/
+  unsigned char value[CDCL_VARS];
+  short level[CDCL_VARS];
+  int reason[CDCL_VARS];
+
+  /***************************************************************************/
+  /* The literals made true, in order, how far propagation has got through   */
+  /* them, and where each level of guessing starts, its guess first.         */
+  /***************************************************************************/
+  short trail[CDCL_VARS];
+  int trail_top;
+  int queue_head;
+  int level_start[SUDOKU_CELLS + 2];
+  int cur_level;
+
+  /***************************************************************************/
+  /* Whether each level of guessing is the other way of an earlier guess.    */
+  /***************************************************************************/
+  unsigned char flipped[SUDOKU_CELLS + 2];
+
+  /***************************************************************************/
+  /* The nogoods: where each one's literals start in the pool, how many      */
+  /* there are, how many levels they spanned when it was learned, and the    */
+  /* next nogood watching each of its first two literals.  watch[] heads the */
+  /* list of nogoods watching each literal.                                  */
+  /***************************************************************************/
+  int start[CDCL_NOGOODS];
+  short size[CDCL_NOGOODS];
+  unsigned char span[CDCL_NOGOODS];
+  int next[CDCL_NOGOODS][2];
+  int num_nogoods;
+  short pool[CDCL_LITERALS];
+  int pool_used;
+  int watch[CDCL_LITS];
+
+  /***************************************************************************/
+  /* Room for working out nogoods: the literals of the contradiction, of the */
+  /* nogood being learned, which statements and levels it has met so far,    */
+  /* and how recently each entry has been in a nogood, for choosing where to */
+  /* guess.                                                                  */
+  /***************************************************************************/
+  short conflict[CDCL_VARS];
+  int conflict_size;
+  short learned[CDCL_VARS];
+  unsigned char seen[CDCL_VARS];
+  unsigned char level_seen[SUDOKU_CELLS + 2];
+  long activity[SUDOKU_CELLS];
+
+  /***************************************************************************/
+  /* The deepest level of guessing reached.                                  */
+  /***************************************************************************/
+  int max_depth;
+
+  /***************************************************************************/
+  /* Solutions found so far and how many to look for.                        */
+  /***************************************************************************/
+  long num_solutions;
+  long limit;
+
+  /***************************************************************************/
+  /* Guesses made, contradictions backed out of (and solutions, when         */
+  /* counting), the levels of guessing skipped by jumping back past them,    */
+  /* and nogoods learned and forgotten.                                      */
+  /***************************************************************************/
+  long guesses;
+  long backtracks;
+  long backjumps;
+  long nogoods;
+  long forgotten;
+
+  /***************************************************************************/
+  /* The search's budget: the most nodes it may visit (0 for no limit) and   */
+  /* the time it must finish by (0 if none), set by the caller, then the     */
+  /* nodes visited and whether it ran out.                                   */
+  /***************************************************************************/
+  long max_nodes;
+  double deadline;
+  long nodes;
+  int exceeded;
+};
+
+/*****************************************************************************/
+/* cdcl_solve() solves a puzzle of the given units, as values row by row, 0  */
+/* for unknown, looking for up to limit solutions.  Returns how many it      */
+/* found, with the first in the same form in solution[].  A search that      */
+/* can't make room for a nogood it needs, even after forgetting all the rest */
+/* it can, gives up as if out of budget.                                     */
+/*****************************************************************************/
+long cdcl_solve(struct cdcl *,
+                const struct units *,
+                const int *,
+                int *,
+                long);
+
+#endif
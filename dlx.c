@@ -0,0 +1,393 @@
+/*****************************************************************************/
+/* Dancing Links solver.  See dlx.h.                                         */
+/*                                                                           */
+/* Add #define DEBUG for debug build.                                        */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "dlx.h"
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define SIZE SUDOKU_SIZE
+#define TRUE 1
+#define FALSE 0
+
+/*****************************************************************************/
+/* Assert macro.                                                             */
+/*****************************************************************************/
+#ifdef DEBUG
+#define ASSERT(X) assert(X)
+#else
+#define ASSERT(X)
+#endif
+
+/*****************************************************************************/
+/* With a time limit, the clock is only read once every this many search     */
+/* nodes.                                                                    */
+/*****************************************************************************/
+#define CLOCK_INTERVAL 64
+
+/*****************************************************************************/
+/* The first node of matrix row R, and the matrix row a node belongs to.     */
+/* Row R places value (R % SIZE) + 1 in entry R / SIZE.                      */
+/*****************************************************************************/
+#define ROW_NODE(R) (1 + DLX_COLUMNS + (DLX_ROW_NODES * (R)))
+#define NODE_ROW(N) (((N) - (1 + DLX_COLUMNS)) / DLX_ROW_NODES)
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+static int search(struct dlx *, int);
+static void cover(struct dlx *, int);
+static void uncover(struct dlx *, int);
+static int over_budget(struct dlx *);
+static double now_seconds(void);
+
+/*****************************************************************************/
+/* Builds the full matrix for the units: every value possible in every       */
+/* entry.                                                                    */
+/*****************************************************************************/
+void dlx_init(struct dlx *dlx, const struct units *units)
+{
+  int rr;
+  int kk;
+  int nn;
+  int cc;
+  int cols[DLX_ROW_NODES];
+  int num_cols;
+  int entry;
+  int value;
+  int last = SUDOKU_CELLS + (units->count * SIZE);
+
+  /***************************************************************************/
+  /* The root and the headers of the columns in use form a circular list,    */
+  /* each header heading an empty circular column.                           */
+  /***************************************************************************/
+  for (cc=0; cc <= DLX_COLUMNS; cc++)
+  {
+    dlx->left[cc] = (short)((cc == 0) ? last : (cc - 1));
+    dlx->right[cc] = (short)((cc >= last) ? 0 : (cc + 1));
+    dlx->up[cc] = (short)cc;
+    dlx->down[cc] = (short)cc;
+    dlx->column[cc] = (short)cc;
+    dlx->size[cc] = 0;
+  }
+
+  for (rr=0; rr < DLX_ROWS; rr++)
+  {
+    entry = rr / SIZE;
+    value = rr % SIZE;
+
+    /*************************************************************************/
+    /* Columns are numbered from 1: the entries, then the values in each     */
+    /* unit in turn.                                                         */
+    /*************************************************************************/
+    cols[0] = 1 + entry;
+    num_cols = 1 + units->num_of[entry];
+
+    for (kk=1; kk < num_cols; kk++)
+    {
+      cols[kk] = 1 + SUDOKU_CELLS + (units->of[entry][kk - 1] * SIZE) + value;
+    }
+
+    for (kk=0; kk < num_cols; kk++)
+    {
+      nn = ROW_NODE(rr) + kk;
+      cc = cols[kk];
+
+      /***********************************************************************/
+      /* Link the node into its row, and onto the bottom of its column.      */
+      /***********************************************************************/
+      dlx->left[nn] = (short)(ROW_NODE(rr) + ((kk + num_cols - 1) % num_cols));
+      dlx->right[nn] = (short)(ROW_NODE(rr) + ((kk + 1) % num_cols));
+      dlx->column[nn] = (short)cc;
+      dlx->up[nn] = dlx->up[cc];
+      dlx->down[nn] = (short)cc;
+      dlx->down[dlx->up[cc]] = (short)nn;
+      dlx->up[cc] = (short)nn;
+      dlx->size[cc]++;
+    }
+  }
+
+  dlx->max_depth = 0;
+  dlx->max_nodes = 0;
+  dlx->deadline = 0;
+  return;
+}
+
+/*****************************************************************************/
+/* Solves a puzzle given as values row by row, 0 for unknown, looking for up */
+/* to limit solutions.  Returns how many it found, with the first in the     */
+/* same form in solution[].  Either way the matrix is restored before        */
+/* returning.                                                                */
+/*****************************************************************************/
+long dlx_solve(struct dlx *dlx, const int *values, int *solution, long limit)
+{
+  short givens[SUDOKU_CELLS];
+  unsigned char covered[1 + DLX_COLUMNS];
+  int num_givens = 0;
+  int nn;
+  int jj;
+  int ii;
+
+  memset(covered, 0, sizeof(covered));
+  dlx->max_depth = 0;
+  dlx->num_solutions = 0;
+  dlx->limit = limit;
+  dlx->guesses = 0;
+  dlx->backtracks = 0;
+  dlx->nodes = 0;
+  dlx->exceeded = FALSE;
+
+  /***************************************************************************/
+  /* Take each given's row as chosen.  Two givens that cover the same column */
+  /* clash, and there's no solution.                                         */
+  /***************************************************************************/
+  for (ii=0; ii < SUDOKU_CELLS; ii++)
+  {
+    if (values[ii] == 0)
+    {
+      continue;
+    }
+
+    nn = ROW_NODE((ii * SIZE) + values[ii] - 1);
+    jj = nn;
+    do
+    {
+      if (covered[dlx->column[jj]])
+      {
+        goto UNDO;
+      }
+      jj = dlx->right[jj];
+    } while (jj != nn);
+
+    jj = nn;
+    do
+    {
+      covered[dlx->column[jj]] = TRUE;
+      cover(dlx, dlx->column[jj]);
+      jj = dlx->right[jj];
+    } while (jj != nn);
+
+    givens[num_givens++] = (short)nn;
+  }
+
+  /***************************************************************************/
+  /* Search for rows covering the remaining columns.                         */
+  /***************************************************************************/
+  (void)search(dlx, 0);
+
+  if (dlx->num_solutions > 0)
+  {
+    for (ii=0; ii < SUDOKU_CELLS; ii++)
+    {
+      solution[ii] = values[ii];
+    }
+
+    for (ii=0; ii < dlx->first_size; ii++)
+    {
+      nn = NODE_ROW(dlx->first[ii]);
+      solution[nn / SIZE] = (nn % SIZE) + 1;
+    }
+  }
+
+UNDO:
+
+  /***************************************************************************/
+  /* Uncover the givens' columns in the reverse of the order they were       */
+  /* covered.                                                                */
+  /***************************************************************************/
+  while (num_givens > 0)
+  {
+    nn = givens[--num_givens];
+    jj = nn;
+    do
+    {
+      jj = dlx->left[jj];
+      uncover(dlx, dlx->column[jj]);
+    } while (jj != nn);
+  }
+
+  return (dlx->num_solutions);
+}
+
+/*****************************************************************************/
+/* Algorithm X.  Picks the column with fewest rows left and tries each of    */
+/* them in turn.  Counts the solutions, keeping the rows chosen for the      */
+/* first, and returns TRUE to stop the search once there are enough.  Always */
+/* restores the matrix.                                                      */
+/*****************************************************************************/
+static int search(struct dlx *dlx, int depth)
+{
+  int cc;
+  int jj;
+  int rr;
+  int best;
+  int success = FALSE;
+
+  if (over_budget(dlx) == TRUE)
+  {
+    return (FALSE);
+  }
+
+  if (dlx->max_depth < depth)
+  {
+    dlx->max_depth = depth;
+  }
+
+  if (dlx->right[0] == 0)
+  {
+    /*************************************************************************/
+    /* Every column is covered.  We've solved the puzzle.                    */
+    /*************************************************************************/
+    if (dlx->num_solutions == 0)
+    {
+      memcpy(dlx->first, dlx->chosen, sizeof(dlx->chosen[0]) * depth);
+      dlx->first_size = depth;
+    }
+    dlx->num_solutions++;
+    return (dlx->num_solutions >= dlx->limit);
+  }
+
+  best = dlx->right[0];
+  for (cc=dlx->right[best]; cc != 0; cc=dlx->right[cc])
+  {
+    if (dlx->size[cc] < dlx->size[best])
+    {
+      best = cc;
+
+      if (dlx->size[best] <= 1)
+      {
+        break;
+      }
+    }
+  }
+
+  if (dlx->size[best] == 0)
+  {
+    return (FALSE);
+  }
+
+  ASSERT(depth < SUDOKU_CELLS);
+
+  cover(dlx, best);
+
+  for (rr=dlx->down[best]; rr != best; rr=dlx->down[rr])
+  {
+    dlx->chosen[depth] = (short)rr;
+    dlx->guesses++;
+
+    for (jj=dlx->right[rr]; jj != rr; jj=dlx->right[jj])
+    {
+      cover(dlx, dlx->column[jj]);
+    }
+
+    success = search(dlx, depth + 1);
+
+    for (jj=dlx->left[rr]; jj != rr; jj=dlx->left[jj])
+    {
+      uncover(dlx, dlx->column[jj]);
+    }
+
+    if ((success == TRUE) ||
+        (dlx->exceeded == TRUE))
+    {
+      break;
+    }
+    dlx->backtracks++;
+  }
+
+  uncover(dlx, best);
+
+  return (success);
+}
+
+/*****************************************************************************/
+/* Removes a column from the header list, and every row with a node in it    */
+/* from the other columns it's in.                                           */
+/*****************************************************************************/
+static void cover(struct dlx *dlx, int cc)
+{
+  int ii;
+  int jj;
+
+  dlx->right[dlx->left[cc]] = dlx->right[cc];
+  dlx->left[dlx->right[cc]] = dlx->left[cc];
+
+  for (ii=dlx->down[cc]; ii != cc; ii=dlx->down[ii])
+  {
+    for (jj=dlx->right[ii]; jj != ii; jj=dlx->right[jj])
+    {
+      dlx->down[dlx->up[jj]] = dlx->down[jj];
+      dlx->up[dlx->down[jj]] = dlx->up[jj];
+      dlx->size[dlx->column[jj]]--;
+    }
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Exactly undoes cover(), working in the opposite order.                    */
+/*****************************************************************************/
+static void uncover(struct dlx *dlx, int cc)
+{
+  int ii;
+  int jj;
+
+  for (ii=dlx->up[cc]; ii != cc; ii=dlx->up[ii])
+  {
+    for (jj=dlx->left[ii]; jj != ii; jj=dlx->left[jj])
+    {
+      dlx->size[dlx->column[jj]]++;
+      dlx->down[dlx->up[jj]] = (short)jj;
+      dlx->up[dlx->down[jj]] = (short)jj;
+    }
+  }
+
+  dlx->right[dlx->left[cc]] = (short)cc;
+  dlx->left[dlx->right[cc]] = (short)cc;
+  return;
+}
+
+/*****************************************************************************/
+/* Counts a search node against the budget, reading the clock only every so  */
+/* often.  Returns TRUE once the budget is exceeded, and from then on, so    */
+/* the whole search unwinds.                                                 */
+/*****************************************************************************/
+static int over_budget(struct dlx *dlx)
+{
+  dlx->nodes++;
+
+  if (((dlx->max_nodes > 0) &&
+       (dlx->nodes > dlx->max_nodes)) ||
+      ((dlx->deadline > 0) &&
+       ((dlx->nodes % CLOCK_INTERVAL) == 0) &&
+       (now_seconds() > dlx->deadline)))
+  {
+    dlx->exceeded = TRUE;
+  }
+
+  return (dlx->exceeded);
+}
+
+/*****************************************************************************/
+/* Returns a wall-clock time in seconds, on the same clock as the library's. */
+/*****************************************************************************/
+static double now_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec + (now.tv_nsec / 1e9));
+#else
+  return ((double)clock() / CLOCKS_PER_SEC);
+#endif
+}
@@ -0,0 +1,80 @@
+/*****************************************************************************/
+/* Dancing Links solver, used by the library's "dlx" engine.  Not part of    */
+/* the public interface.                                                     */
+/*                                                                           */
+/* The puzzle is an exact cover problem.  Each way of placing a value in an  */
+/* entry is a row of the matrix, covering a column for the entry itself and  */
+/* one for the value in each of its units (see units.h).  A solution is a    */
+/* set of rows covering every column exactly once.                           */
+/*                                                                           */
+/* The matrix is built for the context's variant when that's set, and every  */
+/* solve leaves it as it found it.  Links are node numbers rather than       */
+/* pointers, so a copy of the structure is a working matrix in its own       */
+/* right.                                                                    */
+/*****************************************************************************/
+#ifndef DLX_H
+#define DLX_H
+
+#include "sudoku.h"
+#include "units.h"
+
+#define DLX_COLUMNS (SUDOKU_CELLS + (UNITS_MAX * SUDOKU_SIZE))
+#define DLX_ROWS (SUDOKU_CELLS * SUDOKU_SIZE)
+
+/*****************************************************************************/
+/* Node 0 is the root, then come the column headers, then the rows, in row   */
+/* order, with room for as many nodes as an entry can have units and one.    */
+/* Columns past those the variant uses are left out of the header list.      */
+/*****************************************************************************/
+#define DLX_ROW_NODES (1 + UNITS_PER_ENTRY)
+#define DLX_NODES (1 + DLX_COLUMNS + (DLX_ROW_NODES * DLX_ROWS))
+
+struct dlx
+{
+  short left[DLX_NODES];
+  short right[DLX_NODES];
+  short up[DLX_NODES];
+  short down[DLX_NODES];
+  short column[DLX_NODES];
+
+  /***************************************************************************/
+  /* Number of rows still in each column, indexed by header node.            */
+  /***************************************************************************/
+  short size[1 + DLX_COLUMNS];
+
+  /***************************************************************************/
+  /* Rows chosen so far by the search, and the deepest it went.              */
+  /***************************************************************************/
+  short chosen[SUDOKU_CELLS];
+  int max_depth;
+
+  /***************************************************************************/
+  /* Solutions found so far, how many to look for, and the rows chosen for   */
+  /* the first.                                                              */
+  /***************************************************************************/
+  long num_solutions;
+  long limit;
+  short first[SUDOKU_CELLS];
+  int first_size;
+
+  /***************************************************************************/
+  /* Rows the search tried, and those it had to take back.                   */
+  /***************************************************************************/
+  long guesses;
+  long backtracks;
+
+  /***************************************************************************/
+  /* The search's budget: the most nodes it may visit (0 for no limit) and   */
+  /* the time it must finish by (0 if none), set by the caller, then the     */
+  /* nodes visited and whether it ran out.                                   */
+  /***************************************************************************/
+  long max_nodes;
+  double deadline;
+  long nodes;
+  int exceeded;
+};
+
+void dlx_init(struct dlx *, const struct units *);
+long dlx_solve(struct dlx *, const int *, int *, long);
+
+#endif
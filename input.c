@@ -0,0 +1,485 @@
+/*****************************************************************************/
+/* Puzzle input for the command-line programs.  See input.h.                 */
+/*                                                                           */
+/* Add #define NO_MMAP to always read files in blocks.                       */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include "input.h"
+
+/*****************************************************************************/
+/* Mapping files needs POSIX.                                                */
+/*****************************************************************************/
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(NO_MMAP)
+#define HAVE_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define TRUE 1
+#define FALSE 0
+
+/*****************************************************************************/
+/* Size of the blocks read when a file isn't mapped.                         */
+/*****************************************************************************/
+#define BLOCK_SIZE (1 << 20)
+
+/*****************************************************************************/
+/* The value of an entry's character, 0 for unknown, or more than 9 if it    */
+/* isn't a digit or '.'.  Unsigned arithmetic folds the range checks into    */
+/* one comparison.                                                           */
+/*****************************************************************************/
+#define CELL_VALUE(C) (((C) == '.') ? 0u : (unsigned int)((C) - '0'))
+#define IS_CELL(C) (CELL_VALUE(C) <= 9u)
+
+/*****************************************************************************/
+/* Likewise for grids of any size, letters in either case being 10 up, and   */
+/* more than SUDOKU_MAX_SIZE for anything else.                              */
+/*****************************************************************************/
+#define LETTER(C) ((unsigned int)(((C) | 0x20) - 'a'))
+#define LETTER_VALUE(C) ((LETTER(C) < 26u) ? (LETTER(C) + 10u) : \
+                                            (SUDOKU_MAX_SIZE + 1u))
+#define ENTRY_VALUE(C) (IS_CELL(C) ? CELL_VALUE(C) : LETTER_VALUE(C))
+#define IS_ENTRY(C) (ENTRY_VALUE(C) <= SUDOKU_MAX_SIZE)
+#define IS_SPACE(C) (((C) == ' ') || ((unsigned int)((C) - '\t') <= 4u))
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+#ifdef HAVE_MMAP
+static int map_file(struct input *, const char *);
+#endif
+static int fill(struct input *);
+static int grid_size(int);
+
+int input_open(struct input *in, const char *name)
+{
+  memset(in, 0, sizeof(*in));
+
+  if (strcmp(name, "-") == 0)
+  {
+    in->file = stdin;
+  }
+  else
+  {
+#ifdef HAVE_MMAP
+    if (map_file(in, name) == TRUE)
+    {
+      return (TRUE);
+    }
+#endif
+    in->file = fopen(name, "rb");
+
+    if (in->file == NULL)
+    {
+      return (FALSE);
+    }
+  }
+
+  in->capacity = BLOCK_SIZE;
+  in->data = malloc(in->capacity);
+
+  if (in->data == NULL)
+  {
+    input_close(in);
+    return (FALSE);
+  }
+  return (TRUE);
+}
+
+void input_close(struct input *in)
+{
+#ifdef HAVE_MMAP
+  if (in->mapped == TRUE)
+  {
+    (void)munmap(in->data, in->size);
+    in->data = NULL;
+  }
+#endif
+  free(in->data);
+
+  if ((in->file != NULL) &&
+      (in->file != stdin))
+  {
+    (void)fclose(in->file);
+  }
+  memset(in, 0, sizeof(*in));
+  return;
+}
+
+int input_line(struct input *in,
+               const char **line,
+               size_t *len,
+               size_t *offset)
+{
+  char *start;
+  char *end;
+
+  for (;;)
+  {
+    start = in->data + in->pos;
+    end = memchr(start, '\n', in->size - in->pos);
+
+    if (in->skipping == TRUE)
+    {
+      /***********************************************************************/
+      /* Throw away the rest of a line that was cut short.                   */
+      /***********************************************************************/
+      if (end != NULL)
+      {
+        in->pos = (size_t)(end - in->data) + 1;
+        in->skipping = FALSE;
+        continue;
+      }
+      in->pos = in->size;
+    }
+    else if (end != NULL)
+    {
+      *line = start;
+      *len = (size_t)(end - start);
+      *offset = in->base + in->pos;
+      in->pos += *len + 1;
+      return (TRUE);
+    }
+    else if ((in->pos == 0) &&
+             (in->size == in->capacity))
+    {
+      /***********************************************************************/
+      /* The line fills the whole buffer.  Hand out what there is.           */
+      /***********************************************************************/
+      *line = start;
+      *len = in->size;
+      *offset = in->base;
+      in->pos = in->size;
+      in->skipping = TRUE;
+      return (TRUE);
+    }
+
+    if (fill(in) == FALSE)
+    {
+      break;
+    }
+  }
+
+  /***************************************************************************/
+  /* A last line with no newline after it.                                   */
+  /***************************************************************************/
+  if ((in->pos < in->size) &&
+      (in->skipping == FALSE))
+  {
+    *line = in->data + in->pos;
+    *len = in->size - in->pos;
+    *offset = in->base + in->pos;
+    in->pos = in->size;
+    return (TRUE);
+  }
+  return (FALSE);
+}
+
+int input_grid(struct input *in,
+               int values[SUDOKU_MAX_CELLS],
+               int *size,
+               size_t *offset)
+{
+  const char *line;
+  size_t len;
+  size_t start = 0;
+  size_t ii;
+  size_t stop;
+  size_t highest_at = 0;
+  unsigned int value;
+  unsigned int highest = 0;
+  unsigned int most = SUDOKU_MAX_SIZE;
+  int cells = 0;
+  int first;
+  int nn = 0;
+  int packed;
+
+  *size = 0;
+
+  while (((cells == 0) || (nn < cells)) &&
+         (input_line(in, &line, &len, &start) == TRUE))
+  {
+    if ((len > 0) &&
+        (line[0] == '#'))
+    {
+      continue;
+    }
+
+    first = nn;
+    packed = FALSE;
+
+    for (ii=0; (ii < len) && ((cells == 0) || (nn < cells)); ii++)
+    {
+      if (IS_SPACE(line[ii]))
+      {
+        if (packed == TRUE)
+        {
+          break;
+        }
+        continue;
+      }
+
+      value = ENTRY_VALUE(line[ii]);
+
+      if ((value > most) ||
+          (nn == SUDOKU_MAX_CELLS))
+      {
+        break;
+      }
+
+      if ((ii + 1 < len) &&
+          IS_ENTRY(line[ii+1]))
+      {
+        /*********************************************************************/
+        /* Two entries together.  That's only allowed if all of the line's   */
+        /* are.                                                              */
+        /*********************************************************************/
+        if ((nn > first) &&
+            (packed == FALSE))
+        {
+          *offset = start + ii;
+          return (INPUT_LONG_ENTRY);
+        }
+        packed = TRUE;
+      }
+
+      if (value > highest)
+      {
+        highest = value;
+        highest_at = start + ii;
+      }
+      values[nn++] = (int)value;
+    }
+
+    stop = ii;
+
+    /*************************************************************************/
+    /* A row of 16 with nothing on the line after it is a whole 4x4 grid.    */
+    /*************************************************************************/
+    if ((nn == first) &&
+        (cells == (16 * 16)) &&
+        (nn == 16))
+    {
+      break;
+    }
+
+    if ((cells == 0) &&
+        (nn > 0))
+    {
+      /***********************************************************************/
+      /* The first line with entries sets the size.                          */
+      /***********************************************************************/
+      *size = grid_size(nn);
+
+      if ((*size == 0) &&
+          ((stop == len) || IS_SPACE(line[stop])))
+      {
+        /*********************************************************************/
+        /* Otherwise it's a 9x9 grid laid out any way at all, as the entries */
+        /* are counted across lines, unless there are too many for one.      */
+        /*********************************************************************/
+        if (nn >= SUDOKU_CELLS)
+        {
+          *offset = start;
+          return (INPUT_BAD_SIZE);
+        }
+        *size = SUDOKU_SIZE;
+      }
+      cells = *size * *size;
+
+      if ((*size > 0) &&
+          (highest > (unsigned int)*size))
+      {
+        *offset = highest_at;
+        return (INPUT_BAD_CHAR);
+      }
+      most = (unsigned int)*size;
+    }
+
+    /*************************************************************************/
+    /* Unless that was the end of the grid, whatever stopped the entries     */
+    /* must be white space, with nothing but more of it after.               */
+    /*************************************************************************/
+    for (; (ii < len) && ((cells == 0) || (nn < cells)); ii++)
+    {
+      if (!IS_SPACE(line[ii]))
+      {
+        *offset = start + stop;
+        return ((ii == stop) ? INPUT_BAD_CHAR : INPUT_SHORT);
+      }
+    }
+  }
+
+  if ((cells == (16 * 16)) &&
+      (nn == 16))
+  {
+    *size = 4;
+    cells = nn;
+
+    if (highest > (unsigned int)*size)
+    {
+      *offset = highest_at;
+      return (INPUT_BAD_CHAR);
+    }
+  }
+
+  if ((cells == 0) ||
+      (nn < cells))
+  {
+    *offset = in->base + in->size;
+    return (INPUT_SHORT);
+  }
+  return (INPUT_OK);
+}
+
+long input_line_error(const char *line, size_t len)
+{
+  size_t nn;
+
+  for (nn=0; (nn < SUDOKU_CELLS) && (nn < len); nn++)
+  {
+    if (!IS_CELL(line[nn]))
+    {
+      return ((long)nn);
+    }
+  }
+
+  if ((nn < SUDOKU_CELLS) ||
+      ((nn < len) &&
+       (line[nn] != ',') &&
+       !IS_SPACE(line[nn])))
+  {
+    return ((long)nn);
+  }
+  return (-1);
+}
+
+int input_blank(const char *line, size_t len)
+{
+  size_t ii;
+
+  for (ii=0; ii < len; ii++)
+  {
+    if (!IS_SPACE(line[ii]))
+    {
+      return (FALSE);
+    }
+  }
+  return (TRUE);
+}
+
+#ifdef HAVE_MMAP
+/*****************************************************************************/
+/* Maps a whole regular file.  Returns FALSE if it can't, and then the file  */
+/* is read in blocks instead.                                                */
+/*****************************************************************************/
+static int map_file(struct input *in, const char *name)
+{
+  struct stat st;
+  void *data;
+  int fd;
+  int rc = FALSE;
+
+  fd = open(name, O_RDONLY);
+
+  if (fd < 0)
+  {
+    return (FALSE);
+  }
+
+  if ((fstat(fd, &st) == 0) &&
+      S_ISREG(st.st_mode) &&
+      (st.st_size > 0) &&
+      ((off_t)(size_t)st.st_size == st.st_size))
+  {
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data != MAP_FAILED)
+    {
+#ifdef POSIX_MADV_SEQUENTIAL
+      (void)posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+      in->data = data;
+      in->size = (size_t)st.st_size;
+      in->capacity = in->size;
+      in->eof = TRUE;
+      in->mapped = TRUE;
+      rc = TRUE;
+    }
+  }
+
+  /***************************************************************************/
+  /* The mapping stays valid once the file is closed.                        */
+  /***************************************************************************/
+  (void)close(fd);
+  return (rc);
+}
+#endif
+
+/*****************************************************************************/
+/* Reads another block, after what's left of the last.  Returns FALSE at the */
+/* end of the input.                                                         */
+/*****************************************************************************/
+static int fill(struct input *in)
+{
+  size_t got;
+
+  if (in->eof == TRUE)
+  {
+    return (FALSE);
+  }
+
+  memmove(in->data, in->data + in->pos, in->size - in->pos);
+  in->base += in->pos;
+  in->size -= in->pos;
+  in->pos = 0;
+
+  got = fread(in->data + in->size, 1, in->capacity - in->size, in->file);
+  in->size += got;
+
+  if (got == 0)
+  {
+    in->eof = TRUE;
+    return (FALSE);
+  }
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* The size of grid that the entries on its first line make: a row, or the   */
+/* whole grid.  16 entries are a row rather than a 4x4 grid.  Returns 0 if   */
+/* they make neither.                                                        */
+/*****************************************************************************/
+static int grid_size(int entries)
+{
+  int block;
+
+  for (block=2; (block * block) <= SUDOKU_MAX_SIZE; block++)
+  {
+    if (entries == (block * block))
+    {
+      return (entries);
+    }
+  }
+
+  for (block=2; (block * block) <= SUDOKU_MAX_SIZE; block++)
+  {
+    if (entries == (block * block * block * block))
+    {
+      return (block * block);
+    }
+  }
+
+  return (0);
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************/
+/* Puzzle input for the command-line programs.  Not part of the library.     */
+/*                                                                           */
+/* A named file is memory-mapped where the system allows it, so puzzles are  */
+/* parsed straight from the file's bytes.  Standard input, or a file that    */
+/* can't be mapped, is read in large blocks instead.  Either way the lines   */
+/* handed out point into the input's own memory, and are only good until     */
+/* the next call.  Positions are byte offsets from the start of the input.   */
+/*****************************************************************************/
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdio.h>
+#include "sudoku.h"
+
+/*****************************************************************************/
+/* Outcomes of reading a grid.                                               */
+/*****************************************************************************/
+#define INPUT_OK 0
+#define INPUT_BAD_CHAR 1
+#define INPUT_LONG_ENTRY 2
+#define INPUT_SHORT 3
+#define INPUT_BAD_SIZE 4
+
+struct input
+{
+  /***************************************************************************/
+  /* The bytes in memory: the whole file if it's mapped, or the block read   */
+  /* so far.  Data[0] is at offset base in the input, and the next line      */
+  /* starts at data[pos].                                                    */
+  /***************************************************************************/
+  char *data;
+  size_t size;
+  size_t pos;
+  size_t base;
+
+  /***************************************************************************/
+  /* When reading blocks: the file, the size of the buffer, whether the end  */
+  /* of the file has been reached, and whether the rest of an overlong line  */
+  /* is still to be thrown away.                                             */
+  /***************************************************************************/
+  FILE *file;
+  size_t capacity;
+  int eof;
+  int skipping;
+  int mapped;
+};
+
+/*****************************************************************************/
+/* Opens a file, or standard input if the name is "-".  Returns 0 if it      */
+/* can't.                                                                    */
+/*****************************************************************************/
+int input_open(struct input *in, const char *name);
+void input_close(struct input *in);
+
+/*****************************************************************************/
+/* Hands out the next line, without its newline, and its offset.  A line     */
+/* longer than the block size is cut short.  Returns 0 at the end.           */
+/*****************************************************************************/
+int input_line(struct input *in,
+               const char **line,
+               size_t *len,
+               size_t *offset);
+
+/*****************************************************************************/
+/* Reads a grid of any size the library takes, 0 for unknown, in either      */
+/* layout: one character per entry separated by white space, as in the       */
+/* sample files, or the entries together, on one line or a row to a line.    */
+/* An entry is a digit, '.' for unknown, or a letter (in either case) from   */
+/* 'A' for 10 up.  The first line with entries sets the size: N entries are  */
+/* a row of a grid of size N, and N * N the whole grid, though 16 are a row  */
+/* unless the next line has no entries.  Any other number starts a 9x9 grid  */
+/* laid out any way, its entries counted across lines.  Lines starting with  */
+/* '#' are comments, skipped as in batches, and anything after the grid is   */
+/* ignored.  Returns INPUT_OK, with the size, or one of the errors above     */
+/* with the offset of the problem, INPUT_BAD_SIZE if the first line's        */
+/* entries are too many for a 9x9 grid and make no other.                    */
+/*****************************************************************************/
+int input_grid(struct input *in,
+               int values[SUDOKU_MAX_CELLS],
+               int *size,
+               size_t *offset);
+
+/*****************************************************************************/
+/* Where a puzzle line isn't in the form sudoku_load_line() takes: the index */
+/* of the first character that's wrong, or of the end if it's too short.     */
+/* Returns -1 if the line is fine.                                           */
+/*****************************************************************************/
+long input_line_error(const char *line, size_t len);
+
+/*****************************************************************************/
+/* Returns 1 if a line is nothing but white space.                           */
+/*****************************************************************************/
+int input_blank(const char *line, size_t len);
+
+#endif
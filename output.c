@@ -0,0 +1,364 @@
+/*****************************************************************************/
+/* Puzzle output for the command-line programs.  See output.h.               */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include "output.h"
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define SIZE SUDOKU_SIZE
+#define BLOCK_SIZE 3
+#define TRUE 1
+#define FALSE 0
+
+/*****************************************************************************/
+/* Starting size of the buffer, and the most any one result can need: a      */
+/* pretty 25x25 grid is under 2000 bytes.                                    */
+/*****************************************************************************/
+#define BUFFER_SIZE (1 << 20)
+#define MAX_RESULT 2048
+
+/*****************************************************************************/
+/* The value of an entry in a result's line, which only has unknown entries  */
+/* if it's a generated puzzle, and the character for a value.                */
+/*****************************************************************************/
+#define LINE_VALUE(C) (((C) == '.') ? 0 : \
+                       ((C) >= 'A') ? ((C) - 'A' + 10) : ((C) - '0'))
+#define VALUE_CHAR(V) ((char)(((V) > 9) ? ('A' + (V) - 10) : ('0' + (V))))
+
+/*****************************************************************************/
+/* Names of the formats, indexed by their numbers.                           */
+/*****************************************************************************/
+static const char *const format_names[] = {"pretty", "line", "binary", NULL};
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+static void add_result(struct output *,
+                       const char *,
+                       int,
+                       int,
+                       long,
+                       long);
+static char *room(struct output *, size_t);
+static char *add_text(char *, const char *);
+static char *add_number(char *, long);
+
+int output_format(const char *name)
+{
+  int ii;
+
+  for (ii=0; format_names[ii] != NULL; ii++)
+  {
+    if (strcmp(name, format_names[ii]) == 0)
+    {
+      return (ii);
+    }
+  }
+  return (-1);
+}
+
+int output_open(struct output *out, FILE *file, int format)
+{
+  memset(out, 0, sizeof(*out));
+  out->file = file;
+  out->format = format;
+  out->capacity = BUFFER_SIZE;
+  out->data = malloc(out->capacity);
+
+  return (out->data != NULL);
+}
+
+void output_close(struct output *out)
+{
+  if (out->data != NULL)
+  {
+    (void)output_flush(out);
+  }
+  free(out->data);
+  memset(out, 0, sizeof(*out));
+  return;
+}
+
+int output_flush(struct output *out)
+{
+  if ((out->size > 0) &&
+      ((fwrite(out->data, 1, out->size, out->file) != out->size) ||
+       (fflush(out->file) != 0)))
+  {
+    out->failed = TRUE;
+  }
+  out->size = 0;
+
+  return (out->failed == FALSE);
+}
+
+void output_grid(struct output *out, const int *values, int size)
+{
+  int block = 2;
+  int ii;
+  int jj;
+  char *pos = room(out, MAX_RESULT);
+
+  while ((block * block) < size)
+  {
+    block++;
+  }
+
+  /***************************************************************************/
+  /* Column numbers, and a rule under each block of them.                    */
+  /***************************************************************************/
+  pos = add_text(pos, "\n ");
+
+  for (jj=0; jj < size; jj++)
+  {
+    pos = add_text(pos, ((jj % block) == 0) ? "  " : " ");
+    *pos++ = VALUE_CHAR(jj + 1);
+  }
+  pos = add_text(pos, "\n ");
+
+  for (jj=0; jj < size; jj++)
+  {
+    pos = add_text(pos, ((jj % block) == 0) ? "  -" : "--");
+  }
+  *pos++ = '\n';
+
+  for (ii=0; ii < size; ii++)
+  {
+    *pos++ = VALUE_CHAR(ii + 1);
+    *pos++ = '|';
+    *pos++ = ' ';
+
+    for (jj=0; jj < size; jj++)
+    {
+      *pos++ = VALUE_CHAR(values[(ii * size) + jj]);
+      *pos++ = ' ';
+
+      if ((jj % block) == (block - 1))
+      {
+        *pos++ = ' ';
+      }
+    }
+    *pos++ = '\n';
+
+    if ((ii % block) == (block - 1))
+    {
+      *pos++ = '\n';
+    }
+  }
+
+  out->size = (size_t)(pos - out->data);
+  return;
+}
+
+void output_job(struct output *out, const sudoku_job_t *job, long count)
+{
+  add_result(out, job->line, SIZE, job->status, job->solutions, count);
+  return;
+}
+
+void output_result(struct output *out,
+                   const int *values,
+                   int size,
+                   int status,
+                   long solutions,
+                   long count)
+{
+  char line[SUDOKU_MAX_CELLS];
+  int ii;
+
+  for (ii=0; ii < (size * size); ii++)
+  {
+    line[ii] = VALUE_CHAR(values[ii]);
+  }
+
+  add_result(out, line, size, status, solutions, count);
+  return;
+}
+
+/*****************************************************************************/
+/* Adds a result, given as a line of size * size characters, as described    */
+/* for output_job().  The binary format only takes 9x9 grids.                */
+/*****************************************************************************/
+static void add_result(struct output *out,
+                       const char *line,
+                       int size,
+                       int status,
+                       long solutions,
+                       long count)
+{
+  int values[SUDOKU_MAX_CELLS];
+  unsigned long number;
+  int ii;
+  char *pos;
+
+  if (out->format == OUTPUT_BINARY)
+  {
+    /*************************************************************************/
+    /* A fixed-size record, whatever happened.                               */
+    /*************************************************************************/
+    pos = room(out, OUTPUT_RECORD_SIZE);
+    memset(pos, 0, OUTPUT_RECORD_SIZE);
+    number = (unsigned long)solutions;
+
+    pos[0] = (char)status;
+    for (ii=0; ii < 4; ii++)
+    {
+      pos[1+ii] = (char)((number >> (8 * ii)) & 0xff);
+    }
+
+    if (status == SUDOKU_SOLVED)
+    {
+      for (ii=0; ii + 1 < SUDOKU_CELLS; ii += 2)
+      {
+        pos[5 + (ii / 2)] = (char)(LINE_VALUE(line[ii]) |
+                                   (LINE_VALUE(line[ii+1]) << 4));
+      }
+      if (ii < SUDOKU_CELLS)
+      {
+        pos[5 + (ii / 2)] = (char)LINE_VALUE(line[ii]);
+      }
+    }
+    out->size += OUTPUT_RECORD_SIZE;
+    return;
+  }
+
+  if ((status == SUDOKU_SOLVED) &&
+      (out->format == OUTPUT_PRETTY))
+  {
+    for (ii=0; ii < (size * size); ii++)
+    {
+      values[ii] = LINE_VALUE(line[ii]);
+    }
+    output_grid(out, values, size);
+  }
+
+  pos = room(out, MAX_RESULT);
+
+  switch (status)
+  {
+    case SUDOKU_SOLVED:
+      if (out->format == OUTPUT_LINE)
+      {
+        memcpy(pos, line, size * size);
+        pos += size * size;
+
+        if (count > 0)
+        {
+          if (solutions == 1)
+          {
+            pos = add_text(pos, " unique");
+          }
+          else
+          {
+            pos = add_text(pos, " multiple ");
+            pos = add_number(pos, solutions);
+            pos = add_text(pos, (solutions == count) ? "+" : "");
+          }
+        }
+        *pos++ = '\n';
+      }
+      else if (count > 0)
+      {
+        pos = add_text(pos, "Solutions: ");
+        pos = add_number(pos, solutions);
+        pos = add_text(pos,
+                       (solutions == count) ? " or more" : "");
+        pos = add_text(pos,
+                       (solutions == 1) ? " (unique)\n" :
+                                          " (multiple)\n");
+      }
+      break;
+
+    case SUDOKU_NO_SOLUTION:
+      pos = add_text(pos, (out->format == OUTPUT_PRETTY) ? "\n" : "");
+      pos = add_text(pos, "No solution\n");
+      break;
+
+    case SUDOKU_BUDGET_EXCEEDED:
+      pos = add_text(pos, (out->format == OUTPUT_PRETTY) ? "\n" : "");
+      pos = add_text(pos, "Budget exceeded\n");
+      break;
+
+    default:
+      pos = add_text(pos, (out->format == OUTPUT_PRETTY) ? "\n" : "");
+      pos = add_text(pos, "Bad input\n");
+      break;
+  }
+
+  out->size = (size_t)(pos - out->data);
+  return;
+}
+
+/*****************************************************************************/
+/* Makes sure there are at least len bytes free at the end of the buffer,    */
+/* and returns where they start.  The buffer grows so that a whole batch     */
+/* block fits, but if there isn't the memory for that it's written out       */
+/* early instead.                                                            */
+/*****************************************************************************/
+static char *room(struct output *out, size_t len)
+{
+  char *bigger;
+
+  if (out->size + len > out->capacity)
+  {
+    bigger = realloc(out->data, out->capacity * 2);
+
+    if (bigger != NULL)
+    {
+      out->data = bigger;
+      out->capacity *= 2;
+    }
+    else
+    {
+      (void)output_flush(out);
+    }
+  }
+  return (out->data + out->size);
+}
+
+/*****************************************************************************/
+/* Copies a string to the buffer, and returns the position after it.         */
+/*****************************************************************************/
+static char *add_text(char *pos, const char *text)
+{
+  while (*text != '\0')
+  {
+    *pos++ = *text++;
+  }
+  return (pos);
+}
+
+/*****************************************************************************/
+/* Writes a number in decimal, and returns the position after it.            */
+/*****************************************************************************/
+static char *add_number(char *pos, long number)
+{
+  char digits[24];
+  int len = 0;
+  unsigned long left = (number < 0) ? (0ul - (unsigned long)number) :
+                                      (unsigned long)number;
+
+  do
+  {
+    digits[len++] = (char)('0' + (left % 10));
+    left /= 10;
+  } while (left != 0);
+
+  if (number < 0)
+  {
+    *pos++ = '-';
+  }
+
+  while (len > 0)
+  {
+    *pos++ = digits[--len];
+  }
+  return (pos);
+}
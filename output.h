@@ -0,0 +1,86 @@
+/*****************************************************************************/
+/* Puzzle output for the command-line programs.  Not part of the library.    */
+/*                                                                           */
+/* Results are formatted into one large buffer, which grows as needed and is */
+/* reused, and only written out when it is flushed, so a whole batch block   */
+/* goes out in a single write rather than a call to the C library for every  */
+/* line or entry.                                                            */
+/*****************************************************************************/
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdio.h>
+#include "sudoku.h"
+
+/*****************************************************************************/
+/* Output formats:                                                           */
+/*                                                                           */
+/*   pretty  the grid laid out in rows and blocks, as in the sample files    */
+/*   line    the grid as one line of digits, SUDOKU_CELLS of them, or for a  */
+/*           grid of size N, N * N, with letters from 'A' for 10 up          */
+/*   binary  a record of OUTPUT_RECORD_SIZE bytes: the status (one of the    */
+/*           library's outcomes), the number of solutions as 4 bytes, least  */
+/*           significant first, and then the solution's values, two entries  */
+/*           to a byte, the first in the low 4 bits.  The values are all 0   */
+/*           unless the puzzle was solved.  Only for 9x9 grids.              */
+/*****************************************************************************/
+#define OUTPUT_PRETTY 0
+#define OUTPUT_LINE 1
+#define OUTPUT_BINARY 2
+
+#define OUTPUT_RECORD_SIZE (5 + ((SUDOKU_CELLS + 1) / 2))
+
+struct output
+{
+  char *data;
+  size_t size;
+  size_t capacity;
+  FILE *file;
+  int format;
+  int failed;
+};
+
+/*****************************************************************************/
+/* Looks up a format by name.  Returns -1 if there's no such format.         */
+/*****************************************************************************/
+int output_format(const char *name);
+
+/*****************************************************************************/
+/* Starts output to a file in the given format.  Returns 0 if out of memory. */
+/* Closing flushes anything still in the buffer.                             */
+/*****************************************************************************/
+int output_open(struct output *out, FILE *file, int format);
+void output_close(struct output *out);
+
+/*****************************************************************************/
+/* Writes out the buffer.  Returns 0 if this or any earlier write failed.    */
+/*****************************************************************************/
+int output_flush(struct output *out);
+
+/*****************************************************************************/
+/* Adds a grid of size * size values, in the pretty layout whatever the      */
+/* format, 0 for unknown.                                                    */
+/*****************************************************************************/
+void output_grid(struct output *out, const int *values, int size);
+
+/*****************************************************************************/
+/* Adds the result of solving a puzzle in the output's format.  When         */
+/* counting solutions (count is the limit, or 0 if not), the line format     */
+/* follows a solution with " unique" or " multiple N", with a "+" if there   */
+/* may be more than N, and the pretty format with a line saying the same.    */
+/* Puzzles that weren't solved get a line saying why, except in binary.      */
+/*****************************************************************************/
+void output_job(struct output *out, const sudoku_job_t *job, long count);
+
+/*****************************************************************************/
+/* Adds the result of solving a puzzle of any size, given as its values,     */
+/* likewise.                                                                 */
+/*****************************************************************************/
+void output_result(struct output *out,
+                   const int *values,
+                   int size,
+                   int status,
+                   long solutions,
+                   long count);
+
+#endif
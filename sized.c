@@ -0,0 +1,203 @@
+/*****************************************************************************/
+/* Solver for grids of other sizes.  See sized.h.                            */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include "sized.h"
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define TRUE 1
+#define FALSE 0
+
+/*****************************************************************************/
+/* With a time limit, the clock is only read once every this many search     */
+/* nodes.                                                                    */
+/*****************************************************************************/
+#define CLOCK_INTERVAL 64
+
+/*****************************************************************************/
+/* Bit counting.  Masks are at most an unsigned long, so these take one.     */
+/*****************************************************************************/
+#if defined(__GNUC__)
+#define POPCOUNT(X) __builtin_popcountl(X)
+#define CTZ(X) __builtin_ctzl(X)
+#else
+#define POPCOUNT(X) popcount(X)
+#define CTZ(X) ctz(X)
+static int popcount(unsigned long);
+static int ctz(unsigned long);
+#endif
+
+/*****************************************************************************/
+/* Names in sized_impl.h get the block size pasted on: solve_4 and so on.    */
+/*****************************************************************************/
+#define PASTE(A,B) PASTE_AGAIN(A,B)
+#define PASTE_AGAIN(A,B) A ## _ ## B
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+static int over_budget(struct sized *);
+static double now_seconds(void);
+
+/*****************************************************************************/
+/* The copies of the solver: 4x4 and 16x16 fit their masks in 16 bits, and   */
+/* 25x25 needs 32.                                                           */
+/*****************************************************************************/
+#define BOX 2
+#define MASK unsigned short
+#include "sized_impl.h"
+#undef BOX
+#undef MASK
+
+#define BOX 4
+#define MASK unsigned short
+#include "sized_impl.h"
+#undef BOX
+#undef MASK
+
+#define BOX 5
+#if UINT_MAX >= 0x1ffffff
+#define MASK unsigned int
+#else
+#define MASK unsigned long
+#endif
+#include "sized_impl.h"
+#undef BOX
+#undef MASK
+
+/*****************************************************************************/
+/* The sizes there are solvers for.                                          */
+/*****************************************************************************/
+struct solver
+{
+  int size;
+  size_t work_size;
+  long (*solve)(struct sized *, const int *, int *);
+};
+
+static const struct solver solvers[] =
+{
+  {4, sizeof(struct work_2), solve_2},
+  {16, sizeof(struct work_4), solve_4},
+  {25, sizeof(struct work_5), solve_5},
+};
+
+#define NUM_SOLVERS ((int)(sizeof(solvers) / sizeof(solvers[0])))
+
+/*****************************************************************************/
+/* Sets up for a grid size, with no limit on the search and looking for one  */
+/* solution.                                                                 */
+/*****************************************************************************/
+int sized_init(struct sized *sz, int size)
+{
+  int ii;
+
+  memset(sz, 0, sizeof(*sz));
+
+  for (ii=0; ii < NUM_SOLVERS; ii++)
+  {
+    if (solvers[ii].size == size)
+    {
+      sz->work = malloc(solvers[ii].work_size);
+      sz->size = size;
+      sz->limit = 1;
+      return (sz->work != NULL);
+    }
+  }
+
+  return (FALSE);
+}
+
+void sized_free(struct sized *sz)
+{
+  free(sz->work);
+  sz->work = NULL;
+  return;
+}
+
+/*****************************************************************************/
+/* Solves a puzzle with the solver for the size set up.                      */
+/*****************************************************************************/
+long sized_solve(struct sized *sz, const int *values, int *solution)
+{
+  int ii;
+
+  for (ii=0; solvers[ii].size != sz->size; ii++)
+  {
+  }
+
+  return (solvers[ii].solve(sz, values, solution));
+}
+
+/*****************************************************************************/
+/* Counts a search node against the budget, reading the clock only every so  */
+/* often.  Returns TRUE once the budget is exceeded.                         */
+/*****************************************************************************/
+static int over_budget(struct sized *sz)
+{
+  sz->nodes++;
+
+  if (((sz->max_nodes > 0) &&
+       (sz->nodes > sz->max_nodes)) ||
+      ((sz->deadline > 0) &&
+       ((sz->nodes % CLOCK_INTERVAL) == 0) &&
+       (now_seconds() > sz->deadline)))
+  {
+    sz->exceeded = TRUE;
+  }
+
+  return (sz->exceeded);
+}
+
+/*****************************************************************************/
+/* Returns a wall-clock time in seconds, on the same clock as the library's. */
+/*****************************************************************************/
+static double now_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec + (now.tv_nsec / 1e9));
+#else
+  return ((double)clock() / CLOCKS_PER_SEC);
+#endif
+}
+
+#if !defined(__GNUC__)
+/*****************************************************************************/
+/* Portable bit counting, for compilers without the builtins.                */
+/*****************************************************************************/
+static int popcount(unsigned long mask)
+{
+  int count;
+
+  for (count=0; mask != 0; count++)
+  {
+    mask &= (mask - 1);
+  }
+
+  return (count);
+}
+
+static int ctz(unsigned long mask)
+{
+  int count;
+
+  for (count=0; (mask & 1) == 0; count++)
+  {
+    mask >>= 1;
+  }
+
+  return (count);
+}
+#endif
@@ -0,0 +1,64 @@
+/*****************************************************************************/
+/* Solver for grids of other sizes, used by the library for puzzles that     */
+/* aren't 9x9.  Not part of the public interface.                            */
+/*                                                                           */
+/* A grid of size N is made of N x N blocks of B x B entries, where N is B   */
+/* squared.  Each size has its own copy of the solver, built from            */
+/* sized_impl.h with the block size and the type of the candidate masks      */
+/* fixed at compile time, so the loops and masks are as tight as they can    */
+/* be for it.  The one for the size in use is picked when it's set.          */
+/*                                                                           */
+/* Each copy fixes the givens, pushes fixed values out to their peers and    */
+/* fixes hidden singles until nothing changes, then guesses at the entry     */
+/* with the fewest candidates, keeping a copy of every entry's candidates    */
+/* for each level of guessing so that a wrong guess is undone by going back  */
+/* to the copy before it.                                                    */
+/*****************************************************************************/
+#ifndef SIZED_H
+#define SIZED_H
+
+#include "sudoku.h"
+
+struct sized
+{
+  /***************************************************************************/
+  /* The grid size, and room for the search, allocated by sized_init() for   */
+  /* that size.                                                              */
+  /***************************************************************************/
+  int size;
+  void *work;
+
+  /***************************************************************************/
+  /* How many solutions to look for, and the search's budget: the most nodes */
+  /* it may visit (0 for no limit) and the time it must finish by (0 if      */
+  /* none).  Set by the caller.                                              */
+  /***************************************************************************/
+  long limit;
+  long max_nodes;
+  double deadline;
+
+  /***************************************************************************/
+  /* Filled in by the search: solutions found, nodes visited and whether it  */
+  /* ran out, values tried and taken back, times fixed values were pushed    */
+  /* out, and the deepest level of guessing.                                 */
+  /***************************************************************************/
+  long solutions;
+  long nodes;
+  int exceeded;
+  long guesses;
+  long backtracks;
+  long propagations;
+  int max_depth;
+};
+
+/*****************************************************************************/
+/* sized_init() sets up for a grid size, returning 0 if there is no solver   */
+/* for it or it's out of memory, and sized_free() frees what it allocated.   */
+/* sized_solve() solves size * size values, row by row with 0 for unknown,   */
+/* giving the first solution found, and returns how many it found.           */
+/*****************************************************************************/
+int sized_init(struct sized *, int);
+void sized_free(struct sized *);
+long sized_solve(struct sized *, const int *, int *);
+
+#endif
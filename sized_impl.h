@@ -0,0 +1,432 @@
+/*****************************************************************************/
+/* One grid size's copy of the solver, included by sized.c with BOX defined  */
+/* as the block size and MASK as an unsigned type with a bit for each value. */
+/* Every name defined here has the block size pasted on, so the copies don't */
+/* clash, and the macros are undefined again at the end, ready for the next. */
+/*****************************************************************************/
+#define N (BOX * BOX)
+#define CELLS (N * N)
+#define ALL ((MASK)((1UL << N) - 1))
+#define NAME(F) PASTE(F, BOX)
+
+/*****************************************************************************/
+/* A guess: either an entry and the values still to try there (unit is -1),  */
+/* or a unit, a value and the places in the unit still to try it.            */
+/*****************************************************************************/
+struct NAME(choice)
+{
+  int unit;
+  int entry;
+  MASK value;
+  MASK left;
+};
+
+/*****************************************************************************/
+/* Room for the search: every entry's candidates at each level of guessing,  */
+/* the guess made on each level, and the queue of entries whose value is     */
+/* still to be pushed out.                                                   */
+/*****************************************************************************/
+struct NAME(work)
+{
+  MASK cands[CELLS + 1][CELLS];
+  struct NAME(choice) choices[CELLS + 1];
+  int queue[CELLS];
+};
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+static long NAME(solve)(struct sized *, const int *, int *);
+static int NAME(propagate)(struct sized *, MASK *, int *, int);
+static int NAME(eliminate)(MASK *, int, int, MASK, int *, int *);
+static int NAME(hidden_singles)(MASK *, int *, int *);
+static int NAME(pick)(const MASK *, struct NAME(choice) *);
+static int NAME(unit_entry)(int, int);
+
+/*****************************************************************************/
+/* Solves the puzzle, looking for up to sz->limit solutions.                 */
+/*****************************************************************************/
+static long NAME(solve)(struct sized *sz, const int *values, int *solution)
+{
+  struct NAME(work) *work = sz->work;
+  struct NAME(choice) *choice;
+  MASK *cands = work->cands[0];
+  MASK bit;
+  int depth = 0;
+  int tail = 0;
+  int nn;
+  int ok;
+  int guess;
+
+  sz->solutions = 0;
+  sz->nodes = 1;
+  sz->exceeded = FALSE;
+  sz->guesses = 0;
+  sz->backtracks = 0;
+  sz->propagations = 0;
+  sz->max_depth = 0;
+
+  /***************************************************************************/
+  /* Fix the givens and push them out.  Clashes leave a peer without any     */
+  /* candidates.                                                             */
+  /***************************************************************************/
+  for (nn=0; nn < CELLS; nn++)
+  {
+    cands[nn] = ALL;
+
+    if (values[nn] > 0)
+    {
+      cands[nn] = (MASK)(1UL << (values[nn] - 1));
+      work->queue[tail++] = nn;
+    }
+  }
+
+  ok = NAME(propagate)(sz, cands, work->queue, tail);
+
+  for (;;)
+  {
+    guess = FALSE;
+
+    if (ok == TRUE)
+    {
+      cands = work->cands[depth];
+      guess = NAME(pick)(cands, &work->choices[depth]);
+
+      if (guess == TRUE)
+      {
+        /*********************************************************************/
+        /* Deduction ran out: guess below.                                   */
+        /*********************************************************************/
+        depth++;
+      }
+      else
+      {
+        /*********************************************************************/
+        /* Every entry is fixed.                                             */
+        /*********************************************************************/
+        if (sz->solutions++ == 0)
+        {
+          for (nn=0; nn < CELLS; nn++)
+          {
+            solution[nn] = CTZ(cands[nn]) + 1;
+          }
+        }
+
+        if (sz->solutions >= sz->limit)
+        {
+          break;
+        }
+      }
+    }
+
+    if ((guess == FALSE) &&
+        (depth > 0))
+    {
+      sz->backtracks++;
+    }
+
+    /*************************************************************************/
+    /* Back up to the deepest guess with something left to try, and try the  */
+    /* next on a fresh copy of the candidates from before it.                */
+    /*************************************************************************/
+    while ((depth > 0) &&
+           (work->choices[depth - 1].left == 0))
+    {
+      depth--;
+    }
+
+    if ((depth == 0) ||
+        (over_budget(sz) == TRUE))
+    {
+      break;
+    }
+
+    choice = &work->choices[depth - 1];
+    bit = choice->left & (MASK)(~choice->left + 1);
+    choice->left &= (MASK)~bit;
+    cands = work->cands[depth];
+    memcpy(cands, work->cands[depth - 1], sizeof(work->cands[0]));
+
+    if (choice->unit < 0)
+    {
+      nn = choice->entry;
+      cands[nn] = bit;
+    }
+    else
+    {
+      nn = NAME(unit_entry)(choice->unit, CTZ(bit));
+      cands[nn] = choice->value;
+    }
+    work->queue[0] = nn;
+    sz->guesses++;
+
+    if (depth > sz->max_depth)
+    {
+      sz->max_depth = depth;
+    }
+
+    ok = NAME(propagate)(sz, cands, work->queue, 1);
+  }
+
+  return (sz->solutions);
+}
+
+/*****************************************************************************/
+/* Pushes the value of each queued entry out to its peers, queuing any left  */
+/* with one candidate, then fixes hidden singles and carries on until there  */
+/* is nothing new.  Each entry is queued once at most, when it's fixed.      */
+/* Returns FALSE on a contradiction.                                         */
+/*****************************************************************************/
+static int NAME(propagate)(struct sized *sz, MASK *cands, int *queue, int tail)
+{
+  int head = 0;
+  int nn;
+  int row;
+  int col;
+  int top;
+  int left;
+  int ii;
+  MASK value;
+
+  while (head < tail)
+  {
+    while (head < tail)
+    {
+      nn = queue[head++];
+      value = cands[nn];
+      row = nn / N;
+      col = nn % N;
+      top = row - (row % BOX);
+      left = col - (col % BOX);
+      sz->propagations++;
+
+      for (ii=0; ii < N; ii++)
+      {
+        if ((NAME(eliminate)(cands, nn, (row * N) + ii,
+                             value, queue, &tail) == FALSE) ||
+            (NAME(eliminate)(cands, nn, (ii * N) + col,
+                             value, queue, &tail) == FALSE) ||
+            (NAME(eliminate)(cands, nn,
+                             ((top + (ii / BOX)) * N) + left + (ii % BOX),
+                             value, queue, &tail) == FALSE))
+        {
+          return (FALSE);
+        }
+      }
+    }
+
+    if (NAME(hidden_singles)(cands, queue, &tail) == FALSE)
+    {
+      return (FALSE);
+    }
+  }
+
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Takes an entry's fixed value away from one of its peers, queuing the      */
+/* peer if that fixes it.  The entry is a peer of itself here, and left      */
+/* alone.  Returns FALSE if the peer is left with no candidates.             */
+/*****************************************************************************/
+static int NAME(eliminate)(MASK *cands,
+                           int entry,
+                           int peer,
+                           MASK value,
+                           int *queue,
+                           int *tail)
+{
+  if ((peer == entry) ||
+      ((cands[peer] & value) == 0))
+  {
+    return (TRUE);
+  }
+
+  cands[peer] &= (MASK)~value;
+
+  if (cands[peer] == 0)
+  {
+    return (FALSE);
+  }
+
+  if ((cands[peer] & (cands[peer] - 1)) == 0)
+  {
+    queue[(*tail)++] = peer;
+  }
+
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Fixes every entry that has the only place for a value in one of its       */
+/* units, queuing it.  A value with no place, or an entry with the only      */
+/* place for two, is a contradiction, and returns FALSE.                     */
+/*****************************************************************************/
+static int NAME(hidden_singles)(MASK *cands, int *queue, int *tail)
+{
+  int entries[N];
+  int unit;
+  int ii;
+  MASK once;
+  MASK twice;
+  MASK only;
+  MASK mask;
+
+  for (unit=0; unit < (3 * N); unit++)
+  {
+    once = 0;
+    twice = 0;
+
+    for (ii=0; ii < N; ii++)
+    {
+      entries[ii] = NAME(unit_entry)(unit, ii);
+      mask = cands[entries[ii]];
+      twice |= once & mask;
+      once |= mask;
+    }
+
+    if (once != ALL)
+    {
+      return (FALSE);
+    }
+
+    only = once & (MASK)~twice;
+
+    for (ii=0; (ii < N) && (only != 0); ii++)
+    {
+      mask = cands[entries[ii]] & only;
+
+      if (mask == 0)
+      {
+        continue;
+      }
+
+      if ((mask & (mask - 1)) != 0)
+      {
+        return (FALSE);
+      }
+
+      if (cands[entries[ii]] != mask)
+      {
+        cands[entries[ii]] = mask;
+        queue[(*tail)++] = entries[ii];
+      }
+      only &= (MASK)~mask;
+    }
+  }
+
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Picks where to guess: the unfixed entry with the fewest candidates, or if */
+/* a value has fewer places left in one of the units, those places.  The     */
+/* first found wins a tie.  Returns FALSE if every entry is fixed.           */
+/*****************************************************************************/
+static int NAME(pick)(const MASK *cands, struct NAME(choice) *choice)
+{
+  MASK places[N];
+  MASK fixed;
+  MASK mask;
+  int fewest = N + 1;
+  int count;
+  int unit;
+  int nn;
+  int ii;
+
+  for (nn=0; nn < CELLS; nn++)
+  {
+    if ((cands[nn] & (cands[nn] - 1)) != 0)
+    {
+      count = POPCOUNT(cands[nn]);
+
+      if (count < fewest)
+      {
+        choice->unit = -1;
+        choice->entry = nn;
+        choice->left = cands[nn];
+        fewest = count;
+
+        if (count == 2)
+        {
+          return (TRUE);
+        }
+      }
+    }
+  }
+
+  if (fewest > N)
+  {
+    return (FALSE);
+  }
+
+  /***************************************************************************/
+  /* Count the places each value not yet fixed in a unit has left there.     */
+  /* Propagation leaves every one at least two.                              */
+  /***************************************************************************/
+  for (unit=0; unit < (3 * N); unit++)
+  {
+    fixed = 0;
+    memset(places, 0, sizeof(places));
+
+    for (ii=0; ii < N; ii++)
+    {
+      mask = cands[NAME(unit_entry)(unit, ii)];
+
+      if ((mask & (mask - 1)) == 0)
+      {
+        fixed |= mask;
+        continue;
+      }
+
+      for (; mask != 0; mask &= (MASK)(mask - 1))
+      {
+        places[CTZ(mask)] |= (MASK)(1UL << ii);
+      }
+    }
+
+    for (ii=0; ii < N; ii++)
+    {
+      if ((fixed & (MASK)(1UL << ii)) != 0)
+      {
+        continue;
+      }
+
+      count = POPCOUNT(places[ii]);
+
+      if (count < fewest)
+      {
+        choice->unit = unit;
+        choice->value = (MASK)(1UL << ii);
+        choice->left = places[ii];
+        fewest = count;
+
+        if (count == 2)
+        {
+          return (TRUE);
+        }
+      }
+    }
+  }
+
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Entry ii of a unit: units 0 to N-1 are the rows, then the columns, then   */
+/* the blocks, each read row by row.                                         */
+/*****************************************************************************/
+static int NAME(unit_entry)(int unit, int ii)
+{
+  int kk = unit % N;
+
+  return ((unit < N) ? ((kk * N) + ii) :
+          (unit < (2 * N)) ? ((ii * N) + kk) :
+          ((((kk - (kk % BOX)) + (ii / BOX)) * N) +
+           ((kk % BOX) * BOX) + (ii % BOX)));
+}
+
+#undef N
+#undef CELLS
+#undef ALL
+#undef NAME
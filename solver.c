@@ -0,0 +1,4865 @@
+/*****************************************************************************/
+/* Sudoku solver library.  See sudoku.h for the interface.                   */
+/*                                                                           */
+/* Add #define DEBUG for debug build.                                        */
+/* Add #define NO_THREADS to build without POSIX threads.                    */
+/* Add #define NO_SIMD to build without the vector propagation kernels.      */
+/* Add #define NO_STATS to build without the solve counters.                 */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+#include "sudoku.h"
+#include "units.h"
+#include "dlx.h"
+#include "cdcl.h"
+#include "canon.h"
+#include "cache.h"
+#include "sized.h"
+
+/*****************************************************************************/
+/* The vector kernels need x86 and a compiler that can build functions for   */
+/* instruction sets beyond the one it's targeting.  Whether the processor    */
+/* actually has them is checked at run time.                                 */
+/*****************************************************************************/
+#if defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(NO_SIMD)
+#define HAVE_SIMD
+#include <immintrin.h>
+#endif
+
+/*****************************************************************************/
+/* Lockstep solving packs a batch's puzzles into the lanes of vectors, one   */
+/* vector per entry, and deduces on all of them at once using the compiler's */
+/* vector extensions.  It needs a compiler that has them.                    */
+/*****************************************************************************/
+#if defined(__GNUC__)
+#define HAVE_LOCKSTEP
+#define LANES 16
+
+typedef unsigned short lanes_t __attribute__((vector_size(2 * LANES)));
+
+/*****************************************************************************/
+/* Masks with every bit set in the lanes where X is non-zero, or zero.  The  */
+/* sign bit of X | -X says which.  Comparisons would do, but compilers split */
+/* them up lane by lane when the vectors are wider than the target's.  These */
+/* work on the vector "zero" in scope.                                       */
+/*****************************************************************************/
+#define LANES_NONZERO(X) (zero - (((X) | (zero - (X))) >> 15))
+#define LANES_ZERO(X) (~LANES_NONZERO(X))
+#endif
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define SIZE SUDOKU_SIZE
+#define BLOCK_SIZE 3
+#define TRUE 1
+#define FALSE 0
+
+/*****************************************************************************/
+/* Candidate mask with every number 1 to SIZE still possible.                */
+/*****************************************************************************/
+#define ALL_CANDIDATES ((1 << SIZE) - 1)
+
+/*****************************************************************************/
+/* Assert macro.                                                             */
+/*****************************************************************************/
+#ifdef DEBUG
+#define ASSERT(X) assert(X)
+#else
+#define ASSERT(X)
+#endif
+
+/*****************************************************************************/
+/* Counter macro.  Adds N to the named counter of the solver "sv" in scope.  */
+/*****************************************************************************/
+#ifdef NO_STATS
+#define STAT(F,N)
+#define STAT_CLOCK() (0.0)
+#else
+#define STAT(F,N) (sv->stats.F += (N))
+#define STAT_CLOCK() now_seconds()
+#endif
+
+/*****************************************************************************/
+/* With a time limit, the clock is only read once every this many search     */
+/* nodes.                                                                    */
+/*****************************************************************************/
+#define CLOCK_INTERVAL 64
+
+/*****************************************************************************/
+/* Bit counting.  Use the compiler's builtins where we know they exist (they */
+/* compile to single instructions on most targets) and fall back to portable */
+/* loops elsewhere.                                                          */
+/*****************************************************************************/
+#if defined(__GNUC__)
+#define POPCOUNT(X) __builtin_popcount(X)
+#define CTZ(X) __builtin_ctz(X)
+#else
+#define POPCOUNT(X) popcount(X)
+#define CTZ(X) ctz(X)
+static int popcount(unsigned int);
+static int ctz(unsigned int);
+#endif
+
+/*****************************************************************************/
+/* Flags shared between threads are read and written through these, so that  */
+/* a thread is sure to see another's change.                                 */
+/*****************************************************************************/
+#if defined(__GNUC__)
+#define ATOMIC_LOAD(P) __atomic_load_n(P, __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(P,V) __atomic_store_n(P, V, __ATOMIC_RELEASE)
+#else
+#define ATOMIC_LOAD(P) (*(volatile int *)(P))
+#define ATOMIC_STORE(P,V) (*(volatile int *)(P) = (V))
+#endif
+
+/*****************************************************************************/
+/* Prototypes.  Everything to do with solving a puzzle works on a solver     */
+/* context, so several puzzles can be solved at once on different threads.   */
+/*****************************************************************************/
+struct worker;
+struct search;
+struct race;
+struct rng;
+
+static void clear_grid(sudoku_solver_t *);
+static int load_line(sudoku_solver_t *, const char *);
+static int load_values(sudoku_solver_t *, const int *);
+static void grid_values(const sudoku_solver_t *, int *);
+static int load_sized(sudoku_solver_t *, const int *);
+static int entry_value(char);
+static void solve_jobs(sudoku_solver_t *, sudoku_job_t *, long, long);
+static void finish_job(sudoku_solver_t *, sudoku_job_t *, int, double);
+static void bad_job(sudoku_job_t *);
+static void run_batch(sudoku_solver_t *,
+                      sudoku_job_t *,
+                      long,
+                      void (*)(sudoku_solver_t *, sudoku_job_t *, long, long));
+static void generate_jobs(sudoku_solver_t *, sudoku_job_t *, long, long);
+static void generate_one(sudoku_solver_t *, sudoku_job_t *, long);
+static int random_grid(sudoku_solver_t *,
+                       struct rng *,
+                       int *,
+                       sudoku_stats_t *);
+static int random_entries(sudoku_solver_t *, struct rng *, int *);
+static int remove_clues(sudoku_solver_t *,
+                        struct rng *,
+                        const int *,
+                        int *,
+                        sudoku_stats_t *);
+static int still_unique(sudoku_solver_t *,
+                        const int *,
+                        const int *,
+                        const int *,
+                        int,
+                        sudoku_stats_t *);
+static int solvable(sudoku_solver_t *,
+                    const int *,
+                    int,
+                    int,
+                    sudoku_stats_t *);
+static int orbit(const sudoku_solver_t *, int, int *);
+static int map_half_turn(int);
+static int map_quarter_turn(int);
+static int map_mirror(int);
+static int map_diagonal(int);
+static void rng_seed(struct rng *, unsigned long);
+static unsigned long rng_next(struct rng *);
+static void add_stats(sudoku_stats_t *, const sudoku_stats_t *);
+#ifndef NO_THREADS
+static void run_workers(struct worker *, int, long);
+static void *worker_main(void *);
+static int take_job(struct worker *, long *);
+static int solve_parallel(sudoku_solver_t *);
+static void solve_subproblem(sudoku_solver_t *, struct search *, long);
+static int solve_portfolio(sudoku_solver_t *);
+static void race_member(sudoku_solver_t *, struct race *, long);
+static int race_lost(sudoku_solver_t *);
+#endif
+static int solve_logic(sudoku_solver_t *);
+static long luby_run(long);
+static long geometric_run(long);
+static unsigned short random_candidate(sudoku_solver_t *, unsigned short);
+static int solve_cached(sudoku_solver_t *, int (*)(sudoku_solver_t *));
+static int attempt_to_solve(sudoku_solver_t *);
+static int found_solution(sudoku_solver_t *);
+static int first_solution(sudoku_solver_t *);
+static void start_budget(sudoku_solver_t *);
+static int over_budget(sudoku_solver_t *);
+static int outcome(const sudoku_solver_t *, int);
+static int solve_dlx(sudoku_solver_t *);
+static int solve_cdcl(sudoku_solver_t *);
+static int solve_auto(sudoku_solver_t *);
+static int predict_route(sudoku_solver_t *);
+static int fill_solution(sudoku_solver_t *, const int *, long);
+static int solve_sized(sudoku_solver_t *);
+static int propagate(sudoku_solver_t *);
+static int eliminate_peers(sudoku_solver_t *, int, int, int, long *);
+#ifdef HAVE_SIMD
+static int propagate_sse2(sudoku_solver_t *);
+static int propagate_avx2(sudoku_solver_t *);
+static unsigned short entry_fixed(const sudoku_solver_t *, int);
+static int have_sse2(void);
+static int have_avx2(void);
+static inline __attribute__((always_inline))
+int kernel_update(sudoku_solver_t *, int, int, unsigned short, int *);
+#endif
+#ifdef HAVE_LOCKSTEP
+static long solve_pack(sudoku_solver_t *, sudoku_job_t *, long, long);
+static void load_lane(sudoku_solver_t *, const lanes_t *, int);
+static void lockstep_plain(const sudoku_solver_t *, lanes_t *, lanes_t *);
+#ifdef HAVE_SIMD
+static void lockstep_avx2(const sudoku_solver_t *, lanes_t *, lanes_t *);
+#endif
+#endif
+static int eliminate(sudoku_solver_t *, int, int, unsigned short);
+static void note_fixed(sudoku_solver_t *, int, int);
+static void trail_set(sudoku_solver_t *, unsigned short *, unsigned short);
+static void undo_to(sudoku_solver_t *, int);
+static void fix_entry(sudoku_solver_t *, int, int, unsigned short);
+static void build_tables(sudoku_solver_t *);
+static int deduce(sudoku_solver_t *);
+static int rule_hidden_single(sudoku_solver_t *);
+static int locked_candidates(sudoku_solver_t *, int);
+static int rule_pointing(sudoku_solver_t *);
+static int rule_claiming(sudoku_solver_t *);
+static int naked_subset(sudoku_solver_t *, int);
+static int hidden_subset(sudoku_solver_t *, int);
+static int rule_naked_pair(sudoku_solver_t *);
+static int rule_naked_triple(sudoku_solver_t *);
+static int rule_hidden_pair(sudoku_solver_t *);
+static int rule_hidden_triple(sudoku_solver_t *);
+static void pick_first(sudoku_solver_t *, int *, int *);
+static void pick_mrv(sudoku_solver_t *, int *, int *);
+static void pick_mrv_degree(sudoku_solver_t *, int *, int *);
+static int unfixed_peers(sudoku_solver_t *, int);
+static int random_tie(sudoku_solver_t *, int *);
+static double now_seconds(void);
+#ifdef DEBUG
+static int number_known(sudoku_solver_t *);
+#endif
+#if defined(DEBUG) || !defined(NO_STATS)
+static int do_check(sudoku_solver_t *);
+#endif
+
+/*****************************************************************************/
+/* Solution array.                                                           */
+/*                                                                           */
+/* Each entry holds its candidate list as a bit mask: bit N-1 is set if N is */
+/* still a candidate.  The number of candidates is the population count of   */
+/* the mask and, once there is only one, the fixed value is found from the   */
+/* number of trailing zeros.                                                 */
+/*                                                                           */
+/* We trade off a little storage for speed by also keeping, for each unit,   */
+/* a mask of the values already fixed in it, and a running count of the      */
+/* fixed entries.                                                            */
+/*                                                                           */
+/* Once the puzzle is loaded, every change to a mask goes through            */
+/* trail_set() so that it can be undone when a guess turns out wrong.        */
+/*****************************************************************************/
+struct grid
+{
+  unsigned short cand[SIZE][SIZE];
+  unsigned short unit_fixed[UNITS_MAX];
+  int known;
+};
+
+/*****************************************************************************/
+/* Undo trail.  Each entry records a mask and the value it held before it    */
+/* was changed.  Backtracking pops entries back to the mark taken before the */
+/* guess, so undoing costs only as much as the changes made since.           */
+/*                                                                           */
+/* Masks only ever lose candidates or gain fixed values, so the trail can't  */
+/* hold more than SIZE changes per entry plus SIZE per unit between them.    */
+/*****************************************************************************/
+#define TRAIL_SIZE ((SIZE*SIZE*SIZE) + (UNITS_MAX*SIZE))
+
+struct trail_entry
+{
+  unsigned short *where;
+  unsigned short old;
+};
+
+/*****************************************************************************/
+/* Handy macros.  These work on the solver context "sv" in scope.            */
+/*****************************************************************************/
+#define CANDS(X,Y) sv->grid.cand[X][Y]
+#define CAND_COUNT(X,Y) POPCOUNT(CANDS(X,Y))
+#define FIXED_VAL(X,Y) (CTZ(CANDS(X,Y)) + 1)
+#define IS_FIXED(X,Y) ((CANDS(X,Y) & (CANDS(X,Y) - 1)) == 0)
+
+/*****************************************************************************/
+/* Branching heuristics.  When logic runs out, attempt_to_solve() asks the   */
+/* selected heuristic which still-ambiguous entry to guess at next.  The     */
+/* first one listed is the default.                                          */
+/*****************************************************************************/
+static const struct brancher
+{
+  const char *name;
+  void (*pick)(sudoku_solver_t *, int *, int *);
+} branchers[] =
+{
+  {"mrv-degree", pick_mrv_degree},
+  {"mrv",        pick_mrv},
+  {"first",      pick_first}
+};
+
+#define NUM_BRANCHERS ((int)(sizeof(branchers) / sizeof(branchers[0])))
+
+/*****************************************************************************/
+/* Restart policies.  With one, the logic engine gives up on its search      */
+/* after a number of nodes and starts again from the top, guessing in a new  */
+/* random order, each run allowed the base number of nodes times the policy  */
+/* function of how many runs have gone before.  The first one listed, no     */
+/* restarts, is the default.                                                 */
+/*****************************************************************************/
+static const struct restart
+{
+  const char *name;
+  long (*run)(long);
+} restarts[] =
+{
+  {"none",      NULL},
+  {"luby",      luby_run},
+  {"geometric", geometric_run}
+};
+
+#define NUM_RESTARTS ((int)(sizeof(restarts) / sizeof(restarts[0])))
+
+/*****************************************************************************/
+/* Engines.  "logic" is candidate elimination and the deduction rules, with  */
+/* guessing when they run out.  Only it uses the branching heuristics and    */
+/* restarts, and only it can split its search between threads or race        */
+/* differently configured searches on them.                                  */
+/* "dlx" solves the puzzle as an exact cover problem with Dancing Links.     */
+/* "cdcl" searches with nogood learning and backjumping (see cdcl.h).        */
+/* "auto" routes each puzzle to the logic engine's deduction, its search or  */
+/* dlx (see solve_auto()).  It and the logic engine use the rules, and can   */
+/* solve a batch in lockstep.                                                */
+/* The first one listed is the default.                                      */
+/*****************************************************************************/
+static const struct engine
+{
+  const char *name;
+  int (*solve)(sudoku_solver_t *);
+  int uses_rules;
+  int can_split;
+  int can_race;
+  int can_lockstep;
+} engines[] =
+{
+  {"logic", solve_logic, TRUE,  TRUE,  TRUE,  TRUE},
+  {"dlx",   solve_dlx,   FALSE, FALSE, FALSE, FALSE},
+  {"cdcl",  solve_cdcl,  FALSE, FALSE, FALSE, FALSE},
+  {"auto",  solve_auto,  TRUE,  FALSE, FALSE, TRUE}
+};
+
+#define NUM_ENGINES ((int)(sizeof(engines) / sizeof(engines[0])))
+
+/*****************************************************************************/
+/* The routes the auto engine can send a puzzle down, by their SUDOKU_ROUTE_ */
+/* numbers.                                                                  */
+/*****************************************************************************/
+static const char *const route_names[] =
+{
+  "none",
+  "deduction",
+  "search",
+  "dlx"
+};
+
+#define NUM_ROUTES ((int)(sizeof(route_names) / sizeof(route_names[0])))
+
+/*****************************************************************************/
+/* The auto engine expects the logic engine's search to be quicker than dlx  */
+/* on a puzzle where the entries the deduction fixed beyond the clues, and   */
+/* twice those it left with two candidates, come to ROUTE_PROGRESS or more,  */
+/* and lets it take up to PROBE_NODES nodes before giving the puzzle to dlx  */
+/* after all.  Both were fitted to the per-puzzle times of both routes on    */
+/* generated puzzles kept apart from bench/: 20,000 from --seed=1000000 and  */
+/* the 1,500 hardest of 150,000 from --seed=5000000.  They hold the slower   */
+/* of the two sets to within 7% of the better engine for it; no score tried  */
+/* told the two kinds of puzzle apart well enough to beat that.              */
+/*****************************************************************************/
+#define ROUTE_PROGRESS 30
+#define PROBE_NODES 32
+
+/*****************************************************************************/
+/* Propagation kernels.  Each pushes newly fixed values out to their peers   */
+/* until nothing more changes, and they all reach the same result.  The      */
+/* scalar one works through a queue of newly fixed entries; the vector ones  */
+/* instead apply every unit's mask of fixed values to a whole row of entries */
+/* at a time.  A new context uses the first one listed that the processor    */
+/* supports.                                                                 */
+/*****************************************************************************/
+static const struct kernel
+{
+  const char *name;
+  int (*propagate)(sudoku_solver_t *);
+  int (*supported)(void);
+} kernels[] =
+{
+#ifdef HAVE_SIMD
+  {"avx2",   propagate_avx2, have_avx2},
+  {"sse2",   propagate_sse2, have_sse2},
+#endif
+  {"scalar", propagate,      NULL}
+};
+
+#define NUM_KERNELS ((int)(sizeof(kernels) / sizeof(kernels[0])))
+
+/*****************************************************************************/
+/* Puzzle variants, each with its own units (see units.h): the rows, columns */
+/* and blocks, then X-Sudoku's diagonals or windoku's windows as well, or a  */
+/* jigsaw puzzle's regions in place of the blocks.  Until a jigsaw puzzle's  */
+/* regions are given, they are the blocks.  The first one listed is the      */
+/* default.                                                                  */
+/*****************************************************************************/
+static const struct variant
+{
+  const char *name;
+  int diagonals;
+  int windows;
+  int regions;
+} variants[] =
+{
+  {"standard", FALSE, FALSE, FALSE},
+  {"x",        TRUE,  FALSE, FALSE},
+  {"windoku",  FALSE, TRUE,  FALSE},
+  {"jigsaw",   FALSE, FALSE, TRUE}
+};
+
+#define NUM_VARIANTS ((int)(sizeof(variants) / sizeof(variants[0])))
+
+/*****************************************************************************/
+/* The candidates of entry K of unit U.                                      */
+/*****************************************************************************/
+#define UNIT_CANDS(U,K) \
+  sv->grid.cand[sv->units.entries[U][K] / SIZE] \
+               [sv->units.entries[U][K] % SIZE]
+
+/*****************************************************************************/
+/* Every mask of two or three values (or unit positions), for the subset     */
+/* rules.                                                                    */
+/*****************************************************************************/
+#define MAX_SUBSET 3
+#define MAX_SUBSETS 84
+
+/*****************************************************************************/
+/* Deduction rules.  Beyond simply propagating fixed values, deduce() tries  */
+/* each active rule in turn until the grid stops changing.  A rule returns   */
+/* how many times it made progress, or CONTRADICTION.  The active rules and  */
+/* their order are configurable.  By default only hidden singles are used:   */
+/* the others cut the number of guesses further but, on typical puzzles,     */
+/* cost more time than the guesses they save.                                */
+/*****************************************************************************/
+#define CONTRADICTION (-1)
+
+static const struct rule
+{
+  const char *name;
+  int (*apply)(sudoku_solver_t *);
+} rules[] =
+{
+  {"hidden-single", rule_hidden_single},
+  {"pointing",      rule_pointing},
+  {"claiming",      rule_claiming},
+  {"naked-pair",    rule_naked_pair},
+  {"hidden-pair",   rule_hidden_pair},
+  {"naked-triple",  rule_naked_triple},
+  {"hidden-triple", rule_hidden_triple}
+};
+
+#define NUM_RULES ((int)(sizeof(rules) / sizeof(rules[0])))
+
+/*****************************************************************************/
+/* Symmetries a generated puzzle's clues can be made to have.  Each maps an  */
+/* entry (row * SIZE + column) to where the symmetry takes it; an entry's    */
+/* orbit is every entry it reaches by doing that over and over, and a clue   */
+/* is only removed along with the rest of its orbit.  The first one listed,  */
+/* no symmetry, is the default.                                              */
+/*****************************************************************************/
+static const struct symmetry
+{
+  const char *name;
+  int (*map)(int);
+} symmetries[] =
+{
+  {"none",       NULL},
+  {"rotational", map_half_turn},
+  {"quarter",    map_quarter_turn},
+  {"mirror",     map_mirror},
+  {"diagonal",   map_diagonal}
+};
+
+#define NUM_SYMMETRIES ((int)(sizeof(symmetries) / sizeof(symmetries[0])))
+
+/*****************************************************************************/
+/* The generator's random numbers come from xoshiro128**: small, fast and    */
+/* good enough by some way, with 32-bit words kept in unsigned longs.  Each  */
+/* puzzle gets its own generator, seeded from the batch's seed and its       */
+/* number, so the puzzles don't depend on how the threads share them out.    */
+/*****************************************************************************/
+#define RNG_MASK 0xffffffffUL
+#define ROTATE(X,K) ((((X) << (K)) | ((X) >> (32 - (K)))) & RNG_MASK)
+
+struct rng
+{
+  unsigned long state[4];
+};
+
+/*****************************************************************************/
+/* The generator starts again from a new grid if removing clues leaves more  */
+/* than the target, up to this many times.                                   */
+/*****************************************************************************/
+#define GENERATE_ATTEMPTS 100
+
+/*****************************************************************************/
+/* Random values a random grid starts from for variants other than the       */
+/* standard one.                                                             */
+/*****************************************************************************/
+#define RANDOM_ENTRIES (2*SIZE)
+
+/*****************************************************************************/
+/* Solver context.  The library keeps no state of its own: the               */
+/* configuration, the lookup tables and everything that changes while        */
+/* solving a puzzle all live here.                                           */
+/*****************************************************************************/
+struct sudoku_solver
+{
+  /***************************************************************************/
+  /* The puzzle being solved, how many clues it had when it was loaded, and  */
+  /* whether deduction has already taken it as far as it goes, so the search */
+  /* needn't start by deducing again.                                        */
+  /***************************************************************************/
+  struct grid grid;
+  int clues;
+  int deduced;
+
+  /***************************************************************************/
+  /* Entries that have been fixed but whose value hasn't yet been eliminated */
+  /* from their peers, stored as row * SIZE + column.  Each entry is fixed   */
+  /* at most once between guesses, so the queue never needs to wrap.         */
+  /***************************************************************************/
+  unsigned char queue[SIZE*SIZE];
+  int queue_head;
+  int queue_tail;
+
+  /***************************************************************************/
+  /* Set when an entry is fixed at a value already fixed in one of its       */
+  /* units.  Propagation reports it as a contradiction.                      */
+  /***************************************************************************/
+  int clash;
+
+  /***************************************************************************/
+  /* The undo trail.                                                         */
+  /***************************************************************************/
+  struct trail_entry trail[TRAIL_SIZE];
+  int trail_top;
+
+  /***************************************************************************/
+  /* Recursion depth tracking, how often each rule made progress, and the    */
+  /* other counters for the solve.  Rule hits are indexed like rules[].      */
+  /***************************************************************************/
+  int max_rec_depth;
+  int cur_rec_depth;
+  long rule_hits[NUM_RULES];
+  sudoku_stats_t stats;
+
+  /***************************************************************************/
+  /* If not NULL, the search gives up as soon as this becomes non-zero.      */
+  /***************************************************************************/
+  const int *stop;
+
+  /***************************************************************************/
+  /* The current solve's budget: search nodes so far, the time it must       */
+  /* finish by (0 if none), and whether it has run out.  Once it has, the    */
+  /* search gives up.                                                        */
+  /***************************************************************************/
+  long nodes;
+  double deadline;
+  int exceeded;
+
+  /***************************************************************************/
+  /* When restarting, the nodes the current run may go up to and whether it  */
+  /* has got there, whether to guess in random order, and the random numbers */
+  /* for it.                                                                 */
+  /***************************************************************************/
+  long run_limit;
+  int run_over;
+  int randomize;
+  struct rng rng;
+
+  /***************************************************************************/
+  /* The race this context is running in, or NULL if it isn't in one.        */
+  /***************************************************************************/
+  struct race *race;
+
+  /***************************************************************************/
+  /* Solutions found so far by the search, and a copy of the first.          */
+  /***************************************************************************/
+  long num_solutions;
+  struct grid solution;
+
+  /***************************************************************************/
+  /* Configuration: the variant, the engine, the propagation kernel, the     */
+  /* branching heuristic, the active deduction rules in the order they're    */
+  /* tried, how many threads to use, whether to solve batches in lockstep,   */
+  /* how many solutions to look for, and the most nodes and seconds a solve  */
+  /* may take (0 for no limit).                                              */
+  /***************************************************************************/
+  const struct variant *variant;
+  const struct engine *engine;
+  const struct kernel *kernel;
+  const struct brancher *brancher;
+  const struct rule *active_rules[NUM_RULES];
+  int num_active_rules;
+  int num_threads;
+  int lockstep;
+  long count_limit;
+  long max_nodes;
+  double max_seconds;
+
+  /***************************************************************************/
+  /* Configuration for restarting: the policy, the nodes in its first run,   */
+  /* the seed for the random order of guesses, and whether to race searches  */
+  /* on the threads rather than splitting one between them.                  */
+  /***************************************************************************/
+  const struct restart *restart;
+  long restart_nodes;
+  unsigned long search_seed;
+  int portfolio;
+
+  /***************************************************************************/
+  /* Configuration for generating puzzles: the symmetry, and the most clues  */
+  /* to leave (0 for as few as possible).  The seed is the current batch's.  */
+  /***************************************************************************/
+  const struct symmetry *symmetry;
+  int target_clues;
+  unsigned long seed;
+
+  /***************************************************************************/
+  /* The result cache, or NULL if there isn't one.                           */
+  /***************************************************************************/
+  sudoku_cache_t *cache;
+
+  /***************************************************************************/
+  /* Lookup tables: the variant's units, and the subsets for the deduction   */
+  /* rules, built by build_tables().                                         */
+  /***************************************************************************/
+  struct units units;
+  unsigned short subsets[MAX_SUBSET+1][MAX_SUBSETS];
+  int num_subsets[MAX_SUBSET+1];
+
+  /***************************************************************************/
+  /* The dlx engine's matrix, and the cdcl engine's search state.            */
+  /***************************************************************************/
+  struct dlx dlx;
+  struct cdcl cdcl;
+
+  /***************************************************************************/
+  /* Grids of other sizes: the size (SIZE if it's the usual one), the        */
+  /* values of the puzzle's entries, or after a successful solve the         */
+  /* solution's, and the solver for the size.                                */
+  /***************************************************************************/
+  int size;
+  int values[SUDOKU_MAX_CELLS];
+  struct sized sized;
+
+  /***************************************************************************/
+  /* Room for working out canonical forms of puzzles for the cache.          */
+  /***************************************************************************/
+  struct canon_work canon;
+};
+
+#ifndef NO_THREADS
+/*****************************************************************************/
+/* Parallel search of a single puzzle.  The top few levels of guesses are    */
+/* expanded into independent subproblems, each a partly-solved grid, which   */
+/* the workers then search.  The subproblems share no solutions, so their    */
+/* counts add up; once there are as many as we're looking for (by default,   */
+/* the first) the rest are stopped.  The count and the first solution found  */
+/* are guarded by the lock.                                                  */
+/*****************************************************************************/
+#define SPLIT_PER_THREAD 8
+
+struct search
+{
+  struct grid *subproblems;
+  long num_subproblems;
+  int stop;
+  pthread_mutex_t lock;
+  long num_solutions;
+  struct grid solution;
+};
+
+/*****************************************************************************/
+/* A portfolio race.  Each thread searches the whole puzzle in its own way:  */
+/* the first with the context's own configuration, and the rest restarting   */
+/* with the Luby and geometric policies in turn, each with a seed of its     */
+/* own, and with the default branching heuristic and plain minimum           */
+/* remaining values in turn for every two.  The winner is the search that    */
+/* finishes in the fewest nodes, the earliest on a tie, rather than the      */
+/* first to finish, so the answer doesn't depend on how the threads are      */
+/* scheduled: every search is reproducible, and one that has gone past the   */
+/* winner's nodes so far can give up as it can no longer win.  Each search   */
+/* starts from a copy of the context, start.  The winner's nodes, solutions  */
+/* and counters are kept, and the counters of every search added up in case  */
+/* they all run out of budget, guarded by the lock.                          */
+/*****************************************************************************/
+struct race
+{
+  const sudoku_solver_t *start;
+  pthread_mutex_t lock;
+  long winner;
+  long nodes;
+  long num_solutions;
+  struct grid solution;
+  int max_depth;
+  long rule_hits[NUM_RULES];
+  sudoku_stats_t stats;
+  sudoku_stats_t spent;
+};
+
+/*****************************************************************************/
+/* Worker threads.  Each worker owns a range of jobs (puzzles in a batch,    */
+/* subproblems of a parallel search, or searches in a race) and takes jobs   */
+/* from the front of it.  A worker that runs out steals the back half of     */
+/* another worker's remaining range, so a few slow jobs can't leave the      */
+/* other threads idle.  The range is guarded by the lock.  Each worker has   */
+/* its own copy of the solver context.                                       */
+/*                                                                           */
+/* A batch job is a group of JOB_GROUP puzzles, enough to fill a lockstep    */
+/* pack, with the last group taking whatever is left over, which the batch   */
+/* function either solves or generates.                                      */
+/*****************************************************************************/
+#define JOB_GROUP 16
+
+struct worker
+{
+  pthread_t thread;
+  pthread_mutex_t lock;
+  long next;
+  long end;
+  int id;
+  int num_workers;
+  int started;
+  sudoku_job_t *jobs;
+  long num_jobs;
+  void (*batch)(sudoku_solver_t *, sudoku_job_t *, long, long);
+  struct search *search;
+  struct race *race;
+  struct worker *all;
+  sudoku_solver_t solver;
+};
+#endif
+
+/*****************************************************************************/
+/* Creates a solver context with the default configuration and an empty      */
+/* grid.                                                                     */
+/*****************************************************************************/
+sudoku_solver_t *sudoku_init(void)
+{
+  sudoku_solver_t *sv;
+
+  sv = malloc(sizeof(*sv));
+
+  if (sv == NULL)
+  {
+    goto EXIT;
+  }
+
+  sv->variant = &variants[0];
+  sv->engine = &engines[0];
+  for (sv->kernel = kernels;
+       (sv->kernel->supported != NULL) && (sv->kernel->supported() == FALSE);
+       sv->kernel++)
+  {
+  }
+  sv->brancher = &branchers[0];
+  sv->active_rules[0] = &rules[0];
+  sv->num_active_rules = 1;
+  sv->num_threads = 1;
+  sv->lockstep = FALSE;
+  sv->count_limit = 1;
+  sv->max_nodes = 0;
+  sv->max_seconds = 0;
+  sv->restart = &restarts[0];
+  sv->restart_nodes = SUDOKU_RESTART_NODES;
+  sv->search_seed = 0;
+  sv->portfolio = FALSE;
+  sv->run_limit = 0;
+  sv->run_over = FALSE;
+  sv->randomize = FALSE;
+  sv->race = NULL;
+  sv->symmetry = &symmetries[0];
+  sv->target_clues = 0;
+  sv->seed = 0;
+  sv->cache = NULL;
+  sv->size = SIZE;
+  sv->sized.work = NULL;
+  (void)units_build(&sv->units, NULL, FALSE, FALSE);
+  build_tables(sv);
+  dlx_init(&sv->dlx, &sv->units);
+  clear_grid(sv);
+
+EXIT:
+
+  return (sv);
+}
+
+void sudoku_free(sudoku_solver_t *sv)
+{
+  sized_free(&sv->sized);
+  free(sv);
+  return;
+}
+
+/*****************************************************************************/
+/* Looks the engine up by name.                                              */
+/*****************************************************************************/
+int sudoku_set_engine(sudoku_solver_t *sv, const char *name)
+{
+  int ii;
+
+  for (ii=0; ii < NUM_ENGINES; ii++)
+  {
+    if (strcmp(name, engines[ii].name) == 0)
+    {
+      sv->engine = &engines[ii];
+      return (TRUE);
+    }
+  }
+  return (FALSE);
+}
+
+/*****************************************************************************/
+/* Looks the propagation kernel up by name.  It must be one the processor    */
+/* supports.                                                                 */
+/*****************************************************************************/
+int sudoku_set_kernel(sudoku_solver_t *sv, const char *name)
+{
+  int ii;
+
+  for (ii=0; ii < NUM_KERNELS; ii++)
+  {
+    if ((strcmp(name, kernels[ii].name) == 0) &&
+        ((kernels[ii].supported == NULL) ||
+         (kernels[ii].supported() == TRUE)))
+    {
+      sv->kernel = &kernels[ii];
+      return (TRUE);
+    }
+  }
+  return (FALSE);
+}
+
+/*****************************************************************************/
+/* Looks the branching heuristic up by name.                                 */
+/*****************************************************************************/
+int sudoku_set_branching(sudoku_solver_t *sv, const char *name)
+{
+  int ii;
+
+  for (ii=0; ii < NUM_BRANCHERS; ii++)
+  {
+    if (strcmp(name, branchers[ii].name) == 0)
+    {
+      sv->brancher = &branchers[ii];
+      return (TRUE);
+    }
+  }
+  return (FALSE);
+}
+
+/*****************************************************************************/
+/* Sets up the active deduction rules from a comma-separated list of names,  */
+/* in the order given.  "none" turns them all off; an empty list is refused  */
+/* like an unknown name, rather than taken to mean the same.                 */
+/*****************************************************************************/
+int sudoku_set_rules(sudoku_solver_t *sv, const char *list)
+{
+  const struct rule *active[NUM_RULES];
+  int num_active = 0;
+  int ii;
+  int jj;
+  size_t len;
+  int rc = TRUE;
+
+  if (strcmp(list, "none") == 0)
+  {
+    goto DONE;
+  }
+
+  if (*list == '\0')
+  {
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  while (*list != '\0')
+  {
+    len = strcspn(list, ",");
+
+    for (ii=0; ii < NUM_RULES; ii++)
+    {
+      if ((strlen(rules[ii].name) == len) &&
+          (strncmp(list, rules[ii].name, len) == 0))
+      {
+        break;
+      }
+    }
+
+    for (jj=0; jj < num_active; jj++)
+    {
+      if (active[jj] == &rules[ii])
+      {
+        break;
+      }
+    }
+
+    if ((ii == NUM_RULES) ||
+        (jj < num_active))
+    {
+      /***********************************************************************/
+      /* Unknown or repeated rule.  Leave the configuration alone.           */
+      /***********************************************************************/
+      rc = FALSE;
+      goto EXIT;
+    }
+
+    active[num_active++] = &rules[ii];
+
+    list += len;
+    if (*list == ',')
+    {
+      list++;
+    }
+  }
+
+DONE:
+
+  memcpy(sv->active_rules, active, sizeof(active[0]) * num_active);
+  sv->num_active_rules = num_active;
+
+EXIT:
+
+  return (rc);
+}
+
+int sudoku_set_threads(sudoku_solver_t *sv, int threads)
+{
+  if ((threads < 1) ||
+      (threads > SUDOKU_MAX_THREADS))
+  {
+    return (FALSE);
+  }
+
+  sv->num_threads = threads;
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Lockstep solving needs the compiler's vector extensions, and an engine    */
+/* that can take over from the lockstep deduction.                           */
+/*****************************************************************************/
+int sudoku_set_lockstep(sudoku_solver_t *sv, int on)
+{
+#ifndef HAVE_LOCKSTEP
+  if (on)
+  {
+    return (FALSE);
+  }
+#endif
+
+  if (on &&
+      (sv->engine->can_lockstep == FALSE))
+  {
+    return (FALSE);
+  }
+
+  sv->lockstep = (on ? TRUE : FALSE);
+  return (TRUE);
+}
+
+int sudoku_set_count(sudoku_solver_t *sv, long limit)
+{
+  if (limit < 1)
+  {
+    return (FALSE);
+  }
+
+  sv->count_limit = limit;
+  return (TRUE);
+}
+
+int sudoku_set_budget(sudoku_solver_t *sv, long nodes, double seconds)
+{
+  if ((nodes < 0) ||
+      !(seconds >= 0))
+  {
+    return (FALSE);
+  }
+
+  sv->max_nodes = nodes;
+  sv->max_seconds = seconds;
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Looks the restart policy up by name.                                      */
+/*****************************************************************************/
+int sudoku_set_restarts(sudoku_solver_t *sv, const char *name, long nodes)
+{
+  int ii;
+
+  if (nodes < 1)
+  {
+    return (FALSE);
+  }
+
+  for (ii=0; ii < NUM_RESTARTS; ii++)
+  {
+    if (strcmp(name, restarts[ii].name) == 0)
+    {
+      sv->restart = &restarts[ii];
+      sv->restart_nodes = nodes;
+      return (TRUE);
+    }
+  }
+  return (FALSE);
+}
+
+int sudoku_set_seed(sudoku_solver_t *sv, unsigned long seed)
+{
+  sv->search_seed = seed;
+  return (TRUE);
+}
+
+int sudoku_set_portfolio(sudoku_solver_t *sv, int on)
+{
+  sv->portfolio = (on ? TRUE : FALSE);
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Sets the grid size, setting up the solver for it if it isn't the usual    */
+/* one, and empties the grid.                                                */
+/*****************************************************************************/
+int sudoku_set_size(sudoku_solver_t *sv, int size)
+{
+  struct sized sized;
+
+  if ((size != SIZE) &&
+      (sized_init(&sized, size) == FALSE))
+  {
+    sized_free(&sized);
+    return (FALSE);
+  }
+
+  sized_free(&sv->sized);
+
+  if (size != SIZE)
+  {
+    sv->sized = sized;
+  }
+
+  sv->size = size;
+  memset(sv->values, 0, sizeof(sv->values));
+  clear_grid(sv);
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Looks the variant up by name and builds its units, and the dlx engine's   */
+/* matrix for them, emptying the grid.                                       */
+/*****************************************************************************/
+int sudoku_set_variant(sudoku_solver_t *sv, const char *name)
+{
+  int ii;
+
+  for (ii=0; ii < NUM_VARIANTS; ii++)
+  {
+    if (strcmp(name, variants[ii].name) == 0)
+    {
+      sv->variant = &variants[ii];
+      (void)units_build(&sv->units,
+                        NULL,
+                        sv->variant->diagonals,
+                        sv->variant->windows);
+      dlx_init(&sv->dlx, &sv->units);
+      clear_grid(sv);
+      return (TRUE);
+    }
+  }
+  return (FALSE);
+}
+
+/*****************************************************************************/
+/* Rebuilds the units with a jigsaw puzzle's regions in place of the         */
+/* blocks, likewise.                                                         */
+/*****************************************************************************/
+int sudoku_set_regions(sudoku_solver_t *sv, const int regions[SUDOKU_CELLS])
+{
+  if ((sv->variant->regions == FALSE) ||
+      (units_build(&sv->units,
+                   regions,
+                   sv->variant->diagonals,
+                   sv->variant->windows) == FALSE))
+  {
+    return (FALSE);
+  }
+
+  dlx_init(&sv->dlx, &sv->units);
+  clear_grid(sv);
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Looks the symmetry up by name.                                            */
+/*****************************************************************************/
+int sudoku_set_symmetry(sudoku_solver_t *sv, const char *name)
+{
+  int ii;
+
+  for (ii=0; ii < NUM_SYMMETRIES; ii++)
+  {
+    if (strcmp(name, symmetries[ii].name) == 0)
+    {
+      sv->symmetry = &symmetries[ii];
+      return (TRUE);
+    }
+  }
+  return (FALSE);
+}
+
+int sudoku_set_clues(sudoku_solver_t *sv, int clues)
+{
+  if ((clues < 0) ||
+      (clues > (SIZE*SIZE)))
+  {
+    return (FALSE);
+  }
+
+  sv->target_clues = clues;
+  return (TRUE);
+}
+
+int sudoku_set_cache(sudoku_solver_t *sv, sudoku_cache_t *cache)
+{
+  sv->cache = cache;
+  return (TRUE);
+}
+
+const char *sudoku_engine_name(int index)
+{
+  return (((index >= 0) && (index < NUM_ENGINES)) ?
+          engines[index].name : NULL);
+}
+
+const char *sudoku_kernel_name(int index)
+{
+  return (((index >= 0) && (index < NUM_KERNELS)) ?
+          kernels[index].name : NULL);
+}
+
+const char *sudoku_branching_name(int index)
+{
+  return (((index >= 0) && (index < NUM_BRANCHERS)) ?
+          branchers[index].name : NULL);
+}
+
+const char *sudoku_restart_name(int index)
+{
+  return (((index >= 0) && (index < NUM_RESTARTS)) ?
+          restarts[index].name : NULL);
+}
+
+const char *sudoku_route_name(int index)
+{
+  return (((index >= 0) && (index < NUM_ROUTES)) ? route_names[index] : NULL);
+}
+
+const char *sudoku_rule_name(int index)
+{
+  return (((index >= 0) && (index < NUM_RULES)) ? rules[index].name : NULL);
+}
+
+const char *sudoku_symmetry_name(int index)
+{
+  return (((index >= 0) && (index < NUM_SYMMETRIES)) ?
+          symmetries[index].name : NULL);
+}
+
+const char *sudoku_variant_name(int index)
+{
+  return (((index >= 0) && (index < NUM_VARIANTS)) ?
+          variants[index].name : NULL);
+}
+
+/*****************************************************************************/
+/* Loading goes by the grid size.                                            */
+/*****************************************************************************/
+int sudoku_load(sudoku_solver_t *sv, const int values[SUDOKU_CELLS])
+{
+  return ((sv->size != SIZE) ? load_sized(sv, values) :
+                               load_values(sv, values));
+}
+
+int sudoku_load_line(sudoku_solver_t *sv, const char *line)
+{
+  int values[SUDOKU_MAX_CELLS];
+  int nn;
+
+  if (sv->size == SIZE)
+  {
+    return (load_line(sv, line));
+  }
+
+  for (nn=0; nn < (sv->size * sv->size); nn++)
+  {
+    values[nn] = entry_value(line[nn]);
+
+    if (values[nn] < 0)
+    {
+      return (FALSE);
+    }
+  }
+
+  return ((strchr(" \t\r\n,", line[nn]) != NULL) &&
+          (load_sized(sv, values) == TRUE));
+}
+
+/*****************************************************************************/
+/* Solves the loaded puzzle with the selected engine.  Given more than one   */
+/* thread, race searches on them or split the search between them if the     */
+/* engine can.                                                               */
+/*****************************************************************************/
+int sudoku_solve(sudoku_solver_t *sv)
+{
+  double start = STAT_CLOCK();
+  int (*solve)(sudoku_solver_t *) = sv->engine->solve;
+  int success;
+
+  sv->num_solutions = 0;
+  start_budget(sv);
+
+#ifndef NO_THREADS
+  if ((sv->num_threads > 1) &&
+      (sv->portfolio == TRUE) &&
+      (sv->engine->can_race == TRUE))
+  {
+    solve = solve_portfolio;
+  }
+  else if ((sv->num_threads > 1) &&
+           (sv->engine->can_split == TRUE))
+  {
+    solve = solve_parallel;
+  }
+#endif
+
+  if (sv->size != SIZE)
+  {
+    solve = solve_sized;
+  }
+
+  success = ((sv->cache != NULL) && (sv->size == SIZE)) ?
+            solve_cached(sv, solve) : solve(sv);
+
+  sv->stats.seconds = STAT_CLOCK() - start;
+  return (outcome(sv, success));
+}
+
+/*****************************************************************************/
+/* Solves a batch of puzzles, spread over the context's threads.             */
+/*****************************************************************************/
+void sudoku_solve_jobs(sudoku_solver_t *sv, sudoku_job_t *jobs, long count)
+{
+  run_batch(sv, jobs, count, solve_jobs);
+  return;
+}
+
+/*****************************************************************************/
+/* Generates a batch of puzzles, likewise.                                   */
+/*****************************************************************************/
+void sudoku_generate_jobs(sudoku_solver_t *sv,
+                          sudoku_job_t *jobs,
+                          long count,
+                          unsigned long seed)
+{
+  sv->seed = seed;
+  run_batch(sv, jobs, count, generate_jobs);
+  return;
+}
+
+void sudoku_result(const sudoku_solver_t *sv, int values[SUDOKU_CELLS])
+{
+  if (sv->size != SIZE)
+  {
+    memcpy(values, sv->values, sv->size * sv->size * sizeof(values[0]));
+  }
+  else
+  {
+    grid_values(sv, values);
+  }
+  return;
+}
+
+void sudoku_candidates(const sudoku_solver_t *sv,
+                       unsigned int masks[SUDOKU_CELLS])
+{
+  int nn;
+
+  if (sv->size != SIZE)
+  {
+    for (nn=0; nn < (sv->size * sv->size); nn++)
+    {
+      masks[nn] = (sv->values[nn] > 0) ? (1U << (sv->values[nn] - 1)) :
+                  (unsigned int)((1UL << sv->size) - 1);
+    }
+    return;
+  }
+
+  for (nn=0; nn < (SIZE*SIZE); nn++)
+  {
+    masks[nn] = CANDS(nn / SIZE, nn % SIZE);
+  }
+  return;
+}
+
+long sudoku_solutions(const sudoku_solver_t *sv)
+{
+  return (sv->num_solutions);
+}
+
+void sudoku_get_stats(const sudoku_solver_t *sv, sudoku_stats_t *stats)
+{
+  memcpy(stats, &sv->stats, sizeof(*stats));
+  stats->max_depth = sv->max_rec_depth;
+  return;
+}
+
+int sudoku_max_depth(const sudoku_solver_t *sv)
+{
+  return (sv->max_rec_depth);
+}
+
+const char *sudoku_rule_hits(const sudoku_solver_t *sv,
+                             int index,
+                             long *hits)
+{
+  if ((sv->engine->uses_rules == FALSE) ||
+      (sv->stats.route == SUDOKU_ROUTE_DLX) ||
+      (sv->size != SIZE) ||
+      (index < 0) ||
+      (index >= sv->num_active_rules))
+  {
+    return (NULL);
+  }
+
+  *hits = sv->rule_hits[sv->active_rules[index] - rules];
+  return (sv->active_rules[index]->name);
+}
+
+/*****************************************************************************/
+/* Resets the solver for a new puzzle: every number becomes a candidate for  */
+/* every entry, and the trail, queue and statistics are emptied.             */
+/*****************************************************************************/
+static void clear_grid(sudoku_solver_t *sv)
+{
+  int ii;
+  int jj;
+
+  /***************************************************************************/
+  /* Nothing is fixed in any row, column or block yet.                       */
+  /***************************************************************************/
+  memset(&sv->grid, 0, sizeof(sv->grid));
+
+  for (ii=0;ii<SIZE;ii++)
+  {
+    for (jj=0;jj<SIZE;jj++)
+    {
+      CANDS(ii,jj) = ALL_CANDIDATES;
+    }
+  }
+
+  sv->clues = 0;
+  sv->deduced = FALSE;
+  sv->queue_head = 0;
+  sv->queue_tail = 0;
+  sv->clash = FALSE;
+  sv->trail_top = 0;
+  sv->max_rec_depth = 0;
+  sv->cur_rec_depth = 0;
+  sv->stop = NULL;
+  sv->num_solutions = 0;
+  memset(&sv->stats, 0, sizeof(sv->stats));
+
+  for (ii=0; ii < NUM_RULES; ii++)
+  {
+    sv->rule_hits[ii] = 0;
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Loads a puzzle given as an array of values.                               */
+/*****************************************************************************/
+static int load_values(sudoku_solver_t *sv, const int *values)
+{
+  int nn;
+  int rc = TRUE;
+
+  clear_grid(sv);
+
+  for (nn=0; nn < (SIZE*SIZE); nn++)
+  {
+    if ((values[nn] < 0) ||
+        (values[nn] > SIZE))
+    {
+      rc = FALSE;
+      goto EXIT;
+    }
+
+    if (values[nn] > 0)
+    {
+      /***********************************************************************/
+      /* We have a known entry.  Clashes are found when it's propagated.     */
+      /***********************************************************************/
+      CANDS(nn / SIZE, nn % SIZE) = (unsigned short)(1 << (values[nn]-1));
+      note_fixed(sv, nn / SIZE, nn % SIZE);
+    }
+  }
+
+EXIT:
+
+  sv->clues = sv->grid.known;
+  return (rc);
+}
+
+/*****************************************************************************/
+/* The value of every entry of the usual size of grid, 0 if it isn't fixed.  */
+/*****************************************************************************/
+static void grid_values(const sudoku_solver_t *sv, int *values)
+{
+  int nn;
+
+  for (nn=0; nn < (SIZE*SIZE); nn++)
+  {
+    values[nn] = (CAND_COUNT(nn / SIZE, nn % SIZE) == 1) ?
+                 FIXED_VAL(nn / SIZE, nn % SIZE) : 0;
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Loads a puzzle of another size, given as an array of values.              */
+/*****************************************************************************/
+static int load_sized(sudoku_solver_t *sv, const int *values)
+{
+  int nn;
+
+  clear_grid(sv);
+
+  for (nn=0; nn < (sv->size * sv->size); nn++)
+  {
+    if ((values[nn] < 0) ||
+        (values[nn] > sv->size))
+    {
+      return (FALSE);
+    }
+
+    sv->values[nn] = values[nn];
+  }
+
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* The value of an entry in the single-line format: a digit, or a letter     */
+/* from 'A' (either case) for 10 up, or 0 for '.'.  Returns -1 for anything  */
+/* else, the end of the line included.                                       */
+/*****************************************************************************/
+static int entry_value(char entry)
+{
+  if (entry == '.')
+  {
+    return (0);
+  }
+
+  if ((entry >= '0') &&
+      (entry <= '9'))
+  {
+    return (entry - '0');
+  }
+
+  if ((entry >= 'A') &&
+      (entry <= 'Z'))
+  {
+    return (entry - 'A' + 10);
+  }
+
+  if ((entry >= 'a') &&
+      (entry <= 'z'))
+  {
+    return (entry - 'a' + 10);
+  }
+
+  return (-1);
+}
+
+/*****************************************************************************/
+/* Loads a puzzle in the single-line format: SIZE*SIZE characters, row by    */
+/* row, each a digit or '0' or '.' for an unknown entry.  Anything after     */
+/* them must be separated by white space or a comma.  Returns FALSE if the   */
+/* line isn't in that format.                                                */
+/*****************************************************************************/
+static int load_line(sudoku_solver_t *sv, const char *line)
+{
+  int nn;
+  int xx;
+  int rc = TRUE;
+
+  clear_grid(sv);
+
+  for (nn=0; nn < (SIZE*SIZE); nn++)
+  {
+    if ((line[nn] == '.') ||
+        (line[nn] == '0'))
+    {
+      continue;
+    }
+
+    xx = line[nn] - '0';
+
+    if ((xx < 1) ||
+        (xx > SIZE))
+    {
+      rc = FALSE;
+      goto EXIT;
+    }
+
+    /*************************************************************************/
+    /* We have a known entry.  Clashes are found when it's propagated.       */
+    /*************************************************************************/
+    CANDS(nn / SIZE, nn % SIZE) = (unsigned short)(1 << (xx-1));
+    note_fixed(sv, nn / SIZE, nn % SIZE);
+  }
+
+  if ((line[nn] != '\0') &&
+      (line[nn] != ',') &&
+      (strchr(" \t\r\n", line[nn]) == NULL))
+  {
+    rc = FALSE;
+  }
+
+EXIT:
+
+  sv->clues = sv->grid.known;
+  return (rc);
+}
+
+/*****************************************************************************/
+/* Solves jobs first to last-1 of a batch, leaving each job's solution in    */
+/* place of its puzzle.                                                      */
+/*****************************************************************************/
+static void solve_jobs(sudoku_solver_t *sv,
+                       sudoku_job_t *jobs,
+                       long first,
+                       long last)
+{
+  sudoku_job_t *job;
+  double start;
+
+#ifdef HAVE_LOCKSTEP
+  if ((sv->lockstep == TRUE) &&
+      (sv->engine->can_lockstep == TRUE) &&
+      (sv->cache == NULL))
+  {
+    while (first < last)
+    {
+      first = solve_pack(sv, jobs, first, last);
+    }
+  }
+#endif
+
+  for (; first < last; first++)
+  {
+    job = &jobs[first];
+    start = STAT_CLOCK();
+
+    if (load_line(sv, job->line) == FALSE)
+    {
+      bad_job(job);
+    }
+    else
+    {
+      start_budget(sv);
+      finish_job(sv,
+                 job,
+                 (sv->cache != NULL) ? solve_cached(sv, sv->engine->solve) :
+                                       sv->engine->solve(sv),
+                 start);
+    }
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Records the outcome of solving a job's puzzle, copying the solution from  */
+/* the grid if there is one, and the statistics for the solve, which began   */
+/* at time start.                                                            */
+/*****************************************************************************/
+static void finish_job(sudoku_solver_t *sv,
+                       sudoku_job_t *job,
+                       int success,
+                       double start)
+{
+  int nn;
+
+  job->solutions = sv->num_solutions;
+  job->status = outcome(sv, success);
+  sudoku_get_stats(sv, &job->stats);
+  job->stats.seconds = STAT_CLOCK() - start;
+
+  if (job->status == SUDOKU_SOLVED)
+  {
+    for (nn=0; nn < (SIZE*SIZE); nn++)
+    {
+      job->line[nn] = (char)('0' + FIXED_VAL(nn / SIZE, nn % SIZE));
+    }
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Records that a job's puzzle couldn't be read.                             */
+/*****************************************************************************/
+static void bad_job(sudoku_job_t *job)
+{
+  job->status = SUDOKU_BAD_INPUT;
+  job->solutions = 0;
+  memset(&job->stats, 0, sizeof(job->stats));
+  return;
+}
+
+/*****************************************************************************/
+/* Does a batch of jobs with the given function, on the context's threads    */
+/* if it has more than one.                                                  */
+/*****************************************************************************/
+static void run_batch(sudoku_solver_t *sv,
+                      sudoku_job_t *jobs,
+                      long count,
+                      void (*batch)(sudoku_solver_t *,
+                                    sudoku_job_t *,
+                                    long,
+                                    long))
+{
+#ifndef NO_THREADS
+  struct worker *workers = NULL;
+  int ii;
+
+  if ((sv->num_threads > 1) &&
+      (count > 1))
+  {
+    workers = calloc((size_t)sv->num_threads, sizeof(*workers));
+  }
+
+  if (workers != NULL)
+  {
+    for (ii=0; ii < sv->num_threads; ii++)
+    {
+      memcpy(&workers[ii].solver, sv, sizeof(*sv));
+      workers[ii].jobs = jobs;
+      workers[ii].num_jobs = count;
+      workers[ii].batch = batch;
+      workers[ii].search = NULL;
+      workers[ii].race = NULL;
+    }
+
+    run_workers(workers,
+                sv->num_threads,
+                (count + JOB_GROUP - 1) / JOB_GROUP);
+    free(workers);
+  }
+  else
+#endif
+  {
+    /*************************************************************************/
+    /* One thread, or no memory for more.                                    */
+    /*************************************************************************/
+    batch(sv, jobs, 0, count);
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Generates jobs first to last-1 of a batch.                                */
+/*****************************************************************************/
+static void generate_jobs(sudoku_solver_t *sv,
+                          sudoku_job_t *jobs,
+                          long first,
+                          long last)
+{
+  for (; first < last; first++)
+  {
+    generate_one(sv, &jobs[first], first);
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Generates a puzzle with a unique solution: fills in a random grid, then   */
+/* takes clues away, in random order, for as long as the solution stays      */
+/* unique.  If that leaves more clues than the target, it tries again from a */
+/* new grid.  The job gets the puzzle with the fewest clues found, and the   */
+/* counters for all the solving that took; it's only marked solved if the    */
+/* puzzle has no more clues than the target.  The context's count limit is   */
+/* left as it was.                                                           */
+/*****************************************************************************/
+static void generate_one(sudoku_solver_t *sv, sudoku_job_t *job, long index)
+{
+  struct rng rng;
+  int solution[SIZE*SIZE];
+  int puzzle[SIZE*SIZE];
+  int best[SIZE*SIZE];
+  int best_clues = (SIZE*SIZE) + 1;
+  int clues;
+  int attempt;
+  int nn;
+  long count_limit = sv->count_limit;
+  sudoku_stats_t stats;
+  double start = STAT_CLOCK();
+
+  memset(&stats, 0, sizeof(stats));
+  memset(best, 0, sizeof(best));
+  rng_seed(&rng, sv->seed + (unsigned long)index);
+
+  for (attempt=0;
+       (attempt < GENERATE_ATTEMPTS) &&
+       ((best_clues > (SIZE*SIZE)) ||
+        ((sv->target_clues > 0) && (best_clues > sv->target_clues)));
+       attempt++)
+  {
+    if (random_grid(sv, &rng, solution, &stats) == TRUE)
+    {
+      clues = remove_clues(sv, &rng, solution, puzzle, &stats);
+
+      if (clues < best_clues)
+      {
+        best_clues = clues;
+        memcpy(best, puzzle, sizeof(best));
+      }
+    }
+  }
+  sv->count_limit = count_limit;
+
+  for (nn=0; nn < (SIZE*SIZE); nn++)
+  {
+    job->line[nn] = (char)((best[nn] == 0) ? '.' : ('0' + best[nn]));
+  }
+  job->line[SIZE*SIZE] = '\0';
+  job->status = ((best_clues <= (SIZE*SIZE)) &&
+                 ((sv->target_clues == 0) ||
+                  (best_clues <= sv->target_clues))) ?
+                SUDOKU_SOLVED : SUDOKU_BUDGET_EXCEEDED;
+  job->solutions = (best_clues <= (SIZE*SIZE)) ? 1 : 0;
+  memcpy(&job->stats, &stats, sizeof(stats));
+  job->stats.seconds = STAT_CLOCK() - start;
+  return;
+}
+
+/*****************************************************************************/
+/* Fills in a random complete grid.  The three blocks on the diagonal share  */
+/* no row or column, so with the standard units they can be filled with      */
+/* random permutations and still be part of some solution; the search then   */
+/* finds one.  Other variants start from a few random values instead.        */
+/* Returns FALSE if those have no solution, or it runs out of budget.        */
+/*****************************************************************************/
+static int random_grid(sudoku_solver_t *sv,
+                       struct rng *rng,
+                       int *values,
+                       sudoku_stats_t *stats)
+{
+  int digits[SIZE];
+  int blk;
+  int ii;
+  int jj;
+  int swap;
+
+  memset(values, 0, sizeof(values[0]) * SIZE * SIZE);
+
+  for (blk=0;
+       (blk < SIZE) && (sv->units.regular == TRUE);
+       blk += BLOCK_SIZE + 1)
+  {
+    for (ii=0; ii < SIZE; ii++)
+    {
+      digits[ii] = ii + 1;
+    }
+
+    for (ii=SIZE-1; ii > 0; ii--)
+    {
+      jj = (int)(rng_next(rng) % (unsigned long)(ii + 1));
+      swap = digits[ii];
+      digits[ii] = digits[jj];
+      digits[jj] = swap;
+    }
+
+    for (ii=0; ii < SIZE; ii++)
+    {
+      values[((((blk / BLOCK_SIZE) * BLOCK_SIZE) + (ii / BLOCK_SIZE)) * SIZE) +
+             ((blk % BLOCK_SIZE) * BLOCK_SIZE) + (ii % BLOCK_SIZE)] =
+        digits[ii];
+    }
+  }
+
+  if (((sv->units.regular == FALSE) &&
+       (random_entries(sv, rng, values) == FALSE)) ||
+      (solvable(sv, values, 0, 0, stats) == FALSE))
+  {
+    return (FALSE);
+  }
+
+  grid_values(sv, values);
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Puts random values in entries taken in random order, each one of the      */
+/* entry's candidates once those before it have been propagated, skipping    */
+/* any entries that propagation fixes along the way.  Gives the values of    */
+/* every entry then fixed, or returns FALSE if propagation finds a           */
+/* contradiction.                                                            */
+/*****************************************************************************/
+static int random_entries(sudoku_solver_t *sv, struct rng *rng, int *values)
+{
+  int order[SIZE*SIZE];
+  unsigned short cands;
+  int pick;
+  int ii;
+  int jj;
+  int nn;
+  int swap;
+
+  for (ii=0; ii < (SIZE*SIZE); ii++)
+  {
+    order[ii] = ii;
+  }
+
+  for (ii=(SIZE*SIZE)-1; ii > 0; ii--)
+  {
+    jj = (int)(rng_next(rng) % (unsigned long)(ii + 1));
+    swap = order[ii];
+    order[ii] = order[jj];
+    order[jj] = swap;
+  }
+
+  clear_grid(sv);
+
+  for (ii=0; ii < RANDOM_ENTRIES; ii++)
+  {
+    nn = order[ii];
+    cands = CANDS(nn / SIZE, nn % SIZE);
+
+    if ((cands & (cands - 1)) == 0)
+    {
+      continue;
+    }
+
+    for (pick = (int)(rng_next(rng) % (unsigned long)POPCOUNT(cands));
+         pick > 0;
+         pick--)
+    {
+      cands &= (unsigned short)(cands - 1);
+    }
+
+    fix_entry(sv,
+              nn / SIZE,
+              nn % SIZE,
+              (unsigned short)(cands & (~cands + 1)));
+
+    if (sv->kernel->propagate(sv) == FALSE)
+    {
+      return (FALSE);
+    }
+  }
+
+  grid_values(sv, values);
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Takes clues out of a solution, a symmetry orbit at a time in random       */
+/* order, putting back any whose removal lets the puzzle have another        */
+/* solution (or makes the check run out of budget), and stopping short of    */
+/* the target.  Returns the number of clues left in the puzzle.              */
+/*****************************************************************************/
+static int remove_clues(sudoku_solver_t *sv,
+                        struct rng *rng,
+                        const int *solution,
+                        int *puzzle,
+                        sudoku_stats_t *stats)
+{
+  int order[SIZE*SIZE];
+  int cells[4];
+  int clues = SIZE*SIZE;
+  int size;
+  int ii;
+  int jj;
+  int swap;
+
+  memcpy(puzzle, solution, sizeof(puzzle[0]) * SIZE * SIZE);
+
+  for (ii=0; ii < (SIZE*SIZE); ii++)
+  {
+    order[ii] = ii;
+  }
+
+  for (ii=(SIZE*SIZE)-1; ii > 0; ii--)
+  {
+    jj = (int)(rng_next(rng) % (unsigned long)(ii + 1));
+    swap = order[ii];
+    order[ii] = order[jj];
+    order[jj] = swap;
+  }
+
+  for (ii=0; ii < (SIZE*SIZE); ii++)
+  {
+    if (puzzle[order[ii]] == 0)
+    {
+      /***********************************************************************/
+      /* Already gone with another entry of its orbit.                       */
+      /***********************************************************************/
+      continue;
+    }
+
+    size = orbit(sv, order[ii], cells);
+
+    if (clues - size < sv->target_clues)
+    {
+      continue;
+    }
+
+    for (jj=0; jj < size; jj++)
+    {
+      puzzle[cells[jj]] = 0;
+    }
+
+    if (still_unique(sv, puzzle, solution, cells, size, stats) == TRUE)
+    {
+      clues -= size;
+    }
+    else
+    {
+      for (jj=0; jj < size; jj++)
+      {
+        puzzle[cells[jj]] = solution[cells[jj]];
+      }
+    }
+  }
+
+  return (clues);
+}
+
+/*****************************************************************************/
+/* Whether a puzzle, just made by taking the given entries' clues out of a   */
+/* puzzle with a unique solution, still has only that solution.  Any other   */
+/* solution must differ from it in one of those entries, so rather than      */
+/* counting solutions, look for one with each entry's old value ruled out in */
+/* turn.  That search can stop at the first it finds, and is cut short where */
+/* the ruled-out value would have been.                                      */
+/*****************************************************************************/
+static int still_unique(sudoku_solver_t *sv,
+                        const int *puzzle,
+                        const int *solution,
+                        const int *cells,
+                        int size,
+                        sudoku_stats_t *stats)
+{
+  int ii;
+
+  for (ii=0; ii < size; ii++)
+  {
+    if (solvable(sv,
+                 puzzle,
+                 cells[ii],
+                 1 << (solution[cells[ii]] - 1),
+                 stats) == TRUE)
+    {
+      return (FALSE);
+    }
+  }
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Whether a grid has a solution with the candidates in mask ruled out for   */
+/* the given entry, adding the counters to stats.  A search that runs out of */
+/* budget counts as finding one, so a puzzle that can't be checked is never  */
+/* taken to be unique.  This is always the logic engine's search: the dlx    */
+/* engine only looks at the givens, not the candidates.                      */
+/*****************************************************************************/
+static int solvable(sudoku_solver_t *sv,
+                    const int *values,
+                    int nn,
+                    int mask,
+                    sudoku_stats_t *stats)
+{
+  (void)load_values(sv, values);
+  CANDS(nn / SIZE, nn % SIZE) &= (unsigned short)~mask;
+  sv->count_limit = 1;
+  start_budget(sv);
+
+  (void)solve_logic(sv);
+
+  add_stats(stats, &sv->stats);
+  if (stats->max_depth < sv->max_rec_depth)
+  {
+    stats->max_depth = sv->max_rec_depth;
+  }
+
+  return ((sv->exceeded == TRUE) || (sv->num_solutions > 0));
+}
+
+/*****************************************************************************/
+/* Lists the entries in an entry's orbit under the context's symmetry, the   */
+/* entry itself first, and returns how many there are (at most 4).           */
+/*****************************************************************************/
+static int orbit(const sudoku_solver_t *sv, int nn, int *cells)
+{
+  int size = 1;
+
+  cells[0] = nn;
+
+  if (sv->symmetry->map != NULL)
+  {
+    for (nn = sv->symmetry->map(nn);
+         nn != cells[0];
+         nn = sv->symmetry->map(nn))
+    {
+      cells[size++] = nn;
+    }
+  }
+  return (size);
+}
+
+/*****************************************************************************/
+/* The symmetries: turning the grid half way or a quarter of the way round,  */
+/* reflecting it left to right, and reflecting it in the diagonal from top   */
+/* left to bottom right.                                                     */
+/*****************************************************************************/
+static int map_half_turn(int nn)
+{
+  return ((SIZE*SIZE) - 1 - nn);
+}
+
+static int map_quarter_turn(int nn)
+{
+  return (((nn % SIZE) * SIZE) + (SIZE - 1 - (nn / SIZE)));
+}
+
+static int map_mirror(int nn)
+{
+  return (((nn / SIZE) * SIZE) + (SIZE - 1 - (nn % SIZE)));
+}
+
+static int map_diagonal(int nn)
+{
+  return (((nn % SIZE) * SIZE) + (nn / SIZE));
+}
+
+/*****************************************************************************/
+/* Seeds a random number generator, spreading the seed over the state with   */
+/* the MurmurHash3 finaliser applied to successive steps of a Weyl sequence. */
+/*****************************************************************************/
+static void rng_seed(struct rng *rng, unsigned long seed)
+{
+  unsigned long zz;
+  int ii;
+
+  seed = (seed ^ ((seed >> 16) >> 16)) & RNG_MASK;
+
+  for (ii=0; ii < 4; ii++)
+  {
+    seed = (seed + 0x9e3779b9UL) & RNG_MASK;
+    zz = seed;
+    zz = ((zz ^ (zz >> 16)) * 0x85ebca6bUL) & RNG_MASK;
+    zz = ((zz ^ (zz >> 13)) * 0xc2b2ae35UL) & RNG_MASK;
+    rng->state[ii] = zz ^ (zz >> 16);
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* The next 32 random bits.                                                  */
+/*****************************************************************************/
+static unsigned long rng_next(struct rng *rng)
+{
+  unsigned long *ss = rng->state;
+  unsigned long result = (ROTATE((ss[1] * 5) & RNG_MASK, 7) * 9) & RNG_MASK;
+  unsigned long tt = (ss[1] << 9) & RNG_MASK;
+
+  ss[2] ^= ss[0];
+  ss[3] ^= ss[1];
+  ss[1] ^= ss[2];
+  ss[0] ^= ss[3];
+  ss[2] ^= tt;
+  ss[3] = ROTATE(ss[3], 11);
+
+  return (result);
+}
+
+/*****************************************************************************/
+/* Adds one set of counters to another.  The time and depth are left alone.  */
+/*****************************************************************************/
+static void add_stats(sudoku_stats_t *to, const sudoku_stats_t *from)
+{
+  to->guesses += from->guesses;
+  to->backtracks += from->backtracks;
+  to->propagations += from->propagations;
+  to->row_eliminations += from->row_eliminations;
+  to->col_eliminations += from->col_eliminations;
+  to->blk_eliminations += from->blk_eliminations;
+  to->check_failures += from->check_failures;
+  to->backjumps += from->backjumps;
+  to->nogoods += from->nogoods;
+  to->forgotten += from->forgotten;
+  to->restarts += from->restarts;
+  return;
+}
+
+#ifndef NO_THREADS
+/*****************************************************************************/
+/* Runs jobs 0 to num_jobs-1 on num_workers workers, returning when they're  */
+/* all done.  The jobs are dealt out evenly to begin with; stealing sorts    */
+/* out any imbalance.                                                        */
+/*****************************************************************************/
+static void run_workers(struct worker *workers, int num_workers, long num_jobs)
+{
+  int ii;
+
+  for (ii=0; ii < num_workers; ii++)
+  {
+    workers[ii].id = ii;
+    workers[ii].num_workers = num_workers;
+    workers[ii].all = workers;
+    workers[ii].next = (num_jobs * ii) / num_workers;
+    workers[ii].end = (num_jobs * (ii + 1)) / num_workers;
+    workers[ii].started = FALSE;
+    (void)pthread_mutex_init(&workers[ii].lock, NULL);
+  }
+
+  /***************************************************************************/
+  /* This thread is worker zero.  If another can't be started, the rest will */
+  /* steal its jobs.                                                         */
+  /***************************************************************************/
+  for (ii=1; ii < num_workers; ii++)
+  {
+    workers[ii].started = (pthread_create(&workers[ii].thread,
+                                          NULL,
+                                          worker_main,
+                                          &workers[ii]) == 0);
+  }
+
+  (void)worker_main(&workers[0]);
+
+  for (ii=0; ii < num_workers; ii++)
+  {
+    if (workers[ii].started)
+    {
+      (void)pthread_join(workers[ii].thread, NULL);
+    }
+  }
+
+  for (ii=0; ii < num_workers; ii++)
+  {
+    (void)pthread_mutex_destroy(&workers[ii].lock);
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Worker thread.  Does jobs until there are none left to take or steal, or  */
+/* until a parallel search has been stopped.                                 */
+/*****************************************************************************/
+static void *worker_main(void *arg)
+{
+  struct worker *worker = arg;
+  long job;
+
+  while (((worker->search == NULL) ||
+          (ATOMIC_LOAD(&worker->search->stop) == FALSE)) &&
+         (take_job(worker, &job) == TRUE))
+  {
+    if (worker->search != NULL)
+    {
+      solve_subproblem(&worker->solver, worker->search, job);
+    }
+    else if (worker->race != NULL)
+    {
+      race_member(&worker->solver, worker->race, job);
+    }
+    else
+    {
+      worker->batch(&worker->solver,
+                    worker->jobs,
+                    job * JOB_GROUP,
+                    ((job + 1) * JOB_GROUP < worker->num_jobs) ?
+                    (job + 1) * JOB_GROUP : worker->num_jobs);
+    }
+  }
+
+  return (NULL);
+}
+
+/*****************************************************************************/
+/* Takes the next job from the front of a worker's own range.  If that's     */
+/* empty, steals the back half of the first other worker's range that isn't. */
+/* Returns FALSE once there's nothing left anywhere.                         */
+/*****************************************************************************/
+static int take_job(struct worker *worker, long *job)
+{
+  struct worker *victim;
+  long stolen;
+  long first;
+  int ii;
+  int rc = TRUE;
+
+  (void)pthread_mutex_lock(&worker->lock);
+  if (worker->next < worker->end)
+  {
+    *job = worker->next++;
+    (void)pthread_mutex_unlock(&worker->lock);
+    goto EXIT;
+  }
+  (void)pthread_mutex_unlock(&worker->lock);
+
+  for (ii=1; ii < worker->num_workers; ii++)
+  {
+    victim = &worker->all[(worker->id + ii) % worker->num_workers];
+
+    (void)pthread_mutex_lock(&victim->lock);
+    stolen = (victim->end - victim->next + 1) / 2;
+    victim->end -= stolen;
+    first = victim->end;
+    (void)pthread_mutex_unlock(&victim->lock);
+
+    if (stolen > 0)
+    {
+      /***********************************************************************/
+      /* Do the first stolen job now and keep the rest for later.            */
+      /***********************************************************************/
+      (void)pthread_mutex_lock(&worker->lock);
+      *job = first;
+      worker->next = first + 1;
+      worker->end = first + stolen;
+      (void)pthread_mutex_unlock(&worker->lock);
+      goto EXIT;
+    }
+  }
+
+  rc = FALSE;
+
+EXIT:
+
+  return (rc);
+}
+
+/*****************************************************************************/
+/* Solves the loaded puzzle using the context's threads.  The search tree is */
+/* expanded breadth-first, a level of guesses at a time, until there are     */
+/* enough subproblems to keep every thread busy; the workers then search     */
+/* them independently.  On success the first solution found is left in the   */
+/* solver, with the statistics of all the threads combined.                  */
+/*****************************************************************************/
+static int solve_parallel(sudoku_solver_t *sv)
+{
+  struct grid *frontier = NULL;
+  struct grid *next = NULL;
+  struct grid *swap;
+  struct worker *workers = NULL;
+  struct search search;
+  long num_frontier = 1;
+  long num_next;
+  long nn;
+  int ii;
+  int jj;
+  int kk;
+  int levels = 1;
+  int depth = 0;
+  unsigned short saved_entry;
+  unsigned short guess;
+
+  sv->max_rec_depth = 1;
+
+  if (deduce(sv) == FALSE)
+  {
+    goto EXIT;
+  }
+
+  if (sv->grid.known == (SIZE*SIZE))
+  {
+    /*************************************************************************/
+    /* Deduction alone solved it.                                            */
+    /*************************************************************************/
+    (void)found_solution(sv);
+    goto EXIT;
+  }
+
+  frontier = malloc(sizeof(*frontier));
+
+  if (frontier == NULL)
+  {
+    goto EXIT;
+  }
+  memcpy(&frontier[0], &sv->grid, sizeof(sv->grid));
+
+  while ((num_frontier > 0) &&
+         (num_frontier < (sv->num_threads * SPLIT_PER_THREAD)))
+  {
+    /*************************************************************************/
+    /* Expand the next level: one child per candidate of the entry the       */
+    /* branching heuristic picks.  Drop children that turn out to be         */
+    /* inconsistent or solved, counting the solutions, and stop at once if   */
+    /* that's enough of them.                                                */
+    /*************************************************************************/
+    next = malloc(sizeof(*next) * num_frontier * SIZE);
+
+    if (next == NULL)
+    {
+      goto EXIT;
+    }
+
+    num_next = 0;
+    levels++;
+
+    for (nn=0; nn < num_frontier; nn++)
+    {
+      memcpy(&sv->grid, &frontier[nn], sizeof(sv->grid));
+      sv->trail_top = 0;
+      sv->brancher->pick(sv, &ii, &jj);
+      saved_entry = CANDS(ii,jj);
+
+      while (saved_entry != 0)
+      {
+        guess = (unsigned short)(saved_entry & (~saved_entry + 1));
+        saved_entry &= (unsigned short)~guess;
+
+        memcpy(&sv->grid, &frontier[nn], sizeof(sv->grid));
+        sv->trail_top = 0;
+        fix_entry(sv, ii, jj, guess);
+        STAT(guesses, 1);
+
+        if (deduce(sv) == FALSE)
+        {
+          STAT(backtracks, 1);
+        }
+        else if (sv->grid.known < (SIZE*SIZE))
+        {
+          memcpy(&next[num_next++], &sv->grid, sizeof(sv->grid));
+        }
+        else if (found_solution(sv) == TRUE)
+        {
+          goto EXIT;
+        }
+      }
+    }
+
+    swap = frontier;
+    frontier = next;
+    next = swap;
+    free(next);
+    next = NULL;
+    num_frontier = num_next;
+    sv->max_rec_depth = levels;
+  }
+
+  if (num_frontier == 0)
+  {
+    goto EXIT;
+  }
+
+  /***************************************************************************/
+  /* Hand the subproblems out to the workers.                                */
+  /***************************************************************************/
+  workers = calloc((size_t)sv->num_threads, sizeof(*workers));
+
+  if (workers == NULL)
+  {
+    goto EXIT;
+  }
+
+  search.subproblems = frontier;
+  search.num_subproblems = num_frontier;
+  search.stop = FALSE;
+  search.num_solutions = 0;
+  (void)pthread_mutex_init(&search.lock, NULL);
+
+  /***************************************************************************/
+  /* Each worker gets an equal share of the node budget, and the same        */
+  /* deadline.                                                               */
+  /***************************************************************************/
+  for (kk=0; kk < sv->num_threads; kk++)
+  {
+    memcpy(&workers[kk].solver, sv, sizeof(*sv));
+    clear_grid(&workers[kk].solver);
+    workers[kk].jobs = NULL;
+    workers[kk].search = &search;
+    workers[kk].race = NULL;
+
+    if (sv->max_nodes > 0)
+    {
+      workers[kk].solver.max_nodes = (sv->max_nodes / sv->num_threads) + 1;
+    }
+  }
+
+  run_workers(workers, sv->num_threads, num_frontier);
+  (void)pthread_mutex_destroy(&search.lock);
+
+  /***************************************************************************/
+  /* Combine the workers' statistics and solutions.  Any found while         */
+  /* expanding the tree came first.                                          */
+  /***************************************************************************/
+  for (kk=0; kk < sv->num_threads; kk++)
+  {
+    if (depth < workers[kk].solver.max_rec_depth)
+    {
+      depth = workers[kk].solver.max_rec_depth;
+    }
+
+    for (jj=0; jj < NUM_RULES; jj++)
+    {
+      sv->rule_hits[jj] += workers[kk].solver.rule_hits[jj];
+    }
+    add_stats(&sv->stats, &workers[kk].solver.stats);
+    sv->nodes += workers[kk].solver.nodes;
+
+    if (workers[kk].solver.exceeded == TRUE)
+    {
+      sv->exceeded = TRUE;
+    }
+  }
+  sv->max_rec_depth = levels + depth;
+
+  if ((sv->num_solutions == 0) &&
+      (search.num_solutions > 0))
+  {
+    memcpy(&sv->solution, &search.solution, sizeof(sv->grid));
+  }
+  sv->num_solutions += search.num_solutions;
+
+EXIT:
+
+  free(frontier);
+  free(next);
+  free(workers);
+
+  return (first_solution(sv));
+}
+
+/*****************************************************************************/
+/* Searches one subproblem of a parallel search, adding the solutions it     */
+/* finds to the search's count.  The worker that brings the count up to the  */
+/* limit tells the others to stop.                                           */
+/*****************************************************************************/
+static void solve_subproblem(sudoku_solver_t *sv,
+                             struct search *search,
+                             long nn)
+{
+  int max_rec_depth = sv->max_rec_depth;
+  long rule_hits[NUM_RULES];
+  sudoku_stats_t stats;
+  int ii;
+
+  /***************************************************************************/
+  /* Start from the subproblem's grid, keeping the statistics so far.        */
+  /***************************************************************************/
+  memcpy(rule_hits, sv->rule_hits, sizeof(rule_hits));
+  memcpy(&stats, &sv->stats, sizeof(stats));
+  clear_grid(sv);
+  memcpy(&sv->grid, &search->subproblems[nn], sizeof(sv->grid));
+  sv->stop = &search->stop;
+
+  (void)attempt_to_solve(sv);
+
+  /***************************************************************************/
+  /* Once one worker runs out of budget, so does the whole search.           */
+  /***************************************************************************/
+  if (sv->exceeded == TRUE)
+  {
+    ATOMIC_STORE(&search->stop, TRUE);
+  }
+
+  if (sv->num_solutions > 0)
+  {
+    (void)pthread_mutex_lock(&search->lock);
+    if (search->stop == FALSE)
+    {
+      if (search->num_solutions == 0)
+      {
+        memcpy(&search->solution, &sv->solution, sizeof(sv->grid));
+      }
+      search->num_solutions += sv->num_solutions;
+
+      if (search->num_solutions >= sv->count_limit)
+      {
+        ATOMIC_STORE(&search->stop, TRUE);
+      }
+    }
+    (void)pthread_mutex_unlock(&search->lock);
+  }
+
+  if (sv->max_rec_depth < max_rec_depth)
+  {
+    sv->max_rec_depth = max_rec_depth;
+  }
+
+  for (ii=0; ii < NUM_RULES; ii++)
+  {
+    sv->rule_hits[ii] += rule_hits[ii];
+  }
+  add_stats(&sv->stats, &stats);
+  return;
+}
+
+/*****************************************************************************/
+/* Solves the loaded puzzle by racing differently configured searches, one   */
+/* on each of the context's threads (see struct race).  The winner's         */
+/* solutions and counters are left in the solver.  If every search runs out  */
+/* of budget, so does the solve, with the counters of all of them.           */
+/*****************************************************************************/
+static int solve_portfolio(sudoku_solver_t *sv)
+{
+  struct worker *workers;
+  struct race race;
+  int ii;
+
+  workers = calloc((size_t)sv->num_threads, sizeof(*workers));
+
+  if (workers == NULL)
+  {
+    /*************************************************************************/
+    /* No memory for the threads, so just the one search.                    */
+    /*************************************************************************/
+    return (solve_logic(sv));
+  }
+
+  race.start = sv;
+  race.winner = -1;
+  race.nodes = 0;
+  race.num_solutions = 0;
+  memset(&race.spent, 0, sizeof(race.spent));
+  (void)pthread_mutex_init(&race.lock, NULL);
+
+  for (ii=0; ii < sv->num_threads; ii++)
+  {
+    workers[ii].jobs = NULL;
+    workers[ii].search = NULL;
+    workers[ii].race = &race;
+  }
+
+  run_workers(workers, sv->num_threads, sv->num_threads);
+  (void)pthread_mutex_destroy(&race.lock);
+  free(workers);
+
+  if (race.winner < 0)
+  {
+    add_stats(&sv->stats, &race.spent);
+    sv->max_rec_depth = race.spent.max_depth;
+    sv->exceeded = TRUE;
+    return (FALSE);
+  }
+
+  for (ii=0; ii < NUM_RULES; ii++)
+  {
+    sv->rule_hits[ii] += race.rule_hits[ii];
+  }
+  add_stats(&sv->stats, &race.stats);
+  sv->max_rec_depth = race.max_depth;
+  sv->nodes = race.nodes;
+  sv->num_solutions = race.num_solutions;
+  memcpy(&sv->solution, &race.solution, sizeof(sv->solution));
+
+  return (first_solution(sv));
+}
+
+/*****************************************************************************/
+/* Runs search number nn of a race on a fresh copy of the context, and keeps */
+/* its result if it has won so far.  The first search has the context's own  */
+/* configuration; the others restart, with the Luby policy and then the      */
+/* geometric one, each with its own seed, and switch between the default     */
+/* branching heuristic and plain minimum remaining values every two.         */
+/*****************************************************************************/
+static void race_member(sudoku_solver_t *sv, struct race *race, long nn)
+{
+  int ii;
+
+  memcpy(sv, race->start, sizeof(*sv));
+  memset(&sv->stats, 0, sizeof(sv->stats));
+  for (ii=0; ii < NUM_RULES; ii++)
+  {
+    sv->rule_hits[ii] = 0;
+  }
+
+  if (nn > 0)
+  {
+    sv->restart = &restarts[1 + ((nn + 1) % 2)];
+    sv->brancher = &branchers[((nn - 1) / 2) % 2];
+    sv->search_seed += (unsigned long)nn;
+  }
+  sv->race = race;
+
+  (void)solve_logic(sv);
+
+  (void)pthread_mutex_lock(&race->lock);
+  add_stats(&race->spent, &sv->stats);
+  if (race->spent.max_depth < sv->max_rec_depth)
+  {
+    race->spent.max_depth = sv->max_rec_depth;
+  }
+
+  if ((sv->exceeded == FALSE) &&
+      ((race->winner < 0) ||
+       (sv->nodes < race->nodes) ||
+       ((sv->nodes == race->nodes) && (nn < race->winner))))
+  {
+    race->winner = nn;
+    race->nodes = sv->nodes;
+    race->num_solutions = sv->num_solutions;
+    memcpy(&race->solution, &sv->solution, sizeof(sv->solution));
+    race->max_depth = sv->max_rec_depth;
+    memcpy(race->rule_hits, sv->rule_hits, sizeof(race->rule_hits));
+    memcpy(&race->stats, &sv->stats, sizeof(race->stats));
+  }
+  (void)pthread_mutex_unlock(&race->lock);
+  return;
+}
+
+/*****************************************************************************/
+/* Whether a search in a race has gone past the nodes of the winner so far,  */
+/* and so can't win.                                                         */
+/*****************************************************************************/
+static int race_lost(sudoku_solver_t *sv)
+{
+  int lost;
+
+  (void)pthread_mutex_lock(&sv->race->lock);
+  lost = ((sv->race->winner >= 0) &&
+          (sv->nodes > sv->race->nodes));
+  (void)pthread_mutex_unlock(&sv->race->lock);
+
+  return (lost);
+}
+#endif
+
+/*****************************************************************************/
+/* The logic engine.  Searches for solutions until it has as many as it's    */
+/* looking for or has tried everything, leaving the first in the grid.       */
+/*                                                                           */
+/* With a restart policy, and looking for just one solution, each run of the */
+/* search stops at its share of nodes and the next starts again from the     */
+/* top, keeping only what the deduction found before the first guess.  The   */
+/* guesses are made in random order, from a generator seeded afresh for      */
+/* each solve, so every run goes a different way but a puzzle always gets    */
+/* the same runs.  A run that finishes is the answer, solution or not.       */
+/* Counting solutions always takes the one search in order, as a restart     */
+/* would find the same solutions again.                                      */
+/*****************************************************************************/
+static int solve_logic(sudoku_solver_t *sv)
+{
+  long run;
+  long length;
+
+  if ((sv->restart->run == NULL) ||
+      (sv->count_limit > 1))
+  {
+    (void)attempt_to_solve(sv);
+    return (first_solution(sv));
+  }
+
+  rng_seed(&sv->rng, sv->search_seed);
+  sv->randomize = TRUE;
+
+  for (run=0; ; run++)
+  {
+    length = sv->restart->run(run);
+    sv->run_limit = (sv->restart_nodes > ((LONG_MAX - sv->nodes) / length)) ?
+                    LONG_MAX : (sv->nodes + (sv->restart_nodes * length));
+    sv->run_over = FALSE;
+
+    (void)attempt_to_solve(sv);
+
+    if (sv->run_over == FALSE)
+    {
+      break;
+    }
+
+    /*************************************************************************/
+    /* The guess the run stopped at was never propagated, so drop it from    */
+    /* the queue along with any clash it made.  Everything else was undone.  */
+    /*************************************************************************/
+    sv->queue_head = 0;
+    sv->queue_tail = 0;
+    sv->clash = FALSE;
+    sv->exceeded = FALSE;
+    STAT(restarts, 1);
+  }
+
+  sv->run_limit = 0;
+  sv->run_over = FALSE;
+  sv->randomize = FALSE;
+
+  return (first_solution(sv));
+}
+
+/*****************************************************************************/
+/* Restart policies: how many times the base nodes run N (from 0) may take.  */
+/* Luby's sequence, 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ..., is within a constant  */
+/* factor of the best fixed run length whatever the distribution of run      */
+/* lengths; the geometric one grows by half each run.  Both stop growing     */
+/* long before they could overflow.                                          */
+/*****************************************************************************/
+static long luby_run(long run)
+{
+  long size;
+  int power;
+
+  for (size=1, power=0; size < run+1; power++, size=(2*size)+1)
+  {
+  }
+
+  while (size-1 != run)
+  {
+    size = (size-1) / 2;
+    power--;
+    run = run % size;
+  }
+
+  return ((power < 30) ? (1L << power) : (1L << 30));
+}
+
+static long geometric_run(long run)
+{
+  long length = 1;
+
+  for (; (run > 0) && (length < (1L << 30)); run--)
+  {
+    length += (length + 1) / 2;
+  }
+
+  return (length);
+}
+
+/*****************************************************************************/
+/* Picks one of a mask of candidates at random.                              */
+/*****************************************************************************/
+static unsigned short random_candidate(sudoku_solver_t *sv,
+                                       unsigned short cands)
+{
+  unsigned long skip = rng_next(&sv->rng) % (unsigned long)POPCOUNT(cands);
+
+  for (; skip > 0; skip--)
+  {
+    cands &= (unsigned short)(cands - 1);
+  }
+
+  return ((unsigned short)(cands & (~cands + 1)));
+}
+
+static int attempt_to_solve(sudoku_solver_t *sv)
+{
+  int ii = 0;
+  int jj = 0;
+  int success = TRUE;
+  unsigned short saved_entry;
+  unsigned short guess;
+  int saved_known;
+  int mark;
+
+  /***************************************************************************/
+  /* Give up straight away if another thread has found the solution.         */
+  /***************************************************************************/
+  if ((sv->stop != NULL) &&
+      (ATOMIC_LOAD(sv->stop) != FALSE))
+  {
+    return (FALSE);
+  }
+
+  /***************************************************************************/
+  /* Or if this solve has used up its budget.                                */
+  /***************************************************************************/
+  if (over_budget(sv) == TRUE)
+  {
+    return (FALSE);
+  }
+
+  /***************************************************************************/
+  /* Increment recursion depth count.  We dump this info on completion for   */
+  /* curiosity's sake.                                                       */
+  /***************************************************************************/
+  sv->cur_rec_depth++;
+
+  if (sv->max_rec_depth < sv->cur_rec_depth)
+  {
+    /*************************************************************************/
+    /* We need to update the deepest-ever recursion statistic.               */
+    /*************************************************************************/
+    sv->max_rec_depth = sv->cur_rec_depth;
+  }
+
+  /***************************************************************************/
+  /* Apply the logical conditions of Sudoku to every entry that has been     */
+  /* fixed since we last looked, and then the other deduction rules, until   */
+  /* they achieve nothing more.  If that leaves the array inconsistent we    */
+  /* have failed and an outer recursion will backtrack and guess a different */
+  /* value for an entry.                                                     */
+  /***************************************************************************/
+  if (sv->deduced == TRUE)
+  {
+    sv->deduced = FALSE;
+  }
+  else if (deduce(sv) == FALSE)
+  {
+    success = FALSE;
+    goto EXIT;
+  }
+
+  ASSERT(number_known(sv) == sv->grid.known);
+
+  if (sv->grid.known == (SIZE * SIZE))
+  {
+    /*************************************************************************/
+    /* We've solved the puzzle.  Return with success, unless we're counting  */
+    /* solutions and want more, in which case carry on as if this had been   */
+    /* a dead end.                                                           */
+    /*************************************************************************/
+    success = found_solution(sv);
+    goto EXIT;
+  }
+
+  /***************************************************************************/
+  /* Not got a complete solution yet so we have to start guessing.  Let the  */
+  /* branching heuristic choose an entry with more than one possible value.  */
+  /***************************************************************************/
+  sv->brancher->pick(sv, &ii, &jj);
+  ASSERT(!IS_FIXED(ii,jj));
+
+  /***************************************************************************/
+  /* Save off a copy the entry candidate list that we're going to use.       */
+  /* We're going to overwrite the data soon but we need to use it.           */
+  /***************************************************************************/
+  saved_entry = CANDS(ii,jj);
+
+  /***************************************************************************/
+  /* Remember where the trail and the known count stand, so that every       */
+  /* guess can be rolled back to this partially-completed sv->grid.          */
+  /***************************************************************************/
+  mark = sv->trail_top;
+  saved_known = sv->grid.known;
+
+  /***************************************************************************/
+  /* Wind through each candidate, lowest first or in random order when       */
+  /* restarting, attempting to solve the puzzle by trying to solve it using  */
+  /* each of them in turn, unless the budget runs out.                       */
+  /***************************************************************************/
+  while ((saved_entry != 0) &&
+         (sv->exceeded == FALSE))
+  {
+    /*************************************************************************/
+    /* Peel the next candidate off the saved list.                           */
+    /*************************************************************************/
+    guess = (sv->randomize == TRUE) ?
+            random_candidate(sv, saved_entry) :
+            (unsigned short)(saved_entry & (~saved_entry + 1));
+    saved_entry &= (unsigned short)~guess;
+
+    /*************************************************************************/
+    /* Set up the entry to make it look as though we've decided the value    */
+    /* of this entry.  This queues it for propagation by the recursion.      */
+    /*************************************************************************/
+    fix_entry(sv, ii, jj, guess);
+    STAT(guesses, 1);
+
+    /*************************************************************************/
+    /* Recursively attempt to solve the grid now we've fixed an extra point  */
+    /* as an educated guess.                                                 */
+    /*************************************************************************/
+    success = attempt_to_solve(sv);
+
+    if (success == TRUE)
+    {
+      /***********************************************************************/
+      /* We have a solution so quit.                                         */
+      /***********************************************************************/
+      goto EXIT;
+    }
+    else
+    {
+      /***********************************************************************/
+      /* Restore the old partially-completed sudoku from before we failed.   */
+      /***********************************************************************/
+      undo_to(sv, mark);
+      sv->grid.known = saved_known;
+      STAT(backtracks, 1);
+    }
+  }
+
+EXIT:
+
+  /***************************************************************************/
+  /* Decrement the current number of recursions.                             */
+  /***************************************************************************/
+  sv->cur_rec_depth--;
+
+  return (success);
+}
+
+/*****************************************************************************/
+/* Counts the solution in the grid, keeping it if it's the first.  Returns   */
+/* TRUE if that's as many as we're looking for, so the search should stop.   */
+/*****************************************************************************/
+static int found_solution(sudoku_solver_t *sv)
+{
+#ifndef NO_STATS
+  if (do_check(sv) == FALSE)
+  {
+    STAT(check_failures, 1);
+  }
+#endif
+  ASSERT(do_check(sv) == TRUE);
+
+  if (sv->num_solutions == 0)
+  {
+    memcpy(&sv->solution, &sv->grid, sizeof(sv->grid));
+  }
+  sv->num_solutions++;
+
+  return (sv->num_solutions >= sv->count_limit);
+}
+
+/*****************************************************************************/
+/* Starts the budget for a new solve.                                        */
+/*****************************************************************************/
+static void start_budget(sudoku_solver_t *sv)
+{
+  sv->nodes = 0;
+  sv->exceeded = FALSE;
+  sv->deadline = (sv->max_seconds > 0) ? (now_seconds() + sv->max_seconds) : 0;
+  return;
+}
+
+/*****************************************************************************/
+/* Counts a search node against the budget, reading the clock only every so  */
+/* often.  Returns TRUE once the budget is exceeded, and from then on until  */
+/* the next solve starts, so the whole search unwinds.  The end of a run     */
+/* when restarting, or having lost a race, unwinds the search the same way.  */
+/*****************************************************************************/
+static int over_budget(sudoku_solver_t *sv)
+{
+  sv->nodes++;
+
+  if (((sv->max_nodes > 0) &&
+       (sv->nodes > sv->max_nodes)) ||
+      ((sv->deadline > 0) &&
+       ((sv->nodes % CLOCK_INTERVAL) == 0) &&
+       (now_seconds() > sv->deadline)))
+  {
+    sv->exceeded = TRUE;
+  }
+  else if ((sv->run_limit > 0) &&
+           (sv->nodes > sv->run_limit))
+  {
+    sv->exceeded = TRUE;
+    sv->run_over = TRUE;
+  }
+#ifndef NO_THREADS
+  else if ((sv->race != NULL) &&
+           ((sv->nodes % CLOCK_INTERVAL) == 0) &&
+           (race_lost(sv) == TRUE))
+  {
+    sv->exceeded = TRUE;
+  }
+#endif
+
+  return (sv->exceeded);
+}
+
+/*****************************************************************************/
+/* The outcome of a solve, given whether the engine found a solution.  A     */
+/* search cut short by its budget before finding as many solutions as it was */
+/* looking for doesn't count as solved, even if it found some.               */
+/*****************************************************************************/
+static int outcome(const sudoku_solver_t *sv, int success)
+{
+  return (((sv->exceeded == TRUE) &&
+           (sv->num_solutions < sv->count_limit)) ? SUDOKU_BUDGET_EXCEEDED :
+          (success == TRUE) ? SUDOKU_SOLVED : SUDOKU_NO_SOLUTION);
+}
+
+/*****************************************************************************/
+/* Solves the loaded puzzle with the given function, unless the cache has    */
+/* the result.  A puzzle whose canonical form can't be found is just solved, */
+/* as is any puzzle of a variant other than the standard one: the canonical  */
+/* forms don't keep to any other units.  The cache's solution is for the     */
+/* canonical form, so it's mapped back to the puzzle's own entries and       */
+/* values, and the solution found for a new puzzle is mapped the other way   */
+/* before it's kept.                                                         */
+/*****************************************************************************/
+static int solve_cached(sudoku_solver_t *sv,
+                        int (*solve)(sudoku_solver_t *))
+{
+  struct canon transform;
+  int values[SUDOKU_CELLS];
+  int canonical[SUDOKU_CELLS];
+  int solution[SUDOKU_CELLS];
+  long solutions;
+  int success;
+  int nn;
+
+  grid_values(sv, values);
+
+  if ((sv->units.regular == FALSE) ||
+      (canon_form(&sv->canon, values, canonical, &transform) == FALSE))
+  {
+    return (solve(sv));
+  }
+
+  if (cache_find(sv->cache,
+                 canonical,
+                 sv->count_limit,
+                 solution,
+                 &solutions) == TRUE)
+  {
+    sv->num_solutions = solutions;
+
+    if (solutions == 0)
+    {
+      return (FALSE);
+    }
+
+    canon_unmap(&transform, solution, values);
+
+    for (nn=0; nn < (SIZE*SIZE); nn++)
+    {
+      CANDS(nn / SIZE, nn % SIZE) = (unsigned short)(1 << (values[nn]-1));
+    }
+    sv->grid.known = SIZE*SIZE;
+    return (TRUE);
+  }
+
+  success = solve(sv);
+
+  if (outcome(sv, success) != SUDOKU_BUDGET_EXCEEDED)
+  {
+    memset(solution, 0, sizeof(solution));
+
+    if (success == TRUE)
+    {
+      grid_values(sv, values);
+      canon_map(&transform, values, solution);
+    }
+    cache_keep(sv->cache,
+               canonical,
+               solution,
+               sv->num_solutions,
+               sv->count_limit);
+  }
+  return (success);
+}
+
+/*****************************************************************************/
+/* Once a search is over, puts the first solution it found back in the grid. */
+/* Returns FALSE if there wasn't one.                                        */
+/*****************************************************************************/
+static int first_solution(sudoku_solver_t *sv)
+{
+  if (sv->num_solutions == 0)
+  {
+    return (FALSE);
+  }
+
+  if (sv->num_solutions > sv->count_limit)
+  {
+    sv->num_solutions = sv->count_limit;
+  }
+  memcpy(&sv->grid, &sv->solution, sizeof(sv->grid));
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* The dlx engine.  Hands the givens to the Dancing Links solver and, if it  */
+/* finds a solution, fixes every entry at its value.                         */
+/*****************************************************************************/
+static int solve_dlx(sudoku_solver_t *sv)
+{
+  int values[SUDOKU_CELLS];
+  int solution[SUDOKU_CELLS];
+
+  grid_values(sv, values);
+  sv->dlx.max_nodes = sv->max_nodes;
+  sv->dlx.deadline = sv->deadline;
+  sv->num_solutions = dlx_solve(&sv->dlx, values, solution, sv->count_limit);
+  sv->nodes = sv->dlx.nodes;
+  sv->exceeded = sv->dlx.exceeded;
+  sv->max_rec_depth = sv->dlx.max_depth;
+  STAT(guesses, sv->dlx.guesses);
+  STAT(backtracks, sv->dlx.backtracks);
+
+  return (fill_solution(sv, solution, sv->num_solutions));
+}
+
+/*****************************************************************************/
+/* The cdcl engine, likewise.                                                */
+/*****************************************************************************/
+static int solve_cdcl(sudoku_solver_t *sv)
+{
+  int values[SUDOKU_CELLS];
+  int solution[SUDOKU_CELLS];
+
+  grid_values(sv, values);
+  sv->cdcl.max_nodes = sv->max_nodes;
+  sv->cdcl.deadline = sv->deadline;
+  sv->num_solutions = cdcl_solve(&sv->cdcl,
+                                 &sv->units,
+                                 values,
+                                 solution,
+                                 sv->count_limit);
+  sv->nodes = sv->cdcl.nodes;
+  sv->exceeded = sv->cdcl.exceeded;
+  sv->max_rec_depth = sv->cdcl.max_depth;
+  STAT(guesses, sv->cdcl.guesses);
+  STAT(backtracks, sv->cdcl.backtracks);
+  STAT(backjumps, sv->cdcl.backjumps);
+  STAT(nogoods, sv->cdcl.nogoods);
+  STAT(forgotten, sv->cdcl.forgotten);
+
+  return (fill_solution(sv, solution, sv->num_solutions));
+}
+
+/*****************************************************************************/
+/* The auto engine.  Most puzzles fall to deduction alone, and the logic     */
+/* engine is much the quickest at those.  Of the rest, those that need only  */
+/* a few guesses are still quicker with it, but dlx is quicker at those that */
+/* need more.  So this runs the deduction first, without setting up a        */
+/* search, and stops there if that solves the puzzle or shows it has none.   */
+/* Otherwise it predicts from what the deduction left which of the other two */
+/* the puzzle needs.  One predicted to need the logic engine's search gets a */
+/* probe of it, and a probe that finishes is the answer, solution or not.    */
+/* One that runs out, or a puzzle predicted to need dlx, goes to dlx as far  */
+/* as the deduction got with it, with what's left of the budget.  The route  */
+/* taken and the one predicted go in the statistics, so the prediction can   */
+/* be checked.  The restart policy doesn't apply.                            */
+/*****************************************************************************/
+static int solve_auto(sudoku_solver_t *sv)
+{
+  long max_nodes = sv->max_nodes;
+  long probe_nodes;
+  int max_depth;
+  int success;
+
+  sv->stats.route = SUDOKU_ROUTE_DEDUCTION;
+  sv->stats.predicted_route = SUDOKU_ROUTE_DEDUCTION;
+  sv->max_rec_depth = 1;
+
+  if (deduce(sv) == FALSE)
+  {
+    return (FALSE);
+  }
+
+  if (sv->grid.known == (SIZE * SIZE))
+  {
+    (void)found_solution(sv);
+    return (first_solution(sv));
+  }
+
+  sv->stats.predicted_route = predict_route(sv);
+
+  if (sv->stats.predicted_route == SUDOKU_ROUTE_SEARCH)
+  {
+    /*************************************************************************/
+    /* The search starts from the deduction just done.                       */
+    /*************************************************************************/
+    sv->max_rec_depth = 0;
+    sv->run_limit = PROBE_NODES;
+    sv->run_over = FALSE;
+    sv->deduced = TRUE;
+
+    success = attempt_to_solve(sv);
+
+    sv->run_limit = 0;
+    sv->deduced = FALSE;
+
+    if (sv->run_over == FALSE)
+    {
+      sv->stats.route = SUDOKU_ROUTE_SEARCH;
+      return (first_solution(sv));
+    }
+
+    /*************************************************************************/
+    /* As when restarting, drop the guess the probe stopped at, and any      */
+    /* solutions it found when counting, which dlx will find again.          */
+    /*************************************************************************/
+    sv->queue_head = 0;
+    sv->queue_tail = 0;
+    sv->clash = FALSE;
+    sv->exceeded = FALSE;
+    sv->num_solutions = 0;
+
+    if ((max_nodes > 0) &&
+        (sv->nodes >= max_nodes))
+    {
+      sv->exceeded = TRUE;
+      return (FALSE);
+    }
+  }
+
+  sv->stats.route = SUDOKU_ROUTE_DLX;
+  probe_nodes = sv->nodes;
+  max_depth = sv->max_rec_depth;
+
+  if (max_nodes > 0)
+  {
+    sv->max_nodes = max_nodes - probe_nodes;
+  }
+
+  success = solve_dlx(sv);
+
+  sv->max_nodes = max_nodes;
+  sv->nodes += probe_nodes;
+
+  if (sv->max_rec_depth < max_depth)
+  {
+    sv->max_rec_depth = max_depth;
+  }
+
+  return (success);
+}
+
+/*****************************************************************************/
+/* Predicts whether a puzzle the deduction hasn't finished needs only a      */
+/* little of the logic engine's search, or is better off with dlx, from how  */
+/* far the deduction got with it.  Each entry it fixed is one fewer to       */
+/* guess, and each it left with two candidates is one where a guess is       */
+/* right half the time and a wrong one is soon found out, so the search      */
+/* gets through those quickly however many entries are open.                 */
+/*****************************************************************************/
+static int predict_route(sudoku_solver_t *sv)
+{
+  int progress = sv->grid.known - sv->clues;
+  int nn;
+
+  for (nn=0; nn < (SIZE*SIZE); nn++)
+  {
+    if (CAND_COUNT(nn / SIZE, nn % SIZE) == 2)
+    {
+      progress += 2;
+    }
+  }
+
+  return ((progress >= ROUTE_PROGRESS) ? SUDOKU_ROUTE_SEARCH :
+                                         SUDOKU_ROUTE_DLX);
+}
+
+/*****************************************************************************/
+/* Fixes every entry at its value in a solution found by another engine, if  */
+/* it found any.  Nothing is left to propagate either way.                   */
+/*****************************************************************************/
+static int fill_solution(sudoku_solver_t *sv, const int *solution, long found)
+{
+  int nn;
+
+  if (found > 0)
+  {
+    for (nn=0; nn < (SIZE*SIZE); nn++)
+    {
+      CANDS(nn / SIZE, nn % SIZE) = (unsigned short)(1 << (solution[nn]-1));
+    }
+    sv->grid.known = SIZE*SIZE;
+#ifndef NO_STATS
+    if (do_check(sv) == FALSE)
+    {
+      STAT(check_failures, 1);
+    }
+#endif
+    ASSERT(do_check(sv) == TRUE);
+  }
+
+  sv->queue_head = 0;
+  sv->queue_tail = 0;
+  sv->clash = FALSE;
+
+  return (found > 0);
+}
+
+/*****************************************************************************/
+/* Solves a puzzle of another size with the solver for it, leaving the       */
+/* solution in place of the puzzle.                                          */
+/*****************************************************************************/
+static int solve_sized(sudoku_solver_t *sv)
+{
+  int solution[SUDOKU_MAX_CELLS];
+
+  sv->sized.limit = sv->count_limit;
+  sv->sized.max_nodes = sv->max_nodes;
+  sv->sized.deadline = sv->deadline;
+  sv->num_solutions = sized_solve(&sv->sized, sv->values, solution);
+  sv->nodes = sv->sized.nodes;
+  sv->exceeded = sv->sized.exceeded;
+  sv->max_rec_depth = sv->sized.max_depth;
+  STAT(guesses, sv->sized.guesses);
+  STAT(backtracks, sv->sized.backtracks);
+  STAT(propagations, sv->sized.propagations);
+
+  if (sv->num_solutions > 0)
+  {
+    memcpy(sv->values, solution, sv->size * sv->size * sizeof(solution[0]));
+  }
+
+  return (sv->num_solutions > 0);
+}
+
+/*****************************************************************************/
+/* Pushes the value of each newly fixed entry out to its peers until there   */
+/* are no more newly fixed entries.  Entries fixed along the way are queued  */
+/* in turn, so the work done is proportional to the eliminations made.       */
+/* Returns FALSE as soon as an entry runs out of candidates, or two entries  */
+/* in a unit are fixed at the same value, leaving the queue empty.  This is  */
+/* the scalar propagation kernel.                                            */
+/*****************************************************************************/
+static int propagate(sudoku_solver_t *sv)
+{
+  int nn;
+  int success = TRUE;
+
+  if (sv->clash == TRUE)
+  {
+    success = FALSE;
+    goto EXIT;
+  }
+
+  while (sv->queue_head != sv->queue_tail)
+  {
+    nn = sv->queue[sv->queue_head];
+    sv->queue_head++;
+
+    /*************************************************************************/
+    /* Its peers in its row, then in its column, then in its other units,    */
+    /* each lot credited to its own counter.                                 */
+    /*************************************************************************/
+    if ((eliminate_peers(sv,
+                         nn,
+                         0,
+                         UNITS_LINE_PEERS,
+                         &sv->stats.row_eliminations) == FALSE) ||
+        (eliminate_peers(sv,
+                         nn,
+                         UNITS_LINE_PEERS,
+                         2 * UNITS_LINE_PEERS,
+                         &sv->stats.col_eliminations) == FALSE) ||
+        (eliminate_peers(sv,
+                         nn,
+                         2 * UNITS_LINE_PEERS,
+                         sv->units.num_peers[nn],
+                         &sv->stats.blk_eliminations) == FALSE))
+    {
+      success = FALSE;
+      goto EXIT;
+    }
+  }
+
+EXIT:
+
+  /***************************************************************************/
+  /* Whatever happened, there's nothing left worth propagating.              */
+  /***************************************************************************/
+  sv->queue_head = 0;
+  sv->queue_tail = 0;
+  sv->clash = FALSE;
+
+  return (success);
+}
+
+/*****************************************************************************/
+/* Knocks the value of a fixed entry out of its peers from first to last-1   */
+/* in its list, adding those that had it to the count of eliminations.       */
+/*****************************************************************************/
+static int eliminate_peers(sudoku_solver_t *sv,
+                           int nn,
+                           int first,
+                           int last,
+                           long *eliminations)
+{
+  const unsigned char *peers = sv->units.peers[nn];
+  unsigned short value = CANDS(nn / SIZE, nn % SIZE);
+  int kk;
+
+#ifdef NO_STATS
+  (void)eliminations;
+#endif
+
+  for (kk=first; kk < last; kk++)
+  {
+#ifndef NO_STATS
+    *eliminations +=
+      ((CANDS(peers[kk] / SIZE, peers[kk] % SIZE) & value) != 0);
+#endif
+
+    if (eliminate(sv, peers[kk] / SIZE, peers[kk] % SIZE, value) == FALSE)
+    {
+      return (FALSE);
+    }
+  }
+  return (TRUE);
+}
+
+#ifdef HAVE_SIMD
+/*****************************************************************************/
+/* AVX2 propagation kernel.  A row of entries fits in one vector.  Each pass */
+/* works down the rows, removing the values fixed in each entry's units from */
+/* every entry not yet fixed, and applies the changes one entry at a time so */
+/* that they go on the trail.  Passes repeat until one fixes nothing new.    */
+/* Contradictions are caught as they're applied: an entry left with no       */
+/* candidates, or fixed at a value already fixed in one of its units.        */
+/*                                                                           */
+/* With the standard units, the row's three blocks' masks are spread across  */
+/* the vector as they are; with any others, each entry's are gathered.       */
+/*                                                                           */
+/* Loading sixteen entries from a row, or the column masks, reads on into    */
+/* the rest of the grid.  The extra lanes are ignored.                       */
+/*****************************************************************************/
+__attribute__((target("avx2")))
+static int propagate_avx2(sudoku_solver_t *sv)
+{
+  unsigned short next[16];
+  unsigned short other[16];
+  unsigned short *blk;
+  __m256i cand;
+  __m256i elim;
+  __m256i fixed;
+  __m256i zero = _mm256_setzero_si256();
+  __m256i one = _mm256_set1_epi16(1);
+  unsigned int changed;
+  int ii;
+  int jj;
+  int again = (sv->queue_head != sv->queue_tail);
+  int success = TRUE;
+
+  memset(other, 0, sizeof(other));
+
+  while ((again == TRUE) &&
+         (sv->clash == FALSE))
+  {
+    again = FALSE;
+
+    for (ii=0; ii < SIZE; ii++)
+    {
+      if (sv->units.regular == TRUE)
+      {
+        blk = &sv->grid.unit_fixed[(2*SIZE) + ((ii/BLOCK_SIZE)*BLOCK_SIZE)];
+        elim = _mm256_setr_epi16((short)blk[0], (short)blk[0], (short)blk[0],
+                                 (short)blk[1], (short)blk[1], (short)blk[1],
+                                 (short)blk[2], (short)blk[2], (short)blk[2],
+                                 0, 0, 0, 0, 0, 0, 0);
+      }
+      else
+      {
+        for (jj=0; jj < SIZE; jj++)
+        {
+          other[jj] = entry_fixed(sv, (ii * SIZE) + jj);
+        }
+        elim = _mm256_loadu_si256((const __m256i *)other);
+      }
+      elim = _mm256_or_si256(elim,
+                             _mm256_set1_epi16((short)
+                                               sv->grid.unit_fixed[ii]));
+      elim = _mm256_or_si256(elim,
+                             _mm256_loadu_si256((const __m256i *)
+                                                &sv->grid.unit_fixed[SIZE]));
+
+      /***********************************************************************/
+      /* Fixed entries keep their value; the rest lose the eliminated ones.  */
+      /***********************************************************************/
+      cand = _mm256_loadu_si256((const __m256i *)sv->grid.cand[ii]);
+      fixed = _mm256_cmpeq_epi16(_mm256_and_si256(cand,
+                                                  _mm256_sub_epi16(cand, one)),
+                                 zero);
+      elim = _mm256_andnot_si256(_mm256_andnot_si256(fixed, elim), cand);
+
+      changed = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi16(elim,
+                                                                       cand)) &
+                ((1u << (2*SIZE)) - 1);
+
+      if (changed == 0)
+      {
+        continue;
+      }
+
+      _mm256_storeu_si256((__m256i *)next, elim);
+
+      do
+      {
+        jj = CTZ(changed) / 2;
+        changed &= ~(3u << (2*jj));
+
+        if (kernel_update(sv, ii, jj, next[jj], &again) == FALSE)
+        {
+          success = FALSE;
+          goto EXIT;
+        }
+      } while (changed != 0);
+    }
+  }
+
+  if (sv->clash == TRUE)
+  {
+    success = FALSE;
+  }
+
+EXIT:
+
+  sv->queue_head = 0;
+  sv->queue_tail = 0;
+  sv->clash = FALSE;
+
+  return (success);
+}
+
+/*****************************************************************************/
+/* SSE2 propagation kernel.  As for AVX2, but a vector holds only eight      */
+/* entries, so the last column is done on its own.                           */
+/*****************************************************************************/
+__attribute__((target("sse2")))
+static int propagate_sse2(sudoku_solver_t *sv)
+{
+  unsigned short next[8];
+  unsigned short other[8];
+  unsigned short *blk;
+  unsigned short value;
+  __m128i cand;
+  __m128i elim;
+  __m128i fixed;
+  __m128i zero = _mm_setzero_si128();
+  __m128i one = _mm_set1_epi16(1);
+  unsigned int changed;
+  int ii;
+  int jj;
+  int again = (sv->queue_head != sv->queue_tail);
+  int success = TRUE;
+
+  while ((again == TRUE) &&
+         (sv->clash == FALSE))
+  {
+    again = FALSE;
+
+    for (ii=0; ii < SIZE; ii++)
+    {
+      if (sv->units.regular == TRUE)
+      {
+        blk = &sv->grid.unit_fixed[(2*SIZE) + ((ii/BLOCK_SIZE)*BLOCK_SIZE)];
+        elim = _mm_setr_epi16((short)blk[0], (short)blk[0], (short)blk[0],
+                              (short)blk[1], (short)blk[1], (short)blk[1],
+                              (short)blk[2], (short)blk[2]);
+      }
+      else
+      {
+        for (jj=0; jj < 8; jj++)
+        {
+          other[jj] = entry_fixed(sv, (ii * SIZE) + jj);
+        }
+        elim = _mm_loadu_si128((const __m128i *)other);
+      }
+      elim = _mm_or_si128(elim,
+                          _mm_set1_epi16((short)sv->grid.unit_fixed[ii]));
+      elim = _mm_or_si128(elim,
+                          _mm_loadu_si128((const __m128i *)
+                                          &sv->grid.unit_fixed[SIZE]));
+
+      cand = _mm_loadu_si128((const __m128i *)sv->grid.cand[ii]);
+      fixed = _mm_cmpeq_epi16(_mm_and_si128(cand, _mm_sub_epi16(cand, one)),
+                              zero);
+      elim = _mm_andnot_si128(_mm_andnot_si128(fixed, elim), cand);
+
+      changed = ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi16(elim, cand)) &
+                0xFFFF;
+
+      if (changed != 0)
+      {
+        _mm_storeu_si128((__m128i *)next, elim);
+
+        do
+        {
+          jj = CTZ(changed) / 2;
+          changed &= ~(3u << (2*jj));
+
+          if (kernel_update(sv, ii, jj, next[jj], &again) == FALSE)
+          {
+            success = FALSE;
+            goto EXIT;
+          }
+        } while (changed != 0);
+      }
+
+      /***********************************************************************/
+      /* The last column.                                                    */
+      /***********************************************************************/
+      jj = SIZE - 1;
+
+      if (!IS_FIXED(ii,jj))
+      {
+        value = (unsigned short)(CANDS(ii,jj) &
+                                 ~entry_fixed(sv, (ii * SIZE) + jj));
+
+        if ((value != CANDS(ii,jj)) &&
+            (kernel_update(sv, ii, jj, value, &again) == FALSE))
+        {
+          success = FALSE;
+          goto EXIT;
+        }
+      }
+    }
+  }
+
+  if (sv->clash == TRUE)
+  {
+    success = FALSE;
+  }
+
+EXIT:
+
+  sv->queue_head = 0;
+  sv->queue_tail = 0;
+  sv->clash = FALSE;
+
+  return (success);
+}
+
+/*****************************************************************************/
+/* Gives an entry the candidates a vector kernel worked out for it, noting   */
+/* it as fixed (and setting *fixed) if that leaves only one.  Returns FALSE  */
+/* if it leaves none.  Inlined, as it's called for every change they make.  */
+/*****************************************************************************/
+static inline __attribute__((always_inline))
+int kernel_update(sudoku_solver_t *sv,
+                  int ii,
+                  int jj,
+                  unsigned short value,
+                  int *fixed)
+{
+#ifndef NO_STATS
+  unsigned short removed = (unsigned short)(CANDS(ii,jj) & ~value);
+
+  /***************************************************************************/
+  /* Credit the eliminations to the row first, then the column, then the     */
+  /* other units, as the scalar kernel would.                                */
+  /***************************************************************************/
+  STAT(row_eliminations, POPCOUNT(removed & sv->grid.unit_fixed[ii]));
+  removed &= (unsigned short)~sv->grid.unit_fixed[ii];
+  STAT(col_eliminations, POPCOUNT(removed & sv->grid.unit_fixed[SIZE + jj]));
+  removed &= (unsigned short)~sv->grid.unit_fixed[SIZE + jj];
+  STAT(blk_eliminations, POPCOUNT(removed));
+#endif
+
+  trail_set(sv, &CANDS(ii,jj), value);
+
+  if (value == 0)
+  {
+    return (FALSE);
+  }
+
+  if (IS_FIXED(ii,jj))
+  {
+    note_fixed(sv, ii,jj);
+    *fixed = TRUE;
+  }
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* The values fixed in any of an entry's units.                              */
+/*****************************************************************************/
+static unsigned short entry_fixed(const sudoku_solver_t *sv, int nn)
+{
+  unsigned short fixed = 0;
+  int uu;
+
+  for (uu=0; uu < sv->units.num_of[nn]; uu++)
+  {
+    fixed |= sv->grid.unit_fixed[sv->units.of[nn][uu]];
+  }
+  return (fixed);
+}
+
+/*****************************************************************************/
+/* Whether the processor has the instructions the vector kernels need.       */
+/*****************************************************************************/
+static int have_sse2(void)
+{
+  __builtin_cpu_init();
+  return (__builtin_cpu_supports("sse2") ? TRUE : FALSE);
+}
+
+static int have_avx2(void)
+{
+  __builtin_cpu_init();
+  return (__builtin_cpu_supports("avx2") ? TRUE : FALSE);
+}
+#endif
+
+#ifdef HAVE_LOCKSTEP
+/*****************************************************************************/
+/* Solves the next pack of up to LANES puzzles of a batch, starting at job   */
+/* first, and returns the job after the last one it took.  Bad input is      */
+/* marked straight away and takes no lane.                                   */
+/*                                                                           */
+/* Each puzzle is loaded as usual and its candidates copied into its lane.   */
+/* The lanes then go through the deduction in lockstep, and each one that    */
+/* neither fails nor comes out solved is copied back into the grid and       */
+/* given to the engine on its own, which finds nothing left to deduce.       */
+/* Lockstep deduction finds exactly what deduce() would before the first     */
+/* guess, so the results are the same as solving the puzzles one by one.     */
+/*****************************************************************************/
+static long solve_pack(sudoku_solver_t *sv,
+                       sudoku_job_t *jobs,
+                       long first,
+                       long last)
+{
+  lanes_t cells[SIZE*SIZE];
+  lanes_t dead;
+  long lane_job[LANES];
+  int lane_clues[LANES];
+  int num_lanes = 0;
+  double start = STAT_CLOCK();
+  double share;
+  int ll;
+  int nn;
+
+  memset(cells, 0, sizeof(cells));
+
+  for (; (first < last) && (num_lanes < LANES); first++)
+  {
+    if (load_line(sv, jobs[first].line) == FALSE)
+    {
+      bad_job(&jobs[first]);
+      continue;
+    }
+
+    for (nn=0; nn < (SIZE*SIZE); nn++)
+    {
+      cells[nn][num_lanes] = CANDS(nn / SIZE, nn % SIZE);
+    }
+    lane_clues[num_lanes] = sv->clues;
+    lane_job[num_lanes++] = first;
+  }
+
+  /***************************************************************************/
+  /* Unused lanes are left empty, so come out dead, and are ignored.         */
+  /***************************************************************************/
+#ifdef HAVE_SIMD
+  if (sv->kernel->propagate == propagate_avx2)
+  {
+    lockstep_avx2(sv, cells, &dead);
+  }
+  else
+#endif
+  {
+    lockstep_plain(sv, cells, &dead);
+  }
+
+  /***************************************************************************/
+  /* Each puzzle is charged an equal share of the time spent on the pack so  */
+  /* far, as if its own solve had begun that long ago.                       */
+  /***************************************************************************/
+  share = (num_lanes > 0) ? ((STAT_CLOCK() - start) / num_lanes) : 0;
+
+  for (ll=0; ll < num_lanes; ll++)
+  {
+    start = STAT_CLOCK() - share;
+    start_budget(sv);
+
+    if (dead[ll] != 0)
+    {
+      /***********************************************************************/
+      /* The deduction has settled it, as the auto engine would say.         */
+      /***********************************************************************/
+      clear_grid(sv);
+      if (sv->engine->solve == solve_auto)
+      {
+        sv->stats.route = SUDOKU_ROUTE_DEDUCTION;
+        sv->stats.predicted_route = SUDOKU_ROUTE_DEDUCTION;
+      }
+      finish_job(sv, &jobs[lane_job[ll]], FALSE, start);
+    }
+    else
+    {
+      load_lane(sv, cells, ll);
+      sv->clues = lane_clues[ll];
+      finish_job(sv, &jobs[lane_job[ll]], sv->engine->solve(sv), start);
+    }
+  }
+
+  return (first);
+}
+
+/*****************************************************************************/
+/* Replaces the grid with one lane of a lockstep pack.  Its fixed values     */
+/* have already been propagated, so nothing is queued.                       */
+/*****************************************************************************/
+static void load_lane(sudoku_solver_t *sv, const lanes_t *cells, int lane)
+{
+  int ii;
+  int jj;
+  int uu;
+
+  clear_grid(sv);
+
+  for (ii=0; ii < SIZE; ii++)
+  {
+    for (jj=0; jj < SIZE; jj++)
+    {
+      CANDS(ii,jj) = cells[(ii * SIZE) + jj][lane];
+
+      if (IS_FIXED(ii,jj))
+      {
+        for (uu=0; uu < sv->units.num_of[(ii * SIZE) + jj]; uu++)
+        {
+          sv->grid.unit_fixed[sv->units.of[(ii * SIZE) + jj][uu]] |=
+            CANDS(ii,jj);
+        }
+        sv->grid.known++;
+      }
+    }
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Lockstep deduction.  cells[] holds one vector per entry, with one puzzle  */
+/* in each lane.  Works every lane through to the point where neither        */
+/* propagating fixed values nor, if it's the first active rule, hidden       */
+/* singles find anything more, and sets a lane of *dead wherever that turns  */
+/* up a contradiction.  There are no branches on any one lane's contents,    */
+/* so a pass costs the same however many lanes it changes.                   */
+/*                                                                           */
+/* Both steps only ever remove candidates, so the order they're applied in   */
+/* doesn't change where they end up.  The body is built once for each        */
+/* instruction set by the wrappers below.                                    */
+/*****************************************************************************/
+static inline __attribute__((always_inline))
+void lockstep_deduce(const sudoku_solver_t *sv, lanes_t *cells, lanes_t *dead)
+{
+  lanes_t fixed[UNITS_MAX];
+  lanes_t zero;
+  lanes_t all;
+  lanes_t cand;
+  lanes_t single;
+  lanes_t elim;
+  lanes_t next;
+  lanes_t once;
+  lanes_t twice;
+  lanes_t value;
+  lanes_t diff;
+  int hidden;
+  int changed;
+  int uu;
+  int kk;
+  int nn;
+  int ll;
+
+  memset(&zero, 0, sizeof(zero));
+  all = zero + ALL_CANDIDATES;
+  *dead = zero;
+  hidden = ((sv->num_active_rules > 0) &&
+            (sv->active_rules[0] == &rules[0]));
+
+  do
+  {
+    /*************************************************************************/
+    /* Propagate fixed values until nothing more gets fixed.  Gather the     */
+    /* values fixed in each unit (two entries fixed at the same value are a  */
+    /* contradiction) and remove them from every entry not yet fixed.  An    */
+    /* entry left with nothing is a contradiction.                           */
+    /*************************************************************************/
+    do
+    {
+      for (uu=0; uu < sv->units.count; uu++)
+      {
+        once = zero;
+
+        for (kk=0; kk < SIZE; kk++)
+        {
+          cand = cells[sv->units.entries[uu][kk]];
+          single = cand & LANES_ZERO(cand & (cand - 1));
+          *dead |= once & single;
+          once |= single;
+        }
+        fixed[uu] = once;
+      }
+
+      diff = zero;
+
+      for (nn=0; nn < (SIZE*SIZE); nn++)
+      {
+        cand = cells[nn];
+        elim = zero;
+
+        for (uu=0; uu < sv->units.num_of[nn]; uu++)
+        {
+          elim |= fixed[sv->units.of[nn][uu]];
+        }
+        single = LANES_ZERO(cand & (cand - 1));
+        next = cand & ~(elim & ~single);
+        *dead |= LANES_ZERO(next);
+        diff |= next ^ cand;
+        cells[nn] = next;
+      }
+
+      for (ll=0, changed=FALSE; ll < LANES; ll++)
+      {
+        changed |= (diff[ll] != 0);
+      }
+    } while (changed);
+
+    if (!hidden)
+    {
+      break;
+    }
+
+    /*************************************************************************/
+    /* Hidden singles, as rule_hidden_single() finds them.                   */
+    /*************************************************************************/
+    diff = zero;
+
+    for (uu=0; uu < sv->units.count; uu++)
+    {
+      once = zero;
+      twice = zero;
+
+      for (kk=0; kk < SIZE; kk++)
+      {
+        cand = cells[sv->units.entries[uu][kk]];
+        twice |= once & cand;
+        once |= cand;
+      }
+
+      *dead |= all & ~once;
+      once &= ~twice;
+
+      for (kk=0; kk < SIZE; kk++)
+      {
+        nn = sv->units.entries[uu][kk];
+        cand = cells[nn];
+        single = LANES_ZERO(cand & (cand - 1));
+        value = cand & once & ~single;
+        *dead |= LANES_NONZERO(value & (value - 1));
+        next = value | (cand & LANES_ZERO(value));
+        diff |= next ^ cand;
+        cells[nn] = next;
+      }
+    }
+
+    for (ll=0, changed=FALSE; ll < LANES; ll++)
+    {
+      changed |= (diff[ll] != 0);
+    }
+  } while (changed);
+
+  return;
+}
+
+static void lockstep_plain(const sudoku_solver_t *sv,
+                           lanes_t *cells,
+                           lanes_t *dead)
+{
+  lockstep_deduce(sv, cells, dead);
+  return;
+}
+
+#ifdef HAVE_SIMD
+__attribute__((target("avx2")))
+static void lockstep_avx2(const sudoku_solver_t *sv,
+                          lanes_t *cells,
+                          lanes_t *dead)
+{
+  lockstep_deduce(sv, cells, dead);
+  return;
+}
+#endif
+#endif
+
+/*****************************************************************************/
+/* Removes a candidate from an entry.  If that leaves a single candidate the */
+/* entry is fixed and queued for propagation; if it leaves none we have a    */
+/* contradiction and return FALSE.                                           */
+/*****************************************************************************/
+static int eliminate(sudoku_solver_t *sv, int ii, int jj, unsigned short value)
+{
+  if ((CANDS(ii,jj) & value) == 0)
+  {
+    /*************************************************************************/
+    /* Not a candidate anyway.  Nothing to do.                               */
+    /*************************************************************************/
+    return (TRUE);
+  }
+
+  trail_set(sv, &CANDS(ii,jj), (unsigned short)(CANDS(ii,jj) & ~value));
+
+  if (CANDS(ii,jj) == 0)
+  {
+    return (FALSE);
+  }
+
+  if (IS_FIXED(ii,jj))
+  {
+    /*************************************************************************/
+    /* We have uniqueness.                                                   */
+    /*************************************************************************/
+    note_fixed(sv, ii,jj);
+  }
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Records a newly fixed entry: its value goes in the masks for its units,   */
+/* the count of known entries goes up, and the entry is queued so that       */
+/* propagation will push its value out to its peers.  If the value is        */
+/* already fixed in one of those units, that's flagged as a clash.           */
+/*****************************************************************************/
+static void note_fixed(sudoku_solver_t *sv, int ii, int jj)
+{
+  unsigned short *fixed;
+  int nn = (ii * SIZE) + jj;
+  int uu;
+
+  ASSERT((CANDS(ii,jj) != 0) && IS_FIXED(ii,jj));
+  ASSERT(sv->queue_tail < (SIZE*SIZE));
+
+  for (uu=0; uu < sv->units.num_of[nn]; uu++)
+  {
+    fixed = &sv->grid.unit_fixed[sv->units.of[nn][uu]];
+
+    if ((*fixed & CANDS(ii,jj)) != 0)
+    {
+      sv->clash = TRUE;
+    }
+    trail_set(sv, fixed, (unsigned short)(*fixed | CANDS(ii,jj)));
+  }
+  sv->grid.known++;
+
+  sv->queue[sv->queue_tail++] = (unsigned char)nn;
+  return;
+}
+
+/*****************************************************************************/
+/* Changes a mask, first recording its old value on the undo trail.  Masks   */
+/* that wouldn't actually change aren't recorded, which keeps the trail      */
+/* within TRAIL_SIZE.                                                        */
+/*****************************************************************************/
+static void trail_set(sudoku_solver_t *sv,
+                      unsigned short *where,
+                      unsigned short value)
+{
+  if (*where != value)
+  {
+    ASSERT(sv->trail_top < TRAIL_SIZE);
+
+    sv->trail[sv->trail_top].where = where;
+    sv->trail[sv->trail_top].old = *where;
+    sv->trail_top++;
+    *where = value;
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Backtracks by undoing every change recorded on the trail since the mark.  */
+/*****************************************************************************/
+static void undo_to(sudoku_solver_t *sv, int mark)
+{
+  while (sv->trail_top > mark)
+  {
+    sv->trail_top--;
+    *(sv->trail[sv->trail_top].where) = sv->trail[sv->trail_top].old;
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Fixes an entry at a value, as for a given.  The value must be one of its  */
+/* candidates.                                                               */
+/*****************************************************************************/
+static void fix_entry(sudoku_solver_t *sv,
+                      int ii,
+                      int jj,
+                      unsigned short value)
+{
+  ASSERT((CANDS(ii,jj) & value) == value);
+
+  trail_set(sv, &CANDS(ii,jj), value);
+  note_fixed(sv, ii,jj);
+  return;
+}
+
+/*****************************************************************************/
+/* Builds the lookup tables the subset rules use, listing every mask with    */
+/* two or three bits set among the low SIZE bits, standing for positions in  */
+/* a unit or for values.  The units have tables of their own (see units.h).  */
+/*****************************************************************************/
+static void build_tables(sudoku_solver_t *sv)
+{
+  int nn;
+  int mask;
+
+  for (nn=0; nn <= MAX_SUBSET; nn++)
+  {
+    sv->num_subsets[nn] = 0;
+  }
+
+  for (mask=1; mask <= ALL_CANDIDATES; mask++)
+  {
+    nn = POPCOUNT(mask);
+
+    if ((nn >= 2) && (nn <= MAX_SUBSET))
+    {
+      sv->subsets[nn][sv->num_subsets[nn]++] = (unsigned short)mask;
+    }
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Applies the enabled deduction rules, in their configured order, until     */
+/* none of them can make any more progress.  Cheap propagation of fixed      */
+/* values always runs first, and whenever a rule changes anything we start   */
+/* again from the top so that the cheaper rules get first go at the result.  */
+/* Returns FALSE if a contradiction turns up.                                */
+/*****************************************************************************/
+static int deduce(sudoku_solver_t *sv)
+{
+  int ii;
+  int rc;
+  int success = TRUE;
+
+  do
+  {
+    STAT(propagations, 1);
+
+    if (sv->kernel->propagate(sv) == FALSE)
+    {
+      success = FALSE;
+      goto EXIT;
+    }
+
+    if (sv->grid.known == (SIZE * SIZE))
+    {
+      goto EXIT;
+    }
+
+    for (ii=0; ii < sv->num_active_rules; ii++)
+    {
+      rc = sv->active_rules[ii]->apply(sv);
+
+      if (rc == CONTRADICTION)
+      {
+        success = FALSE;
+        goto EXIT;
+      }
+
+      if (rc > 0)
+      {
+        /*********************************************************************/
+        /* This rule got somewhere.  Propagate what it found.                */
+        /*********************************************************************/
+        sv->rule_hits[sv->active_rules[ii] - rules] += rc;
+        break;
+      }
+    }
+  } while (ii < sv->num_active_rules);
+
+EXIT:
+
+  /***************************************************************************/
+  /* A rule may have queued entries before finding a contradiction.          */
+  /***************************************************************************/
+  sv->queue_head = 0;
+  sv->queue_tail = 0;
+  sv->clash = FALSE;
+
+  return (success);
+}
+
+/*****************************************************************************/
+/* Rule: hidden singles.  A value that has only one possible place in a unit */
+/* must go there.  A value with no place at all is a contradiction, as is an */
+/* entry that is the only place for two values.                              */
+/*****************************************************************************/
+static int rule_hidden_single(sudoku_solver_t *sv)
+{
+  int uu;
+  int kk;
+  int ii;
+  int jj;
+  unsigned short once;
+  unsigned short twice;
+  unsigned short value;
+  int fired = 0;
+
+  for (uu=0; uu < sv->units.count; uu++)
+  {
+    /*************************************************************************/
+    /* Find the values that are candidates in exactly one entry.             */
+    /*************************************************************************/
+    once = 0;
+    twice = 0;
+
+    for (kk=0; kk < SIZE; kk++)
+    {
+      twice |= (unsigned short)(once & UNIT_CANDS(uu,kk));
+      once |= UNIT_CANDS(uu,kk);
+    }
+
+    if (once != ALL_CANDIDATES)
+    {
+      return (CONTRADICTION);
+    }
+
+    once &= (unsigned short)~twice;
+
+    for (kk=0; (kk < SIZE) && (once != 0); kk++)
+    {
+      value = (unsigned short)(UNIT_CANDS(uu,kk) & once);
+
+      if ((value != 0) && (POPCOUNT(UNIT_CANDS(uu,kk)) > 1))
+      {
+        if ((value & (value - 1)) != 0)
+        {
+          return (CONTRADICTION);
+        }
+
+        ii = sv->units.entries[uu][kk] / SIZE;
+        jj = sv->units.entries[uu][kk] % SIZE;
+        fix_entry(sv, ii, jj, value);
+        fired++;
+      }
+      once &= (unsigned short)~value;
+    }
+  }
+
+  return (fired);
+}
+
+/*****************************************************************************/
+/* Rules: locked candidates.  Look at each place where two units cross in    */
+/* more than one entry, such as a row or column and a block.  If, within the */
+/* second unit, a value can only go in the crossing then it can't go         */
+/* anywhere else in the first ("pointing").  If within the first it can only */
+/* go in the crossing then it can't go anywhere else in the second           */
+/* ("claiming").  With the standard units, the first is always a row or      */
+/* column and the second a block.                                            */
+/*****************************************************************************/
+static int locked_candidates(sudoku_solver_t *sv, int claiming)
+{
+  const struct crossing *crossing;
+  int cc;
+  int kk;
+  int unit;
+  int before;
+  unsigned short inter;
+  unsigned short fixed;
+  unsigned short first_rest;
+  unsigned short second_rest;
+  unsigned short places;
+  unsigned short values;
+  int fired = 0;
+
+  for (cc=0; cc < sv->units.num_crossings; cc++)
+  {
+    crossing = &sv->units.crossings[cc];
+
+    /*************************************************************************/
+    /* Gather the candidates in the crossing, in the rest of the first unit  */
+    /* and in the rest of the second.  Values already fixed in the crossing  */
+    /* have long since been propagated, so leave them out.                   */
+    /*************************************************************************/
+    inter = 0;
+    fixed = 0;
+    first_rest = 0;
+    second_rest = 0;
+
+    for (kk=0; kk < SIZE; kk++)
+    {
+      if ((crossing->first_places & (1 << kk)) != 0)
+      {
+        inter |= UNIT_CANDS(crossing->first, kk);
+
+        if (POPCOUNT(UNIT_CANDS(crossing->first, kk)) == 1)
+        {
+          fixed |= UNIT_CANDS(crossing->first, kk);
+        }
+      }
+      else
+      {
+        first_rest |= UNIT_CANDS(crossing->first, kk);
+      }
+
+      if ((crossing->second_places & (1 << kk)) == 0)
+      {
+        second_rest |= UNIT_CANDS(crossing->second, kk);
+      }
+    }
+
+    values = (unsigned short)(inter & ~fixed &
+                              ~(claiming ? first_rest : second_rest));
+
+    if (values == 0)
+    {
+      continue;
+    }
+
+    /*************************************************************************/
+    /* Knock the locked values out of the rest of the other unit.            */
+    /*************************************************************************/
+    unit = claiming ? crossing->second : crossing->first;
+    places = claiming ? crossing->second_places : crossing->first_places;
+    before = sv->trail_top;
+
+    for (kk=0; kk < SIZE; kk++)
+    {
+      if (((places & (1 << kk)) == 0) &&
+          (eliminate(sv,
+                     sv->units.entries[unit][kk] / SIZE,
+                     sv->units.entries[unit][kk] % SIZE,
+                     values) == FALSE))
+      {
+        return (CONTRADICTION);
+      }
+    }
+
+    if (sv->trail_top != before)
+    {
+      fired++;
+    }
+  }
+
+  return (fired);
+}
+
+static int rule_pointing(sudoku_solver_t *sv)
+{
+  return (locked_candidates(sv, FALSE));
+}
+
+static int rule_claiming(sudoku_solver_t *sv)
+{
+  return (locked_candidates(sv, TRUE));
+}
+
+/*****************************************************************************/
+/* Rules: naked subsets.  If N ambiguous entries in a unit have only N       */
+/* candidates between them then those values must go in those entries, so    */
+/* they can't go anywhere else in the unit.  Fewer than N is a               */
+/* contradiction.                                                            */
+/*****************************************************************************/
+static int naked_subset(sudoku_solver_t *sv, int size)
+{
+  int uu;
+  int ss;
+  int kk;
+  int before;
+  unsigned short members;
+  unsigned short rest;
+  unsigned short values;
+  int fired = 0;
+
+  for (uu=0; uu < sv->units.count; uu++)
+  {
+    for (ss=0; ss < sv->num_subsets[size]; ss++)
+    {
+      /***********************************************************************/
+      /* Collect the candidates of the entries at these positions, giving up */
+      /* on this subset if any is fixed or has too many candidates.          */
+      /***********************************************************************/
+      members = sv->subsets[size][ss];
+      values = 0;
+
+      for (rest = members; rest != 0; rest &= (unsigned short)(rest - 1))
+      {
+        kk = CTZ(rest);
+
+        if ((POPCOUNT(UNIT_CANDS(uu,kk)) < 2) ||
+            (POPCOUNT(UNIT_CANDS(uu,kk)) > size))
+        {
+          break;
+        }
+        values |= UNIT_CANDS(uu,kk);
+      }
+
+      if ((rest != 0) ||
+          (POPCOUNT(values) > size))
+      {
+        continue;
+      }
+
+      if (POPCOUNT(values) < size)
+      {
+        return (CONTRADICTION);
+      }
+
+      /***********************************************************************/
+      /* Found one.  Knock its values out of the rest of the unit.           */
+      /***********************************************************************/
+      before = sv->trail_top;
+
+      for (kk=0; kk < SIZE; kk++)
+      {
+        if (((members & (1 << kk)) == 0) &&
+            (eliminate(sv, sv->units.entries[uu][kk] / SIZE,
+                       sv->units.entries[uu][kk] % SIZE,
+                       values) == FALSE))
+        {
+          return (CONTRADICTION);
+        }
+      }
+
+      if (sv->trail_top != before)
+      {
+        fired++;
+      }
+    }
+  }
+
+  return (fired);
+}
+
+/*****************************************************************************/
+/* Rules: hidden subsets.  If N values can only go in the same N entries of  */
+/* a unit then those entries can't hold anything else.  Fewer than N         */
+/* entries is a contradiction.                                               */
+/*****************************************************************************/
+static int hidden_subset(sudoku_solver_t *sv, int size)
+{
+  int uu;
+  int ss;
+  int kk;
+  int before;
+  unsigned short where[SIZE];
+  unsigned short fixed;
+  unsigned short positions;
+  unsigned short values;
+  unsigned short rest;
+  int fired = 0;
+
+  for (uu=0; uu < sv->units.count; uu++)
+  {
+    /*************************************************************************/
+    /* Note which ambiguous entries of the unit each value could go in, and  */
+    /* which values are already fixed.  A fixed value may not have been      */
+    /* propagated yet, so it can still be a candidate elsewhere in the unit. */
+    /*************************************************************************/
+    memset(where, 0, sizeof(where));
+    fixed = 0;
+
+    for (kk=0; kk < SIZE; kk++)
+    {
+      if (POPCOUNT(UNIT_CANDS(uu,kk)) == 1)
+      {
+        fixed |= UNIT_CANDS(uu,kk);
+      }
+      else
+      {
+        for (rest = UNIT_CANDS(uu,kk);
+             rest != 0;
+             rest &= (unsigned short)(rest - 1))
+        {
+          where[CTZ(rest)] |= (unsigned short)(1 << kk);
+        }
+      }
+    }
+
+    for (ss=0; ss < sv->num_subsets[size]; ss++)
+    {
+      values = sv->subsets[size][ss];
+      positions = 0;
+
+      if ((values & fixed) != 0)
+      {
+        continue;
+      }
+
+      for (rest = values; rest != 0; rest &= (unsigned short)(rest - 1))
+      {
+        if (where[CTZ(rest)] == 0)
+        {
+          break;
+        }
+        positions |= where[CTZ(rest)];
+      }
+
+      if ((rest != 0) ||
+          (POPCOUNT(positions) > size))
+      {
+        continue;
+      }
+
+      if (POPCOUNT(positions) < size)
+      {
+        return (CONTRADICTION);
+      }
+
+      /***********************************************************************/
+      /* Found one.  Strip every other value from those entries.             */
+      /***********************************************************************/
+      before = sv->trail_top;
+
+      for (rest = positions; rest != 0; rest &= (unsigned short)(rest - 1))
+      {
+        kk = CTZ(rest);
+
+        if (eliminate(sv, sv->units.entries[uu][kk] / SIZE,
+                      sv->units.entries[uu][kk] % SIZE,
+                      (unsigned short)(ALL_CANDIDATES & ~values)) == FALSE)
+        {
+          return (CONTRADICTION);
+        }
+      }
+
+      if (sv->trail_top != before)
+      {
+        fired++;
+      }
+    }
+  }
+
+  return (fired);
+}
+
+static int rule_naked_pair(sudoku_solver_t *sv)
+{
+  return (naked_subset(sv, 2));
+}
+
+static int rule_naked_triple(sudoku_solver_t *sv)
+{
+  return (naked_subset(sv, 3));
+}
+
+static int rule_hidden_pair(sudoku_solver_t *sv)
+{
+  return (hidden_subset(sv, 2));
+}
+
+static int rule_hidden_triple(sudoku_solver_t *sv)
+{
+  return (hidden_subset(sv, 3));
+}
+
+/*****************************************************************************/
+/* Branching heuristic: the first ambiguous entry in row-major order.  This  */
+/* is the original behavior and is kept for comparison.  It can be very slow */
+/* on some puzzles, depending on nothing more than their orientation.        */
+/*****************************************************************************/
+static void pick_first(sudoku_solver_t *sv, int *pii, int *pjj)
+{
+  int ii;
+  int jj;
+
+  for (ii=0;ii<SIZE;ii++)
+  {
+    for (jj=0;jj<SIZE;jj++)
+    {
+      if (!IS_FIXED(ii,jj))
+      {
+        goto EXIT;
+      }
+    }
+  }
+
+EXIT:
+
+  *pii = ii;
+  *pjj = jj;
+  return;
+}
+
+/*****************************************************************************/
+/* Branching heuristic: minimum remaining values.  Guess at the entry with   */
+/* the fewest candidates, so each guess is as likely as possible to be right */
+/* and a wrong one is found out quickly.  Ties go to the first in row-major  */
+/* order, or when guessing in random order to any of them.                   */
+/*****************************************************************************/
+static void pick_mrv(sudoku_solver_t *sv, int *pii, int *pjj)
+{
+  int ii;
+  int jj;
+  int count;
+  int best_count = SIZE + 1;
+  int ties = 0;
+  int randomize = sv->randomize;
+
+  for (ii=0;ii<SIZE;ii++)
+  {
+    for (jj=0;jj<SIZE;jj++)
+    {
+      count = CAND_COUNT(ii,jj);
+
+      if ((count > 1) &&
+          (count < best_count))
+      {
+        best_count = count;
+        ties = 1;
+        *pii = ii;
+        *pjj = jj;
+
+        if ((count == 2) &&
+            (randomize == FALSE))
+        {
+          /*******************************************************************/
+          /* Can't do any better than two candidates.                        */
+          /*******************************************************************/
+          goto EXIT;
+        }
+      }
+      else if ((randomize == TRUE) &&
+               (count == best_count) &&
+               (random_tie(sv, &ties) == TRUE))
+      {
+        *pii = ii;
+        *pjj = jj;
+      }
+    }
+  }
+
+EXIT:
+
+  return;
+}
+
+/*****************************************************************************/
+/* Branching heuristic: minimum remaining values, with ties broken in favor  */
+/* of the entry with the most still-ambiguous peers.  Fixing that entry      */
+/* constrains the most of the rest of the grid.  Any ties left go to the     */
+/* first, or when guessing in random order to any of them.                   */
+/*****************************************************************************/
+static void pick_mrv_degree(sudoku_solver_t *sv, int *pii, int *pjj)
+{
+  int ii;
+  int jj;
+  int count;
+  int degree;
+  int best_count = SIZE + 1;
+  int best_degree = -1;
+  int ties = 0;
+  int randomize = sv->randomize;
+
+  for (ii=0;ii<SIZE;ii++)
+  {
+    for (jj=0;jj<SIZE;jj++)
+    {
+      count = CAND_COUNT(ii,jj);
+
+      if ((count > 1) &&
+          (count <= best_count))
+      {
+        degree = unfixed_peers(sv, (ii * SIZE) + jj);
+
+        if ((count < best_count) ||
+            (degree > best_degree))
+        {
+          best_count = count;
+          best_degree = degree;
+          ties = 1;
+          *pii = ii;
+          *pjj = jj;
+        }
+        else if ((randomize == TRUE) &&
+                 (degree == best_degree) &&
+                 (random_tie(sv, &ties) == TRUE))
+        {
+          *pii = ii;
+          *pjj = jj;
+        }
+      }
+    }
+  }
+
+  return;
+}
+
+/*****************************************************************************/
+/* Counts the still-ambiguous entries sharing a unit with the given entry.   */
+/*****************************************************************************/
+static int unfixed_peers(sudoku_solver_t *sv, int nn)
+{
+  int kk;
+  int peer;
+  int count = 0;
+
+  for (kk=0; kk < sv->units.num_peers[nn]; kk++)
+  {
+    peer = sv->units.peers[nn][kk];
+
+    if (!IS_FIXED(peer / SIZE, peer % SIZE))
+    {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+/*****************************************************************************/
+/* Whether to take an entry that ties with the best so far, counting it in   */
+/* the ties: the Nth is taken with chance 1/N, so that in the end each is    */
+/* as likely as the others to be the one picked.                             */
+/*****************************************************************************/
+static int random_tie(sudoku_solver_t *sv, int *ties)
+{
+  (*ties)++;
+
+  return ((rng_next(&sv->rng) % (unsigned long)*ties) == 0);
+}
+
+#ifdef DEBUG
+/*****************************************************************************/
+/* Counts the fixed entries the slow way, to cross-check the running count.  */
+/*****************************************************************************/
+static int number_known(sudoku_solver_t *sv)
+{
+  int ii;
+  int jj;
+  int nn = 0;
+
+  for (ii=0;ii<SIZE;ii++)
+  {
+    for (jj=0;jj<SIZE;jj++)
+    {
+      if ((CANDS(ii,jj) != 0) && IS_FIXED(ii,jj))
+      {
+        /*********************************************************************/
+        /* This entry is fixed so increment our count.                       */
+        /*********************************************************************/
+        nn++;
+      }
+    }
+  }
+
+  return nn;
+}
+#endif
+
+#if defined(DEBUG) || !defined(NO_STATS)
+/*****************************************************************************/
+/* Checks the whole array for empty entries and duplicates the slow way, to  */
+/* cross-check that propagate(sv) really did catch every contradiction.      */
+/*****************************************************************************/
+static int do_check(sudoku_solver_t *sv)
+{
+  int uu;
+  int kk;
+  unsigned short seen;
+  int success = TRUE;
+
+  for (uu=0; uu < sv->units.count; uu++)
+  {
+    /*************************************************************************/
+    /* Collect the fixed values in the unit; seeing one twice means a        */
+    /* duplicate.  Every entry is in a row, so this checks them all for      */
+    /* having run out of candidates too.                                     */
+    /*************************************************************************/
+    seen = 0;
+
+    for (kk=0; kk < SIZE; kk++)
+    {
+      if (UNIT_CANDS(uu,kk) == 0)
+      {
+        success = FALSE;
+        goto EXIT;
+      }
+
+      if ((UNIT_CANDS(uu,kk) & (UNIT_CANDS(uu,kk) - 1)) == 0)
+      {
+        if ((seen & UNIT_CANDS(uu,kk)) != 0)
+        {
+          /*******************************************************************/
+          /* Two different entries have been uniquely identified but are the */
+          /* same.  This is a bogus unit.  Bail out.                         */
+          /*******************************************************************/
+          success = FALSE;
+          goto EXIT;
+        }
+        seen |= UNIT_CANDS(uu,kk);
+      }
+    }
+  }
+
+EXIT:
+
+  return success;
+}
+#endif
+
+/*****************************************************************************/
+/* Returns a wall-clock time in seconds for timing solves.  Standard C only  */
+/* offers processor time, so use a monotonic clock where POSIX provides one. */
+/*****************************************************************************/
+static double now_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec + (now.tv_nsec / 1e9));
+#else
+  return ((double)clock() / CLOCKS_PER_SEC);
+#endif
+}
+
+
+#if !defined(__GNUC__)
+/*****************************************************************************/
+/* Portable population count: the number of candidates left in a mask.       */
+/*****************************************************************************/
+static int popcount(unsigned int mask)
+{
+  int count = 0;
+
+  while (mask != 0)
+  {
+    mask &= (mask - 1);
+    count++;
+  }
+
+  return (count);
+}
+
+/*****************************************************************************/
+/* Portable count of trailing zeros: the lowest candidate left in a mask,    */
+/* less one.  Must not be called with an empty mask.                         */
+/*****************************************************************************/
+static int ctz(unsigned int mask)
+{
+  int count = 0;
+
+  ASSERT(mask != 0);
+
+  while ((mask & 1) == 0)
+  {
+    mask >>= 1;
+    count++;
+  }
+
+  return (count);
+}
+#endif
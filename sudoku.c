@@ -1,4 +1,6 @@
 /*****************************************************************************/
+/* Command-line front end to the solver library.                             */
+/*                                                                           */
 /* Add #define DEBUG for debug build.                                        */
 /*****************************************************************************/
 
@@ -7,93 +9,605 @@
 /*****************************************************************************/
 #include <string.h>
 #include <stdio.h>
-#include <assert.h>
+#include <time.h>
+#include <stdlib.h>
+#include "sudoku.h"
+#include "input.h"
+#include "output.h"
 
 /*****************************************************************************/
 /* Handy constants.                                                          */
 /*****************************************************************************/
-#define SIZE 9
-#define BLOCK_SIZE 3
 #define TRUE 1
 #define FALSE 0
 
-/*****************************************************************************/
-/* Assert macro.                                                             */
-/*****************************************************************************/
-#ifdef DEBUG
-#define ASSERT(X) assert(X)
-#else
-#define ASSERT(X)
-#endif
-
 /*****************************************************************************/
 /* Prototypes.                                                               */
 /*****************************************************************************/
-static int initialize(FILE *);
-static int attempt_to_solve(void);
-static int number_known(void);
-static int do_check(void);
-static void proc_block(int, int);
-static int unique_value(int, int);
-static void dump(void);
-static void proc_row(int, int);
-static void proc_col(int, int);
+static int initialize(sudoku_solver_t *, struct input *, const char *, int *);
+static int read_grid(struct input *, int *, int *);
+static int run_batch(sudoku_solver_t *,
+                     struct input *,
+                     struct output *,
+                     const char *,
+                     int,
+                     long,
+                     FILE *);
+static int run_generate(sudoku_solver_t *,
+                        struct output *,
+                        long,
+                        unsigned long,
+                        long,
+                        FILE *);
+static const char *uniqueness(long);
+static void write_stats(FILE *,
+                        long,
+                        int,
+                        long,
+                        const sudoku_stats_t *,
+                        sudoku_solver_t *);
+static int load_cache(sudoku_cache_t *, const char *);
+static int save_cache(sudoku_cache_t *, const char *);
+static double now_seconds(void);
+static void dump(struct output *, sudoku_solver_t *, int);
 
 /*****************************************************************************/
-/* Global variables for tracking recursion depth.                            */
+/* Batch mode.  Puzzles are read a block at a time, solved (on several       */
+/* threads if asked) and then written out in their original order.           */
 /*****************************************************************************/
-static int max_rec_depth = 0;
-static int cur_rec_depth = 0;
+#define BATCH_BLOCK 16384
 
 /*****************************************************************************/
-/* Global solution array.                                                    */
-/*                                                                           */
-/* The second-to-top entry is used to keep track of the number of            */
-/* candidates.  This is redundant information but is an optimization trading */
-/* off storage for speed.                                                    */
-/*                                                                           */
-/* We also trade off storage for speed by storing the unique candidate, once */
-/* it's found, in the top array entry.                                       */
+/* Most engines that can be compared.                                        */
 /*****************************************************************************/
-static int sudoku[SIZE][SIZE][SIZE + 2];
+#define MAX_ENGINES 8
 
 /*****************************************************************************/
-/* Handy macros.                                                             */
+/* Results the cache holds unless told otherwise.                            */
 /*****************************************************************************/
-#define FIXED_VAL(X,Y) sudoku[X][Y][SIZE+1]
-#define CAND_COUNT(X,Y) sudoku[X][Y][SIZE]
+#define CACHE_SIZE 100000
 
 int main (int argc, char *argv[])
 {
   int rc;
-  FILE *file;
+  int ii;
+  int batch = FALSE;
+  int compare = FALSE;
+  int lockstep = FALSE;
+  int echo = TRUE;
+  int format = -1;
+  long generate = 0;
+  unsigned long seed = (unsigned long)time(NULL);
+  long count = 0;
+  long max_nodes = 0;
+  double max_seconds = 0;
+  const char *restart = sudoku_restart_name(0);
+  long restart_nodes = SUDOKU_RESTART_NODES;
+  int status;
+  long hits;
+  long solutions;
+  const char *engine = sudoku_engine_name(0);
+  const char *variant = sudoku_variant_name(0);
+  const char *input = NULL;
+  const char *value;
+  const char *name;
+  struct input in;
+  int opened = FALSE;
+  struct output out;
+  int started = FALSE;
+  FILE *stats = NULL;
+  long cache_size = 0;
+  const char *cache_file = NULL;
+  sudoku_cache_t *cache = NULL;
+  int cached = FALSE;
+  long entries;
+  long misses;
+  sudoku_stats_t counters;
+  int size = SUDOKU_SIZE;
+  int values[SUDOKU_MAX_CELLS];
+  sudoku_solver_t *sv;
+
+  sv = sudoku_init();
+
+  if (sv == NULL)
+  {
+    printf("Out of memory\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  /***************************************************************************/
+  /* Pick out any options.  The one remaining argument is the input file.    */
+  /***************************************************************************/
+  for (ii=1; ii < argc; ii++)
+  {
+    if (strncmp(argv[ii], "--engine=", 9) == 0)
+    {
+      engine = argv[ii] + 9;
+
+      if (sudoku_set_engine(sv, engine) == FALSE)
+      {
+        printf("Unknown engine %s\n", engine);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "--kernel=", 9) == 0)
+    {
+      if (sudoku_set_kernel(sv, argv[ii] + 9) == FALSE)
+      {
+        printf("Unknown or unsupported propagation kernel %s\n",
+               argv[ii] + 9);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "--branch=", 9) == 0)
+    {
+      if (sudoku_set_branching(sv, argv[ii] + 9) == FALSE)
+      {
+        printf("Unknown branching heuristic %s\n", argv[ii] + 9);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "--rules=", 8) == 0)
+    {
+      if (sudoku_set_rules(sv, argv[ii] + 8) == FALSE)
+      {
+        printf("Unknown or repeated rule in %s\n", argv[ii] + 8);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "--variant=", 10) == 0)
+    {
+      variant = argv[ii] + 10;
+
+      if (sudoku_set_variant(sv, variant) == FALSE)
+      {
+        printf("Unknown puzzle variant %s\n", variant);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "--format=", 9) == 0)
+    {
+      format = output_format(argv[ii] + 9);
+
+      if (format < 0)
+      {
+        printf("Unknown output format %s\n", argv[ii] + 9);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strcmp(argv[ii], "--no-echo") == 0)
+    {
+      echo = FALSE;
+    }
+    else if ((strcmp(argv[ii], "--generate") == 0) ||
+             (strncmp(argv[ii], "--generate=", 11) == 0))
+    {
+      /***********************************************************************/
+      /* Generate puzzles, by default just one, instead of solving them.     */
+      /***********************************************************************/
+      generate = (argv[ii][10] == '=') ? atol(argv[ii] + 11) : 1;
+
+      if (generate < 1)
+      {
+        printf("Number of puzzles to generate must be at least 1\n");
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "--clues=", 8) == 0)
+    {
+      if (sudoku_set_clues(sv, atoi(argv[ii] + 8)) == FALSE)
+      {
+        printf("Number of clues must be 0 to %d\n", SUDOKU_CELLS);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "--symmetry=", 11) == 0)
+    {
+      if (sudoku_set_symmetry(sv, argv[ii] + 11) == FALSE)
+      {
+        printf("Unknown symmetry %s\n", argv[ii] + 11);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "--seed=", 7) == 0)
+    {
+      /***********************************************************************/
+      /* Seeds the generator, and the random order of restarting searches.   */
+      /***********************************************************************/
+      seed = strtoul(argv[ii] + 7, NULL, 10);
+      (void)sudoku_set_seed(sv, seed);
+    }
+    else if ((strncmp(argv[ii], "--restarts=", 11) == 0) ||
+             (strncmp(argv[ii], "--restart-nodes=", 16) == 0))
+    {
+      if (argv[ii][9] == 's')
+      {
+        restart = argv[ii] + 11;
+      }
+      else
+      {
+        restart_nodes = atol(argv[ii] + 16);
+      }
+
+      if (sudoku_set_restarts(sv, restart, restart_nodes) == FALSE)
+      {
+        printf("Unknown restart policy %s, or nodes not 1 or more\n",
+               restart);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strcmp(argv[ii], "--portfolio") == 0)
+    {
+      (void)sudoku_set_portfolio(sv, TRUE);
+    }
+    else if ((strcmp(argv[ii], "--cache") == 0) ||
+             (strncmp(argv[ii], "--cache=", 8) == 0))
+    {
+      /***********************************************************************/
+      /* Keep results to answer repeated puzzles from.                       */
+      /***********************************************************************/
+      cache_size = (argv[ii][7] == '=') ? atol(argv[ii] + 8) : CACHE_SIZE;
+
+      if (cache_size < 1)
+      {
+        printf("Cache size must be at least 1\n");
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "--cache-file=", 13) == 0)
+    {
+      cache_file = argv[ii] + 13;
+    }
+    else if (strcmp(argv[ii], "--batch") == 0)
+    {
+      batch = TRUE;
+    }
+    else if (strcmp(argv[ii], "--compare") == 0)
+    {
+      /***********************************************************************/
+      /* Comparing engines is done in batch mode.                            */
+      /***********************************************************************/
+      batch = TRUE;
+      compare = TRUE;
+    }
+    else if ((strcmp(argv[ii], "--count") == 0) ||
+             (strncmp(argv[ii], "--count=", 8) == 0))
+    {
+      /***********************************************************************/
+      /* Count solutions, by default just far enough to tell whether there's */
+      /* only one.                                                           */
+      /***********************************************************************/
+      count = (argv[ii][7] == '=') ? atol(argv[ii] + 8) : 2;
+
+      if ((count < 2) ||
+          (sudoku_set_count(sv, count) == FALSE))
+      {
+        printf("Number of solutions to count must be at least 2\n");
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strcmp(argv[ii], "--lockstep") == 0)
+    {
+      lockstep = TRUE;
+    }
+    else if ((strncmp(argv[ii], "--max-nodes=", 12) == 0) ||
+             (strncmp(argv[ii], "--max-time=", 11) == 0))
+    {
+      /***********************************************************************/
+      /* Give up on any puzzle that takes more guesses or seconds than this. */
+      /***********************************************************************/
+      if (argv[ii][6] == 'n')
+      {
+        max_nodes = atol(argv[ii] + 12);
+      }
+      else
+      {
+        max_seconds = atof(argv[ii] + 11);
+      }
 
-  if (argc != 2)
+      if (sudoku_set_budget(sv, max_nodes, max_seconds) == FALSE)
+      {
+        printf("Budget must not be negative\n");
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if ((strcmp(argv[ii], "--stats") == 0) ||
+             (strncmp(argv[ii], "--stats=", 8) == 0))
+    {
+      /***********************************************************************/
+      /* Write each puzzle's counters to a file, or by default to stderr.    */
+      /***********************************************************************/
+      if ((stats != NULL) &&
+          (stats != stderr))
+      {
+        (void)fclose(stats);
+      }
+      stats = (argv[ii][7] == '=') ? fopen(argv[ii] + 8, "w") : stderr;
+
+      if (stats == NULL)
+      {
+        printf("Failed to open stats file %s\n", argv[ii] + 8);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (strncmp(argv[ii], "-j", 2) == 0)
+    {
+      /***********************************************************************/
+      /* Number of threads, as "-j N" or "-jN".                              */
+      /***********************************************************************/
+      value = argv[ii] + 2;
+
+      if ((*value == '\0') &&
+          (ii + 1 < argc))
+      {
+        value = argv[++ii];
+      }
+
+      if (sudoku_set_threads(sv, atoi(value)) == FALSE)
+      {
+        printf("Number of threads must be 1 to %d\n", SUDOKU_MAX_THREADS);
+        rc = FALSE;
+        goto EXIT;
+      }
+    }
+    else if (input == NULL)
+    {
+      input = argv[ii];
+    }
+    else
+    {
+      input = NULL;
+      break;
+    }
+  }
+
+  /***************************************************************************/
+  /* Batch input comes from standard input unless a file is named.           */
+  /* Generating takes no input.                                              */
+  /***************************************************************************/
+  if ((batch == TRUE) &&
+      (ii == argc) &&
+      (input == NULL))
+  {
+    input = "-";
+  }
+
+  if (((generate == 0) &&
+       (input == NULL)) ||
+      ((generate > 0) &&
+       ((batch == TRUE) || (ii < argc) || (input != NULL))))
   {
     /*************************************************************************/
     /* Print usage information.                                              */
     /*************************************************************************/
-    printf("Use: sudoku input.txt (input.txt in same form as sample1.txt)\n");
+    printf("Use: sudoku [--engine=logic|dlx|cdcl|auto] "
+           "[--branch=mrv-degree|mrv|first]\n"
+           "            [--rules=LIST] input.txt\n");
+    printf("     (input.txt in same form as sample1.txt, or 4x4, 16x16 or "
+           "25x25\n");
+    printf("     with letters from A for values past 9)\n");
+    printf("  or sudoku -j N [options] input.txt\n");
+    printf("     (search for the solution using N threads)\n");
+    printf("  or sudoku --batch [-j N] [options] [puzzles.txt|-]\n");
+    printf("     (one puzzle per line, 81 characters, 0 or . for unknowns;\n");
+    printf("     one solution line is written per puzzle, in order, using N\n");
+    printf("     threads; the exit status is failure unless every puzzle is "
+           "solved)\n");
+    printf("  or sudoku --compare [-j N] [options] [puzzles.txt|-]\n");
+    printf("     (as --batch, but also solve with every other engine, and "
+           "report\n");
+    printf("     their speeds and any puzzles they solve differently, "
+           "failing if\n");
+    printf("     there are any, and with auto, how many it sent the slower "
+           "way)\n");
+    printf("  or sudoku --generate[=N] [-j N] [--clues=N] [--symmetry=NAME] "
+           "[--seed=N]\n");
+    printf("     (generate N puzzles, default 1, each with a unique "
+           "solution and\n");
+    printf("     at most the given number of clues, or as few as "
+           "possible; the\n");
+    printf("     symmetry is one of:");
+    for (ii=0; (name = sudoku_symmetry_name(ii)) != NULL; ii++)
+    {
+      printf(" %s", name);
+    }
+    printf(";\n     the exit status is failure if any missed the clue "
+           "target)\n");
+    printf("     LIST is a comma-separated list of deduction rules to use, in "
+           "order,\n");
+    printf("     from:");
+    for (ii=0; (name = sudoku_rule_name(ii)) != NULL; ii++)
+    {
+      printf(" %s", name);
+    }
+    printf("\n     or \"none\".  The default is hidden-single.\n");
+    printf("     --kernel=NAME sets how fixed values are propagated:");
+    for (ii=0; (name = sudoku_kernel_name(ii)) != NULL; ii++)
+    {
+      printf(" %s", name);
+    }
+    printf("\n     The default is the first the processor supports.\n");
+    printf("     --count[=N] counts solutions, up to N (default 2), and "
+           "reports\n");
+    printf("     whether each puzzle's is unique.\n");
+    printf("     --lockstep makes batches deduce on many puzzles at once, "
+           "guessing\n");
+    printf("     on each only where that isn't enough (logic and auto "
+           "engines only).\n");
+    printf("     --engine=auto sends each puzzle to deduction alone, the "
+           "logic engine's\n");
+    printf("     search or dlx, whichever it predicts is quickest, and "
+           "batches report\n");
+    printf("     how many went each way.\n");
+    printf("     --max-nodes=N and --max-time=SECONDS give up on a puzzle "
+           "after\n");
+    printf("     N guesses or that much time.\n");
+    printf("     --restarts=NAME starts the search again in a new random "
+           "order after\n");
+    printf("     runs of nodes set by the policy, one of:");
+    for (ii=0; (name = sudoku_restart_name(ii)) != NULL; ii++)
+    {
+      printf(" %s", name);
+    }
+    printf("\n     (default none), the first run taking --restart-nodes=N "
+           "(default %d).\n",
+           SUDOKU_RESTART_NODES);
+    printf("     --seed=N seeds the random order, so runs can be "
+           "repeated.\n");
+    printf("     --portfolio with -j N races a differently configured "
+           "search on each\n");
+    printf("     thread, taking the one that needs the fewest nodes "
+           "(logic engine only).\n");
+    printf("     --stats[=FILE] writes each puzzle's solve counters as a "
+           "line of\n");
+    printf("     JSON to FILE, or to stderr.\n");
+    printf("     --format=pretty|line|binary sets how results are written "
+           "(pretty\n");
+    printf("     by default for one puzzle, line for a batch), and "
+           "--no-echo stops\n");
+    printf("     the pretty format showing the puzzle before solving it.\n");
+    printf("     --cache[=N] answers puzzles seen before, or the same but for "
+           "relabelling,\n");
+    printf("     reordering rows and columns or transposing, from the last N "
+           "results\n");
+    printf("     (default %d).  --cache-file=FILE keeps them in FILE "
+           "between runs.\n",
+           CACHE_SIZE);
+    printf("     --variant=NAME solves another kind of puzzle, one of:");
+    for (ii=0; (name = sudoku_variant_name(ii)) != NULL; ii++)
+    {
+      printf(" %s", name);
+    }
+    printf("\n     (default standard).  A jigsaw puzzle is followed in "
+           "input.txt by its\n");
+    printf("     layout, a grid giving each entry's region from 1 to %d.\n",
+           SUDOKU_SIZE);
     rc = FALSE;
     goto EXIT;
   }
 
+  /***************************************************************************/
+  /* Whether lockstep can be used depends on the engine, so wait until that  */
+  /* is known.                                                               */
+  /***************************************************************************/
+  if ((lockstep == TRUE) &&
+      (sudoku_set_lockstep(sv, TRUE) == FALSE))
+  {
+    printf("The %s engine can't solve in lockstep in this build\n", engine);
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  if (((cache_size > 0) ||
+       (cache_file != NULL)) &&
+      (compare == TRUE))
+  {
+    printf("The cache can't be used when comparing engines\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  /***************************************************************************/
+  /* Each jigsaw puzzle comes with its own layout, which only the single     */
+  /* puzzle input has room for.                                              */
+  /***************************************************************************/
+  if ((strcmp(variant, "jigsaw") == 0) &&
+      ((batch == TRUE) || (generate > 0)))
+  {
+    printf("Jigsaw puzzles can only be solved one at a time\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  /***************************************************************************/
+  /* Set up the result cache, starting with whatever was kept last time.     */
+  /***************************************************************************/
+  if ((cache_size > 0) ||
+      (cache_file != NULL))
+  {
+    cache = sudoku_cache_init((cache_size > 0) ? cache_size : CACHE_SIZE);
+
+    if (cache == NULL)
+    {
+      printf("Out of memory\n");
+      rc = FALSE;
+      goto EXIT;
+    }
+
+    if ((cache_file != NULL) &&
+        (load_cache(cache, cache_file) == FALSE))
+    {
+      printf("Cache file %s is damaged or can't be read\n", cache_file);
+      rc = FALSE;
+      goto EXIT;
+    }
+    (void)sudoku_set_cache(sv, cache);
+    cached = TRUE;
+  }
+
+  /***************************************************************************/
+  /* Results go out through a buffer.  Batches and generated puzzles are     */
+  /* written a line per puzzle unless another format is asked for.           */
+  /***************************************************************************/
+  if (format < 0)
+  {
+    format = ((batch == TRUE) || (generate > 0)) ? OUTPUT_LINE : OUTPUT_PRETTY;
+  }
+  started = output_open(&out, stdout, format);
+
+  if (started == FALSE)
+  {
+    printf("Out of memory\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  if (generate > 0)
+  {
+    rc = run_generate(sv, &out, generate, seed, count, stats);
+    goto EXIT;
+  }
+
   /***************************************************************************/
   /* Attempt to open the input file.                                         */
   /***************************************************************************/
-  file = fopen(argv[1], "r");
+  opened = input_open(&in, input);
 
-  if (file == NULL)
+  if (opened == FALSE)
   {
-    printf("Failed to open input file %s\n", argv[1]);
+    printf("Failed to open input file %s\n", input);
     rc = FALSE;
     goto EXIT;
   }
 
+  if (batch == TRUE)
+  {
+    /*************************************************************************/
+    /* Solve a whole file of puzzles.                                        */
+    /*************************************************************************/
+    rc = run_batch(sv, &in, &out, engine, compare, count, stats);
+    goto EXIT;
+  }
+
   /***************************************************************************/
-  /* Initialize our data structures and read in input data.                  */
+  /* Read in input data.                                                     */
   /***************************************************************************/
-  rc = initialize(file);
+  rc = initialize(sv, &in, variant, &size);
 
   if (rc == FALSE)
   {
@@ -101,23 +615,45 @@ int main (int argc, char *argv[])
     goto EXIT;
   }
 
-  /***************************************************************************/
-  /* Close input file.                                                       */
-  /***************************************************************************/
-  (void)fclose(file);
+  if ((format == OUTPUT_BINARY) &&
+      (size != SUDOKU_SIZE))
+  {
+    printf("The binary format is only for %dx%d grids\n",
+           SUDOKU_SIZE,
+           SUDOKU_SIZE);
+    rc = FALSE;
+    goto EXIT;
+  }
 
   /***************************************************************************/
-  /* Show the user what went in.                                             */
+  /* Show the user what went in, unless asked not to.                        */
   /***************************************************************************/
-  printf("\nInput:\n");
-  dump();
+  if ((format == OUTPUT_PRETTY) &&
+      (echo == TRUE))
+  {
+    printf("\nInput:\n");
+    dump(&out, sv, size);
+  }
 
   /***************************************************************************/
-  /* Attempt to solve the puzzle.  This is a recursive routine.              */
+  /* Attempt to solve the puzzle.                                            */
   /***************************************************************************/
-  rc = attempt_to_solve();
+  status = sudoku_solve(sv);
+  rc = (status == SUDOKU_SOLVED);
 
-  if (rc == FALSE)
+  if (format != OUTPUT_PRETTY)
+  {
+    /*************************************************************************/
+    /* Just the result, as batch mode writes it.                             */
+    /*************************************************************************/
+    sudoku_result(sv, values);
+    output_result(&out, values, size, status, sudoku_solutions(sv), count);
+  }
+  else if (status == SUDOKU_BUDGET_EXCEEDED)
+  {
+    printf("Gave up: the search ran out of budget.\n");
+  }
+  else if (rc == FALSE)
   {
     printf("Couldn't solve it.\n");
   }
@@ -127,588 +663,932 @@ int main (int argc, char *argv[])
     /* Solved it.  Dump out the solution.                                    */
     /*************************************************************************/
     printf("Output:\n");
-    dump();
-    printf("Maximum recursion depth was %d\n", max_rec_depth);
+    dump(&out, sv, size);
+    printf("Maximum recursion depth was %d\n", sudoku_max_depth(sv));
+
+    /*************************************************************************/
+    /* Report how often each rule helped, to guide their ordering.           */
+    /*************************************************************************/
+    for (ii=0; (name = sudoku_rule_hits(sv, ii, &hits)) != NULL; ii++)
+    {
+      printf("%-14s rule made progress %ld times\n", name, hits);
+    }
+  }
+
+  if ((format == OUTPUT_PRETTY) &&
+      (count > 0) &&
+      (status == SUDOKU_BUDGET_EXCEEDED))
+  {
+    printf("Solutions: %ld or more (gave up counting)\n",
+           sudoku_solutions(sv));
+  }
+  else if ((format == OUTPUT_PRETTY) &&
+           (count > 0))
+  {
+    /*************************************************************************/
+    /* Say whether that was the only solution.                               */
+    /*************************************************************************/
+    solutions = sudoku_solutions(sv);
+    printf("Solutions: %ld%s (%s)\n",
+           solutions,
+           (solutions == count) ? " or more" : "",
+           uniqueness(solutions));
+  }
+
+  if (stats != NULL)
+  {
+    sudoku_get_stats(sv, &counters);
+    write_stats(stats,
+                1,
+                status,
+                sudoku_solutions(sv),
+                &counters,
+                sv);
   }
 
 EXIT:
 
-  return (rc);
+  /***************************************************************************/
+  /* Close input file.                                                       */
+  /***************************************************************************/
+  if (opened == TRUE)
+  {
+    input_close(&in);
+  }
+
+  /***************************************************************************/
+  /* Write out anything still buffered.                                      */
+  /***************************************************************************/
+  if (started == TRUE)
+  {
+    if (output_flush(&out) == FALSE)
+    {
+      fprintf(stderr, "Failed to write output\n");
+      rc = FALSE;
+    }
+    output_close(&out);
+  }
+
+  if ((stats != NULL) &&
+      (stats != stderr))
+  {
+    (void)fclose(stats);
+  }
+
+  /***************************************************************************/
+  /* Report on the cache after a batch, and keep it for next time.           */
+  /***************************************************************************/
+  if (cached == TRUE)
+  {
+    if (batch == TRUE)
+    {
+      sudoku_cache_stats(cache, &entries, &hits, &misses);
+      fprintf(stderr,
+              "Cache: %ld results, %ld hits, %ld misses\n",
+              entries,
+              hits,
+              misses);
+    }
+
+    if ((cache_file != NULL) &&
+        (save_cache(cache, cache_file) == FALSE))
+    {
+      fprintf(stderr, "Failed to write cache file %s\n", cache_file);
+      rc = FALSE;
+    }
+  }
+  sudoku_free(sv);
+  sudoku_cache_free(cache);
+
+  /***************************************************************************/
+  /* Report how it went the usual way, whatever the mode, so scripts can     */
+  /* check it.                                                               */
+  /***************************************************************************/
+  return ((rc == TRUE) ? EXIT_SUCCESS : EXIT_FAILURE);
 }
 
-static int initialize(FILE *file)
+/*****************************************************************************/
+/* Reads the puzzle, in the layout of the sample files or on one line, and   */
+/* sets the solver to its size.  A jigsaw puzzle's layout follows it, as a   */
+/* 9x9 grid of region numbers.                                               */
+/*****************************************************************************/
+static int initialize(sudoku_solver_t *sv,
+                      struct input *in,
+                      const char *variant,
+                      int *size)
 {
-  int ii;
-  int jj;
-  int kk;
-  int xx;
+  int values[SUDOKU_MAX_CELLS];
+  int regions[SUDOKU_MAX_CELLS];
+  int layout_size;
   int rc = TRUE;
 
+  if (read_grid(in, values, size) == FALSE)
+  {
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  if ((*size != SUDOKU_SIZE) &&
+      (strcmp(variant, sudoku_variant_name(0)) != 0))
+  {
+    printf("The %s variant is only for %dx%d grids\n",
+           variant,
+           SUDOKU_SIZE,
+           SUDOKU_SIZE);
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  if (sudoku_set_size(sv, *size) == FALSE)
+  {
+    printf("Out of memory\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  if (strcmp(variant, "jigsaw") == 0)
+  {
+    if (read_grid(in, regions, &layout_size) == FALSE)
+    {
+      rc = FALSE;
+      goto EXIT;
+    }
+
+    if ((layout_size != SUDOKU_SIZE) ||
+        (sudoku_set_regions(sv, regions) == FALSE))
+    {
+      printf("Jigsaw layout must be %dx%d, with %d entries in each region "
+             "from 1 to %d\n",
+             SUDOKU_SIZE,
+             SUDOKU_SIZE,
+             SUDOKU_SIZE,
+             SUDOKU_SIZE);
+      rc = FALSE;
+      goto EXIT;
+    }
+  }
+
   /***************************************************************************/
-  /* Clear out the working array.  Wind through all the entries.             */
+  /* Clashes between the known entries are found when solving.               */
   /***************************************************************************/
-  for (ii=0;ii<SIZE;ii++)
+  rc = sudoku_load(sv, values);
+
+EXIT:
+
+  return (rc);
+}
+
+/*****************************************************************************/
+/* Reads a grid, reporting where the input file went wrong if it did.        */
+/*****************************************************************************/
+static int read_grid(struct input *in, int *values, int *size)
+{
+  size_t offset;
+  int rc = TRUE;
+
+  switch (input_grid(in, values, size, &offset))
+  {
+    case INPUT_OK:
+      break;
+
+    case INPUT_BAD_CHAR:
+      printf("Bad character in input file at byte %lu\n",
+             (unsigned long)offset);
+      rc = FALSE;
+      goto EXIT;
+
+    case INPUT_LONG_ENTRY:
+      printf("Entry at byte %lu of input file is more than one digit\n",
+             (unsigned long)offset);
+      rc = FALSE;
+      goto EXIT;
+
+    case INPUT_BAD_SIZE:
+      printf("Entries on the line at byte %lu of input file make neither a "
+             "row nor a grid\n",
+             (unsigned long)offset);
+      rc = FALSE;
+      goto EXIT;
+
+    default:
+      printf("Input file has fewer than %d entries, ending at byte %lu\n",
+             (*size > 0) ? (*size * *size) : SUDOKU_CELLS,
+             (unsigned long)offset);
+      rc = FALSE;
+      goto EXIT;
+  }
+
+EXIT:
+
+  return (rc);
+}
+
+/*****************************************************************************/
+/* Batch mode.  Reads puzzles one per line and writes each one's result in   */
+/* the output's format (see output_job()), a block at a time.  Blank lines   */
+/* and lines starting with '#' are skipped.  Where each bad input line went  */
+/* wrong goes to stderr, and a summary at the end.  Returns FALSE if any     */
+/* puzzle failed.                                                            */
+/*                                                                           */
+/* When counting solutions (count is the limit, or 0 if not) any puzzle      */
+/* without a unique solution counts as failed.                               */
+/*                                                                           */
+/* When comparing, each block is solved by the selected engine, as usual,    */
+/* and then by each other engine in turn, from a copy of the puzzles.  The   */
+/* time each engine takes is reported, and any puzzle where an engine's      */
+/* result isn't the same as the selected engine's.  Puzzles with more than   */
+/* one solution may legitimately have different solutions, but not different */
+/* counts.  Returns FALSE if any did differ.  With the auto engine, it also  */
+/* counts the puzzles sent to the search that dlx was quicker on, and those  */
+/* sent to dlx that the logic engine was quicker on.                         */
+/*                                                                           */
+/* If stats isn't NULL, each puzzle's counters are written to it, for the    */
+/* selected engine only.                                                     */
+/*****************************************************************************/
+static int run_batch(sudoku_solver_t *sv,
+                     struct input *in,
+                     struct output *out,
+                     const char *engine,
+                     int compare,
+                     long count,
+                     FILE *stats)
+{
+  const char *text;
+  size_t *offsets = NULL;
+  sudoku_job_t *jobs = NULL;
+  sudoku_job_t *puzzles_copy = NULL;
+  sudoku_job_t *other = NULL;
+  double *route_time[SUDOKU_ROUTE_DLX + 1];
+  double *times;
+  double engine_time[MAX_ENGINES];
+  const char *name;
+  long differ = 0;
+  long kk;
+  int ee;
+  int selected = 0;
+  long num_jobs;
+  long puzzles = 0;
+  long failures = 0;
+  long unique = 0;
+  long routes[SUDOKU_ROUTE_DLX + 1];
+  long routed[SUDOKU_ROUTE_DLX + 1];
+  long misrouted[SUDOKU_ROUTE_DLX + 1];
+  long probes = 0;
+  long ran_out = 0;
+  int rr;
+  long jj;
+  double start;
+  double elapsed;
+  size_t len;
+  int eof = FALSE;
+  int rc = TRUE;
+
+  for (rr=0; rr <= SUDOKU_ROUTE_DLX; rr++)
+  {
+    route_time[rr] = NULL;
+    routes[rr] = 0;
+    routed[rr] = 0;
+    misrouted[rr] = 0;
+  }
+
+  jobs = malloc(sizeof(*jobs) * BATCH_BLOCK);
+  offsets = malloc(sizeof(*offsets) * BATCH_BLOCK);
+
+  if (compare == TRUE)
+  {
+    puzzles_copy = malloc(sizeof(*puzzles_copy) * BATCH_BLOCK);
+    other = malloc(sizeof(*other) * BATCH_BLOCK);
+    route_time[SUDOKU_ROUTE_SEARCH] = malloc(sizeof(double) * BATCH_BLOCK);
+    route_time[SUDOKU_ROUTE_DLX] = malloc(sizeof(double) * BATCH_BLOCK);
+  }
+
+  if ((jobs == NULL) ||
+      (offsets == NULL) ||
+      ((compare == TRUE) &&
+       ((puzzles_copy == NULL) ||
+        (other == NULL) ||
+        (route_time[SUDOKU_ROUTE_SEARCH] == NULL) ||
+        (route_time[SUDOKU_ROUTE_DLX] == NULL))))
+  {
+    fprintf(stderr, "Out of memory\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  for (ee=0; ee < MAX_ENGINES; ee++)
   {
-    for (jj=0;jj<SIZE;jj++)
+    engine_time[ee] = 0;
+
+    if (((name = sudoku_engine_name(ee)) != NULL) &&
+        (strcmp(name, engine) == 0))
+    {
+      selected = ee;
+    }
+  }
+
+  start = now_seconds();
+
+  while (eof == FALSE)
+  {
+    /*************************************************************************/
+    /* Read in the next block of puzzles.                                    */
+    /*************************************************************************/
+    num_jobs = 0;
+
+    while (num_jobs < BATCH_BLOCK)
     {
+      if (input_line(in, &text, &len, &offsets[num_jobs]) == FALSE)
+      {
+        eof = TRUE;
+        break;
+      }
+
+      if ((len == 0) ||
+          (text[0] == '#') ||
+          (input_blank(text, len) == TRUE))
+      {
+        continue;
+      }
+
       /***********************************************************************/
-      /* Initialize next entry.  First make every number a candidate.        */
+      /* Keep the puzzle and the character after it, which the library       */
+      /* checks.                                                             */
       /***********************************************************************/
-      for (kk=0;kk<SIZE;kk++)
+      if (len > (SUDOKU_CELLS+1))
+      {
+        len = SUDOKU_CELLS+1;
+      }
+      memcpy(jobs[num_jobs].line, text, len);
+      jobs[num_jobs].line[len] = '\0';
+      num_jobs++;
+    }
+
+    /*************************************************************************/
+    /* Solve the block.                                                      */
+    /*************************************************************************/
+    if (compare == TRUE)
+    {
+      memcpy(puzzles_copy, jobs, sizeof(*jobs) * num_jobs);
+    }
+
+    engine_time[selected] -= now_seconds();
+    sudoku_solve_jobs(sv, jobs, num_jobs);
+    engine_time[selected] += now_seconds();
+
+    for (ee=0;
+         (compare == TRUE) &&
+         (ee < MAX_ENGINES) &&
+         ((name = sudoku_engine_name(ee)) != NULL);
+         ee++)
+    {
+      if (ee == selected)
+      {
+        continue;
+      }
+
+      /***********************************************************************/
+      /* Solve the same puzzles with this engine and check that it agrees.   */
+      /***********************************************************************/
+      memcpy(other, puzzles_copy, sizeof(*other) * num_jobs);
+      (void)sudoku_set_engine(sv, name);
+
+      engine_time[ee] -= now_seconds();
+      sudoku_solve_jobs(sv, other, num_jobs);
+      engine_time[ee] += now_seconds();
+
+      /***********************************************************************/
+      /* Keep the time each puzzle took down the auto engine's other routes, */
+      /* to check the route it picked against.                               */
+      /***********************************************************************/
+      times = NULL;
+      if (strcmp(name, "logic") == 0)
+      {
+        times = route_time[SUDOKU_ROUTE_SEARCH];
+      }
+      else if (strcmp(name, "dlx") == 0)
+      {
+        times = route_time[SUDOKU_ROUTE_DLX];
+      }
+
+      for (kk=0; kk < num_jobs; kk++)
+      {
+        if (times != NULL)
+        {
+          times[kk] = other[kk].stats.seconds;
+        }
+
+        if ((other[kk].status != jobs[kk].status) ||
+            (other[kk].solutions != jobs[kk].solutions) ||
+            ((jobs[kk].status == SUDOKU_SOLVED) &&
+             (jobs[kk].solutions == 1) &&
+             (memcmp(other[kk].line, jobs[kk].line, SUDOKU_CELLS) != 0)))
+        {
+          differ++;
+          fprintf(stderr,
+                  "Engines %s and %s differ on puzzle %ld\n",
+                  engine,
+                  name,
+                  puzzles + kk + 1);
+        }
+      }
+    }
+    (void)sudoku_set_engine(sv, engine);
+
+    /*************************************************************************/
+    /* Write out the block's results in their original order.                */
+    /*************************************************************************/
+    for (jj=0; jj < num_jobs; jj++)
+    {
+      puzzles++;
+      output_job(out, &jobs[jj], count);
+
+      switch (jobs[jj].status)
       {
-        sudoku[ii][jj][kk] = TRUE;
+        case SUDOKU_SOLVED:
+          if ((count > 0) &&
+              (jobs[jj].solutions == 1))
+          {
+            unique++;
+          }
+          else if (count > 0)
+          {
+            failures++;
+          }
+          break;
+
+        case SUDOKU_NO_SOLUTION:
+        case SUDOKU_BUDGET_EXCEEDED:
+          failures++;
+          break;
+
+        default:
+          failures++;
+          fprintf(stderr,
+                  "Puzzle %ld: bad input at byte %lu\n",
+                  puzzles,
+                  (unsigned long)(offsets[jj] +
+                                  input_line_error(jobs[jj].line,
+                                                   strlen(jobs[jj].line))));
+          break;
       }
 
       /***********************************************************************/
-      /* Initialize the candidate count.                                     */
+      /* Count the auto engine's routes, and the probes of the search that   */
+      /* ran out, so the puzzle went to dlx after all.                       */
       /***********************************************************************/
-      CAND_COUNT(ii,jj) = SIZE;
+      if ((jobs[jj].status != SUDOKU_BAD_INPUT) &&
+          (jobs[jj].stats.route != SUDOKU_ROUTE_NONE))
+      {
+        routes[jobs[jj].stats.route]++;
+
+        if (jobs[jj].stats.predicted_route == SUDOKU_ROUTE_SEARCH)
+        {
+          probes++;
+          ran_out += (jobs[jj].stats.route == SUDOKU_ROUTE_DLX);
+        }
+      }
 
       /***********************************************************************/
-      /* Look at input file for specification of this entry.                 */
+      /* When comparing, count the puzzles the other route would have been   */
+      /* quicker for, if the library timed them (it doesn't if it was built  */
+      /* with NO_STATS).                                                     */
       /***********************************************************************/
-      (void)fscanf(file, "%d", &xx);
-
-      if ((xx < 0) ||
-          (xx > SIZE))
+      rr = jobs[jj].stats.predicted_route;
+      if ((compare == TRUE) &&
+          (jobs[jj].status != SUDOKU_BAD_INPUT) &&
+          ((rr == SUDOKU_ROUTE_SEARCH) || (rr == SUDOKU_ROUTE_DLX)) &&
+          (route_time[SUDOKU_ROUTE_SEARCH][jj] +
+           route_time[SUDOKU_ROUTE_DLX][jj] > 0))
       {
-        printf("Bad egg %d in input file at %d %d\n", xx, ii+1, jj+1);
-        rc = FALSE;
-        goto EXIT;
+        routed[rr]++;
+        misrouted[rr] +=
+          (route_time[(rr == SUDOKU_ROUTE_SEARCH) ? SUDOKU_ROUTE_DLX :
+                                                    SUDOKU_ROUTE_SEARCH][jj] <
+           route_time[rr][jj]);
       }
 
-      if (xx > 0)
+      if (stats != NULL)
       {
-        /*********************************************************************/
-        /* We have a known entry. Update our array thusly.                   */
-        /*********************************************************************/
-        for (kk=0;kk<SIZE;kk++)
-        {
-          sudoku[ii][jj][kk] = FALSE;
-        }
-        sudoku[ii][jj][xx-1] = TRUE;
-
-        /*********************************************************************/
-        /* Set up the candidate count.                                       */
-        /*********************************************************************/
-        CAND_COUNT(ii,jj) = 1;
-
-        /*********************************************************************/
-        /* Set up the unique entry value.                                    */
-        /*********************************************************************/
-        FIXED_VAL(ii,jj) = xx;
+        write_stats(stats,
+                    puzzles,
+                    jobs[jj].status,
+                    jobs[jj].solutions,
+                    &jobs[jj].stats,
+                    NULL);
       }
     }
-  }
-
-EXIT:
 
-  return (rc);
-}
+    /*************************************************************************/
+    /* The whole block goes out in one write.  If that fails, main() says    */
+    /* so.                                                                   */
+    /*************************************************************************/
+    if (output_flush(out) == FALSE)
+    {
+      rc = FALSE;
+      goto EXIT;
+    }
+  }
 
-static int attempt_to_solve(void)
-{
-  int num_known;
-  int last_num_known = 0;
-  int ii = 0;
-  int jj = 0;
-  int ll;
-  int mm;
-  int success = TRUE;
-  int saved_entry[SIZE+2];
-  int saved_sudoku[SIZE][SIZE][SIZE+2];
-  int done;
+  elapsed = now_seconds() - start;
 
-  /***************************************************************************/
-  /* Increment recursion depth count.  We dump this info on completion for   */
-  /* curiosity's sake.                                                       */
-  /***************************************************************************/
-  cur_rec_depth++;
+  fprintf(stderr,
+          "%ld puzzles, %ld failed, %.3f seconds, %.0f puzzles/second\n",
+          puzzles,
+          failures,
+          elapsed,
+          (elapsed > 0) ? (puzzles / elapsed) : 0.0);
 
-  if (max_rec_depth < cur_rec_depth)
+  if (count > 0)
   {
-    /*************************************************************************/
-    /* We need to update the deepest-ever recursion statistic.               */
-    /*************************************************************************/
-    max_rec_depth = cur_rec_depth;
+    fprintf(stderr, "%ld unique, %ld not\n", unique, puzzles - unique);
   }
 
-  while (((num_known = number_known()) > last_num_known) &&
-         (num_known < (SIZE*SIZE)))
+  if (routes[SUDOKU_ROUTE_DEDUCTION] +
+      routes[SUDOKU_ROUTE_SEARCH] +
+      routes[SUDOKU_ROUTE_DLX] > 0)
   {
-    /*************************************************************************/
-    /* Iterate applying the logical conditions of Sudoku until we have no    */
-    /* more effect on the number of known entries.                           */
-    /*************************************************************************/
-    last_num_known = num_known;
+    fprintf(stderr, "Routes:");
 
-    /*************************************************************************/
-    /* Wind through each entry looking for restrictions applied by each of   */
-    /* its row, column and block.                                            */
-    /*************************************************************************/
-    for (ii=0; ii < SIZE; ii++)
+    for (rr=SUDOKU_ROUTE_DEDUCTION; rr <= SUDOKU_ROUTE_DLX; rr++)
     {
-      for (jj=0; jj < SIZE; jj++)
-      {
-        if (CAND_COUNT(ii,jj) > 1)
-        {
-          /*******************************************************************/
-          /* Check for constrictions applied by the row, column and block.   */
-          /*******************************************************************/
-          proc_row(ii,jj);
-          proc_col(ii,jj);
-          proc_block(ii,jj);
-        }
-      }
+      fprintf(stderr,
+              "%s %ld %s",
+              (rr > SUDOKU_ROUTE_DEDUCTION) ? "," : "",
+              routes[rr],
+              sudoku_route_name(rr));
     }
+    fprintf(stderr, " (%ld of %ld probes ran out)\n", ran_out, probes);
   }
 
-  /*************************************************************************/
-  /* Check that we have a consistent array still.  If not, we have failed  */
-  /* and an outer recursion will backtrack and guess a different value for */
-  /* an entry.                                                             */
-  /*************************************************************************/
-  if (do_check() == FALSE)
+  if (routed[SUDOKU_ROUTE_SEARCH] + routed[SUDOKU_ROUTE_DLX] > 0)
   {
-    success = FALSE;
-    goto EXIT;
+    fprintf(stderr,
+            "Misrouted: %ld of %ld sent to the search were quicker with dlx, "
+            "%ld of %ld sent to dlx quicker with logic\n",
+            misrouted[SUDOKU_ROUTE_SEARCH],
+            routed[SUDOKU_ROUTE_SEARCH],
+            misrouted[SUDOKU_ROUTE_DLX],
+            routed[SUDOKU_ROUTE_DLX]);
   }
 
-  if (num_known == (SIZE * SIZE))
-  {
-    /*************************************************************************/
-    /* We've solved the puzzle so return with success.                       */
-    /*************************************************************************/
-    goto EXIT;
-  }
+  rc = (failures == 0);
 
-  /***************************************************************************/
-  /* Not got a complete solution yet so we have to start guessing.  Look for */
-  /* the first entry in the array that has more than one possible value.     */
-  /***************************************************************************/
-  done = FALSE;
-  for (ii=0;ii<SIZE;ii++)
+  if (compare == TRUE)
   {
-    for (jj=0;jj<SIZE;jj++)
+    for (ee=0;
+         (ee < MAX_ENGINES) && ((name = sudoku_engine_name(ee)) != NULL);
+         ee++)
     {
-      if (CAND_COUNT(ii,jj) > 1)
-      {
-        done = TRUE;
-        break;
-      }
+      fprintf(stderr,
+              "%-6s engine: %.3f seconds, %.0f puzzles/second\n",
+              name,
+              engine_time[ee],
+              (engine_time[ee] > 0) ? (puzzles / engine_time[ee]) : 0.0);
     }
+    fprintf(stderr, "%ld puzzles solved differently\n", differ);
 
-    if (done == TRUE)
-    {
-      break;
-    }
+    rc = rc && (differ == 0);
   }
 
-  /***************************************************************************/
-  /* Save off a copy the entry candidate list that we're going to use.       */
-  /* We're going to overwrite the data soon but we need to use it.           */
-  /***************************************************************************/
-  memcpy(saved_entry, sudoku[ii][jj], sizeof(sudoku[ii][jj]));
+EXIT:
 
-  /***************************************************************************/
-  /* Wind through each candidate attempting to solve the puzzle by trying to */
-  /* solve it using each of them in turn.                                    */
-  /***************************************************************************/
-  for (ll=0;ll<SIZE;ll++)
-  {
-    if (saved_entry[ll] == TRUE)
-    {
-      /***********************************************************************/
-      /* Save the current partially-completed sudoku.                        */
-      /***********************************************************************/
-      memcpy(saved_sudoku, sudoku, sizeof(sudoku));
+  free(jobs);
+  free(offsets);
+  free(puzzles_copy);
+  free(other);
+  free(route_time[SUDOKU_ROUTE_SEARCH]);
+  free(route_time[SUDOKU_ROUTE_DLX]);
 
-      /***********************************************************************/
-      /* Found a candidate.  Set up the entry to make it look as though      */
-      /* we've decided the value of this entry.                              */
-      /***********************************************************************/
-      for (mm=0;mm<SIZE;mm++)
-      {
-        sudoku[ii][jj][mm] = FALSE;
-      }
-      sudoku[ii][jj][ll] = TRUE;
+  return (rc);
+}
 
-      /***********************************************************************/
-      /* Set the candidate count to 1.                                       */
-      /***********************************************************************/
-      CAND_COUNT(ii,jj) = 1;
+/*****************************************************************************/
+/* Generate mode.  Generates the given number of puzzles a block at a time,  */
+/* from the seed, and writes each one in the output's format, or "Budget     */
+/* exceeded" if it couldn't be got down to the target number of clues.  The  */
+/* seed goes to stderr with a summary at the end, so the run can be          */
+/* repeated.  Returns FALSE if any puzzle missed the target.                 */
+/*****************************************************************************/
+static int run_generate(sudoku_solver_t *sv,
+                        struct output *out,
+                        long number,
+                        unsigned long seed,
+                        long count,
+                        FILE *stats)
+{
+  sudoku_job_t *jobs;
+  long done = 0;
+  long num_jobs;
+  long missed = 0;
+  long jj;
+  double start;
+  double elapsed;
+  int rc = TRUE;
 
-      /*********************************************************************/
-      /* Set up the unique entry value.                                    */
-      /*********************************************************************/
-      FIXED_VAL(ii,jj) = ll+1;
+  jobs = malloc(sizeof(*jobs) * BATCH_BLOCK);
 
-      /***********************************************************************/
-      /* Recursively attempt to solve the grid now we've fixed an extra      */
-      /* point as an educated guess.                                         */
-      /***********************************************************************/
-      success = attempt_to_solve();
+  if (jobs == NULL)
+  {
+    fprintf(stderr, "Out of memory\n");
+    rc = FALSE;
+    goto EXIT;
+  }
+
+  start = now_seconds();
+
+  while (done < number)
+  {
+    num_jobs = (number - done < BATCH_BLOCK) ? (number - done) : BATCH_BLOCK;
+    sudoku_generate_jobs(sv, jobs, num_jobs, seed + (unsigned long)done);
+
+    for (jj=0; jj < num_jobs; jj++)
+    {
+      output_job(out, &jobs[jj], count);
 
-      if (success == TRUE)
+      if (jobs[jj].status != SUDOKU_SOLVED)
       {
-        /*********************************************************************/
-        /* We have a solution so quit.                                       */
-        /*********************************************************************/
-        goto EXIT;
+        missed++;
       }
-      else
+
+      if (stats != NULL)
       {
-        /*********************************************************************/
-        /* Restore the old partially-completed sudoku from before we failed. */
-        /*********************************************************************/
-        memcpy(sudoku, saved_sudoku, sizeof(sudoku));
+        write_stats(stats,
+                    done + jj + 1,
+                    jobs[jj].status,
+                    jobs[jj].solutions,
+                    &jobs[jj].stats,
+                    NULL);
       }
     }
+    done += num_jobs;
+
+    if (output_flush(out) == FALSE)
+    {
+      rc = FALSE;
+      goto EXIT;
+    }
   }
 
-EXIT:
+  elapsed = now_seconds() - start;
 
-  /***************************************************************************/
-  /* Decrement the current number of recursions.                             */
-  /***************************************************************************/
-  cur_rec_depth--;
+  fprintf(stderr,
+          "%ld puzzles generated from seed %lu, %ld missed the clue target, "
+          "%.3f seconds, %.0f puzzles/second\n",
+          done,
+          seed,
+          missed,
+          elapsed,
+          (elapsed > 0) ? (done / elapsed) : 0.0);
 
-  return (success);
-}
+  rc = (missed == 0);
 
-static void proc_row(int ii, int jj)
-{
-  int kk;
+EXIT:
 
-  /*********************************************************************/
-  /* Check row containing this entry for restrictions we can apply to  */
-  /* the current entry.                                                */
-  /*********************************************************************/
-  for (kk=0; kk < SIZE; kk++)
-  {
-    if ((jj != kk) &&
-        (CAND_COUNT(ii,kk) == 1) &&
-        ((CAND_COUNT(ii,jj)) > 1))
-    {
-      if ((sudoku[ii][jj][FIXED_VAL(ii,kk) - 1]) == TRUE)
-      {
-        /*********************************************************************/
-        /* Eliminate this candidate.                                         */
-        /*********************************************************************/
-        sudoku[ii][jj][FIXED_VAL(ii,kk) - 1] = FALSE;
+  free(jobs);
 
-        /*********************************************************************/
-        /* Decrement the candidate count.                                    */
-        /*********************************************************************/
-        CAND_COUNT(ii,jj)--;
+  return (rc);
+}
 
-        if (CAND_COUNT(ii,jj) == 1)
-        {
-          /*******************************************************************/
-          /* We have uniqueness.  Update the unique value slot.              */
-          /*******************************************************************/
-          FIXED_VAL(ii,jj) = unique_value(ii,jj);
-        }
-      }
-    }
-  }
-  return;
+/*****************************************************************************/
+/* Describes a puzzle with the given number of solutions.                    */
+/*****************************************************************************/
+static const char *uniqueness(long solutions)
+{
+  return ((solutions == 0) ? "none" :
+          (solutions == 1) ? "unique" : "multiple");
 }
 
-static void proc_col(int ii, int jj)
+/*****************************************************************************/
+/* Writes the counters for solving a puzzle as one line of JSON.  Given the  */
+/* solver, the rule hits of its last solve are included too.                 */
+/*****************************************************************************/
+static void write_stats(FILE *out,
+                        long puzzle,
+                        int status,
+                        long solutions,
+                        const sudoku_stats_t *st,
+                        sudoku_solver_t *sv)
 {
-  int kk;
+  const char *name;
+  long hits;
+  int ii;
 
-  /*********************************************************************/
-  /* Check column containing this entry for restrictions we can apply  */
-  /* to the current entry.                                             */
-  /*********************************************************************/
-  for (kk=0; kk < SIZE; kk++)
+  fprintf(out,
+          "{\"puzzle\":%ld,\"status\":\"%s\",\"solutions\":%ld,"
+          "\"seconds\":%.9f,\"max_depth\":%d,\"guesses\":%ld,"
+          "\"backtracks\":%ld,\"propagations\":%ld,"
+          "\"row_eliminations\":%ld,\"col_eliminations\":%ld,"
+          "\"blk_eliminations\":%ld,\"check_failures\":%ld,"
+          "\"backjumps\":%ld,\"nogoods\":%ld,\"forgotten\":%ld,"
+          "\"restarts\":%ld,\"route\":\"%s\",\"predicted_route\":\"%s\"",
+          puzzle,
+          (status == SUDOKU_SOLVED) ? "solved" :
+          (status == SUDOKU_NO_SOLUTION) ? "no solution" :
+          (status == SUDOKU_BUDGET_EXCEEDED) ? "budget exceeded" : "bad input",
+          solutions,
+          st->seconds,
+          st->max_depth,
+          st->guesses,
+          st->backtracks,
+          st->propagations,
+          st->row_eliminations,
+          st->col_eliminations,
+          st->blk_eliminations,
+          st->check_failures,
+          st->backjumps,
+          st->nogoods,
+          st->forgotten,
+          st->restarts,
+          sudoku_route_name(st->route),
+          sudoku_route_name(st->predicted_route));
+
+  if ((sv != NULL) &&
+      (sudoku_rule_hits(sv, 0, &hits) != NULL))
   {
-    if ((ii != kk) &&
-        (CAND_COUNT(kk,jj) == 1) &&
-        (CAND_COUNT(ii,jj) > 1))
-    {
-      if (sudoku[ii][jj][FIXED_VAL(kk,jj) - 1] == TRUE)
-      {
-        /*********************************************************************/
-        /* Eliminate this value.                                             */
-        /*********************************************************************/
-        sudoku[ii][jj][FIXED_VAL(kk,jj) - 1] = FALSE;
+    fprintf(out, ",\"rules\":{");
 
-        /*********************************************************************/
-        /* Decrement the candidate count.                                    */
-        /*********************************************************************/
-        CAND_COUNT(ii,jj)--;
-
-        if (CAND_COUNT(ii,jj) == 1)
-        {
-          /*******************************************************************/
-          /* We have uniqueness.  Update the unique value slot.              */
-          /*******************************************************************/
-          FIXED_VAL(ii,jj) = unique_value(ii,jj);
-        }
-      }
+    for (ii=0; (name = sudoku_rule_hits(sv, ii, &hits)) != NULL; ii++)
+    {
+      fprintf(out, "%s\"%s\":%ld", (ii > 0) ? "," : "", name, hits);
     }
+    fprintf(out, "}");
   }
+  fprintf(out, "}\n");
   return;
 }
 
-static void proc_block(int ii, int jj)
+/*****************************************************************************/
+/* Reads the results kept in a cache file into the cache.  A file that isn't */
+/* there yet is fine: it's created when the cache is saved.                  */
+/*****************************************************************************/
+static int load_cache(sudoku_cache_t *cache, const char *name)
 {
-  int xx;
-  int yy;
-  int kk;
-  int ll;
+  FILE *file;
+  unsigned char *data = NULL;
+  unsigned char *bigger;
+  size_t size = 0;
+  size_t capacity = 0;
+  size_t got;
+  int rc = TRUE;
 
-  /***************************************************************************/
-  /* Find the top left-hand corner of the block.                             */
-  /***************************************************************************/
-  xx = (ii/3)*3;
-  yy = (jj/3)*3;
+  file = fopen(name, "rb");
 
-  /***************************************************************************/
-  /* Wind through each block entry.  If it is fixed then we know that the    */
-  /* target entry can't be that value.                                       */
-  /***************************************************************************/
-  for (kk=xx; kk<(xx+BLOCK_SIZE); kk++)
+  if (file == NULL)
   {
-    for (ll=yy; ll<(yy+BLOCK_SIZE); ll++)
-    {
-      /***********************************************************************/
-      /* We're on the next value in the block.                               */
-      /***********************************************************************/
-      if (((kk != ii) ||
-           (ll != jj)) &&
-           (CAND_COUNT(kk,ll) == 1))
-      {
-        if (sudoku[ii][jj][FIXED_VAL(kk,ll) - 1] == TRUE)
-        {
-          /*******************************************************************/
-          /* It's a fixed value.  Update the sudoku array thusly.            */
-          /*******************************************************************/
-          sudoku[ii][jj][FIXED_VAL(kk,ll) - 1] = FALSE;
-
-          /*******************************************************************/
-          /* Decrement the candidate count.                                  */
-          /*******************************************************************/
-          CAND_COUNT(ii,jj)--;
-
-          if (CAND_COUNT(ii,jj) == 1)
-          {
-            /*****************************************************************/
-            /* We have uniqueness.  Update the unique value slot.            */
-            /*****************************************************************/
-            FIXED_VAL(ii,jj) = unique_value(ii,jj);
-          }
-        }
-      }
-    }
+    goto EXIT;
   }
-  return;
-}
-
-static int number_known(void)
-{
-  int ii;
-  int jj;
-  int nn = 0;
 
-  for (ii=0;ii<SIZE;ii++)
+  do
   {
-    for (jj=0;jj<SIZE;jj++)
+    if (size == capacity)
     {
-      if (CAND_COUNT(ii,jj) == 1)
+      capacity = (capacity > 0) ? (capacity * 2) : (1 << 20);
+      bigger = realloc(data, capacity);
+
+      if (bigger == NULL)
       {
-        /*********************************************************************/
-        /* This entry is fixed so increment our count.                       */
-        /*********************************************************************/
-        nn++;
+        rc = FALSE;
+        goto EXIT;
       }
+      data = bigger;
     }
+
+    got = fread(data + size, 1, capacity - size, file);
+    size += got;
+  } while (got > 0);
+
+  rc = ((ferror(file) == 0) &&
+        (sudoku_cache_import(cache, data, size) >= 0));
+
+EXIT:
+
+  if (file != NULL)
+  {
+    (void)fclose(file);
   }
+  free(data);
 
-  return nn;
+  return (rc);
 }
 
-static int do_check(void)
+/*****************************************************************************/
+/* Writes the cache's results to a cache file.  They go to a new file first, */
+/* which then takes the old one's place, so a failed write leaves the old    */
+/* one as it was.                                                            */
+/*****************************************************************************/
+static int save_cache(sudoku_cache_t *cache, const char *name)
 {
-  int ii;
-  int jj;
-  int kk;
-  int xx;
-  int yy;
-  int ll;
-  int success = TRUE;
-
-  for (ii=0; ii < SIZE; ii++)
+  FILE *file = NULL;
+  unsigned char *data = NULL;
+  char *temp;
+  size_t size;
+  int rc = FALSE;
+
+  temp = malloc(strlen(name) + 5);
+  size = sudoku_cache_export(cache, NULL, 0);
+  data = malloc(size);
+
+  if ((temp == NULL) ||
+      (data == NULL))
   {
-    for (jj=0; jj < SIZE; jj++)
-    {
-      /***********************************************************************/
-      /* Check whether the entry has run out of candidates.                  */
-      /***********************************************************************/
-      if (CAND_COUNT(ii,jj) == 0)
-      {
-        success = FALSE;
-        goto EXIT;
-      }
+    goto EXIT;
+  }
 
-      /***********************************************************************/
-      /* Check horizontals for duplicates.  The ordering of the tests is     */
-      /* optimized to do the most unlikely ones first.                       */
-      /***********************************************************************/
-      for (kk=0; kk < SIZE; kk++)
-      {
-        if ((CAND_COUNT(ii,kk) == 1) &&
-            (CAND_COUNT(ii,jj) == 1) &&
-            (jj != kk) &&
-            (FIXED_VAL(ii,kk) == FIXED_VAL(ii,jj)))
-        {
-          success = FALSE;
-          goto EXIT;
-        }
-      }
+  strcpy(temp, name);
+  strcat(temp, ".tmp");
+  size = sudoku_cache_export(cache, data, size);
+  file = fopen(temp, "wb");
 
-      /***********************************************************************/
-      /* Check verticals for duplicates.  The ordering of the tests is       */
-      /* optimized to do the most unlikely ones first.                       */
-      /***********************************************************************/
-      for (kk=0; kk < SIZE; kk++)
-      {
-        if ((CAND_COUNT(kk,jj) == 1) &&
-            (CAND_COUNT(ii,jj) == 1) &&
-            (ii != kk) &&
-            (FIXED_VAL(kk,jj) == FIXED_VAL(ii,jj)))
-        {
-          success = FALSE;
-          goto EXIT;
-        }
-      }
+  if (file == NULL)
+  {
+    goto EXIT;
+  }
 
-      /***********************************************************************/
-      /* Check block containing this entry.  Find the top left-hand corner   */
-      /* of the block.                                                       */
-      /***********************************************************************/
-      xx = (ii/3)*3;
-      yy = (jj/3)*3;
+  rc = (fwrite(data, 1, size, file) == size);
+  rc = (fclose(file) == 0) && rc;
+  rc = rc && (rename(temp, name) == 0);
 
-      /***********************************************************************/
-      /* Wind through all entries in the block.                              */
-      /***********************************************************************/
-      for (kk=xx; kk<(xx+BLOCK_SIZE); kk++)
-      {
-        for (ll=yy; ll<(yy+BLOCK_SIZE); ll++)
-        {
-          /*******************************************************************/
-          /* We're on the next value in the block.  The order of the tests   */
-          /* here is optimized to check the most unlikely conditions first.  */
-          /*******************************************************************/
-          if ((CAND_COUNT(kk,ll) == 1) &&
-              (CAND_COUNT(ii,jj) == 1) &&
-              ((kk != ii) || (ll != jj)) &&
-              (FIXED_VAL(kk,ll) == FIXED_VAL(ii,jj)))
-          {
-            /*****************************************************************/
-            /* Two different entries have been uniquely identified but are   */
-            /* the same.  This is a bogus block.  Bail out.                  */
-            /*****************************************************************/
-            success = FALSE;
-            goto EXIT;
-          }
-        }
-      }
-    }
+  if (rc == FALSE)
+  {
+    (void)remove(temp);
   }
 
 EXIT:
 
-  return success;
+  free(temp);
+  free(data);
+
+  return (rc);
+}
+
+/*****************************************************************************/
+/* Returns a wall-clock time in seconds for timing runs.  Standard C only    */
+/* offers processor time, so use a monotonic clock where POSIX provides one. */
+/*****************************************************************************/
+static double now_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec + (now.tv_nsec / 1e9));
+#else
+  return ((double)clock() / CLOCKS_PER_SEC);
+#endif
 }
 
 /*****************************************************************************/
-/* Prints out the sudoku solution array.                                     */
+/* Prints out the sudoku solution array, for a grid of the given size.       */
 /*****************************************************************************/
-static void dump(void)
+static void dump(struct output *out, sudoku_solver_t *sv, int size)
 {
+  int values[SUDOKU_MAX_CELLS];
+ #ifdef DEBUG
   int ii;
   int jj;
+  int block = 2;
+  unsigned int masks[SUDOKU_MAX_CELLS];
+  unsigned int mask;
+  int count;
+ #endif
 
-  printf("\n");
+  sudoku_result(sv, values);
+  output_grid(out, values, size);
+  (void)output_flush(out);
 
-  printf("   1 2 3  4 5 6  7 8 9\n");
-  printf("   -----  -----  -----\n");
+ #ifdef DEBUG
+  /***************************************************************************/
+  /* And the number of candidates each entry has left.                       */
+  /***************************************************************************/
+  sudoku_candidates(sv, masks);
 
-  for (ii=0;ii<SIZE;ii++)
+  while ((block * block) < size)
   {
-    printf("%d| ", ii+1);
-    for (jj=0;jj<SIZE;jj++)
-    {
-      if (CAND_COUNT(ii,jj) > 1)
-      {
-        printf("0 ");
-      }
-      else
-      {
-        printf("%d ", FIXED_VAL(ii,jj));
-      }
-
-      if ((jj % BLOCK_SIZE) == (BLOCK_SIZE - 1))
-      {
-        printf(" ");
-      }
-    }
-    printf("\n");
-    if ((ii % BLOCK_SIZE) == (BLOCK_SIZE - 1))
-    {
-      printf("\n");
-    }
+    block++;
   }
 
- #ifdef DEBUG
-  for (ii=0;ii<SIZE;ii++)
+  for (ii=0;ii<size;ii++)
   {
-    for (jj=0;jj<SIZE;jj++)
+    for (jj=0;jj<size;jj++)
     {
-      printf("%d ", CAND_COUNT(ii,jj));
+      mask = masks[(ii * size) + jj];
 
-      if ((jj % BLOCK_SIZE) == (BLOCK_SIZE - 1))
+      for (count=0; mask != 0; count++)
+      {
+        mask &= (mask - 1);
+      }
+      printf("%d ", count);
+
+      if ((jj % block) == (block - 1))
       {
         printf(" ");
       }
     }
     printf("\n");
-    if ((ii % BLOCK_SIZE) == (BLOCK_SIZE - 1))
+    if ((ii % block) == (block - 1))
     {
       printf("\n");
     }
   }
  #endif
 }
-
-/*****************************************************************************/
-/* This function returns the unique value that an entry with only one        */
-/* candidate has.                                                            */
-/*****************************************************************************/
-static int unique_value(int xx, int yy)
-{
-  int ii;
-  int output = SIZE+1;
-
-  ASSERT(CAND_COUNT(xx,yy) == 1);
-
-  for (ii=0; ii<SIZE; ii++)
-  {
-    if (sudoku[xx][yy][ii] == TRUE)
-    {
-      output = ii+1;
-      goto EXIT;
-    }
-  }
-
-EXIT:
-
-  ASSERT(output < (SIZE+1));
-
-  return (output);
-}
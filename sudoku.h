@@ -0,0 +1,410 @@
+/*****************************************************************************/
+/* Sudoku solver library.                                                    */
+/*                                                                           */
+/* All the state for solving a puzzle lives in a solver context, so any      */
+/* number of contexts can be used at once, one per thread.  Nothing here     */
+/* reads or writes files or the terminal.                                    */
+/*                                                                           */
+/* Typical use:                                                              */
+/*                                                                           */
+/*   sudoku_solver_t *solver = sudoku_init();                                */
+/*   if (sudoku_load_line(solver, line) &&                                   */
+/*       (sudoku_solve(solver) == SUDOKU_SOLVED))                            */
+/*   {                                                                       */
+/*     sudoku_result(solver, grid);                                          */
+/*   }                                                                       */
+/*   sudoku_free(solver);                                                    */
+/*****************************************************************************/
+#ifndef SUDOKU_H
+#define SUDOKU_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************/
+/* Grid dimensions.  Entries are numbered row by row from zero.  Grids are   */
+/* 9x9 unless set to another size with sudoku_set_size(), up to the most     */
+/* here.                                                                     */
+/*****************************************************************************/
+#define SUDOKU_SIZE 9
+#define SUDOKU_CELLS (SUDOKU_SIZE * SUDOKU_SIZE)
+#define SUDOKU_MAX_SIZE 25
+#define SUDOKU_MAX_CELLS (SUDOKU_MAX_SIZE * SUDOKU_MAX_SIZE)
+
+/*****************************************************************************/
+/* Most threads a single context will use.                                   */
+/*****************************************************************************/
+#define SUDOKU_MAX_THREADS 256
+
+/*****************************************************************************/
+/* Nodes a new context lets the first run of a restart policy take.          */
+/*****************************************************************************/
+#define SUDOKU_RESTART_NODES 128
+
+/*****************************************************************************/
+/* Outcomes of solving a puzzle.                                             */
+/*****************************************************************************/
+#define SUDOKU_NO_SOLUTION 0
+#define SUDOKU_SOLVED 1
+#define SUDOKU_BAD_INPUT 2
+#define SUDOKU_BUDGET_EXCEEDED 3
+
+/*****************************************************************************/
+/* Routes the "auto" engine can send a puzzle down (see sudoku_set_engine()) */
+/* and sudoku_route_name() names, 0 for a puzzle no engine routed.           */
+/*****************************************************************************/
+#define SUDOKU_ROUTE_NONE 0
+#define SUDOKU_ROUTE_DEDUCTION 1
+#define SUDOKU_ROUTE_SEARCH 2
+#define SUDOKU_ROUTE_DLX 3
+
+/*****************************************************************************/
+/* Solver context.  Its contents are private.                                */
+/*****************************************************************************/
+typedef struct sudoku_solver sudoku_solver_t;
+
+/*****************************************************************************/
+/* Counters for one solve, for tuning.  Each counts from the start of the    */
+/* solve:                                                                    */
+/*                                                                           */
+/*   guesses           values tried for an entry when deduction ran out      */
+/*   backtracks        guesses undone again, after a contradiction or, when  */
+/*                     counting solutions, after finding those they led to   */
+/*   propagations      times the logic engine pushed fixed values out to     */
+/*                     their peers                                           */
+/*   row_eliminations  candidates removed because the value was fixed        */
+/*   col_eliminations  elsewhere in the entry's row, column or other units   */
+/*   blk_eliminations  (its block or region, and any diagonal or window).    */
+/*                     Which unit gets the credit when it's more than one    */
+/*                     depends on the propagation kernel.                    */
+/*   check_failures    solutions that failed the final check that no unit    */
+/*                     holds a value twice (which should never happen)       */
+/*   backjumps         levels of guessing the cdcl engine skipped when it    */
+/*                     jumped back past them from a contradiction            */
+/*   nogoods           nogoods the cdcl engine learned from contradictions   */
+/*   forgotten         nogoods it then forgot to make room for more          */
+/*   restarts          times the logic engine started its search again from  */
+/*                     the top under a restart policy                        */
+/*   route             the route the auto engine sent the puzzle down, and   */
+/*   predicted_route   the one it predicted before probing (both             */
+/*                     SUDOKU_ROUTE_NONE with any other engine)              */
+/*   max_depth         deepest level of guessing reached                     */
+/*   seconds           wall-clock time taken                                 */
+/*                                                                           */
+/* The dlx engine only counts guesses (rows tried) and backtracks, and the  */
+/* cdcl engine those (one backtrack for each contradiction) and its own.  In */
+/* lockstep, the deduction done for the whole pack isn't counted, and each   */
+/* puzzle's time includes an equal share of the time it took.  The library   */
+/* leaves the counters at zero if it's built with NO_STATS defined, though   */
+/* it still reports the routes.                                              */
+/*****************************************************************************/
+typedef struct sudoku_stats
+{
+  long guesses;
+  long backtracks;
+  long propagations;
+  long row_eliminations;
+  long col_eliminations;
+  long blk_eliminations;
+  long check_failures;
+  long backjumps;
+  long nogoods;
+  long forgotten;
+  long restarts;
+  int route;
+  int predicted_route;
+  int max_depth;
+  double seconds;
+} sudoku_stats_t;
+
+/*****************************************************************************/
+/* One puzzle of a batch, in the single-line format (see sudoku_load_line()) */
+/* with room for the character after it.  Solving replaces the puzzle with   */
+/* its solution, sets the status to one of the outcomes above, and sets the  */
+/* number of solutions found (see sudoku_set_count()) and the counters for   */
+/* solving it.                                                               */
+/*****************************************************************************/
+typedef struct sudoku_job
+{
+  char line[SUDOKU_CELLS + 2];
+  int status;
+  long solutions;
+  sudoku_stats_t stats;
+} sudoku_job_t;
+
+/*****************************************************************************/
+/* Creating and destroying contexts.  sudoku_init() returns NULL if it is    */
+/* out of memory.  A new context uses the default engine, branching          */
+/* heuristic and deduction rules, and one thread.                            */
+/*****************************************************************************/
+sudoku_solver_t *sudoku_init(void);
+void sudoku_free(sudoku_solver_t *solver);
+
+/*****************************************************************************/
+/* Configuration.  Each returns 0, leaving the context as it was, if the     */
+/* setting isn't valid.                                                      */
+/*                                                                           */
+/* sudoku_set_engine() picks the solving engine by name: "logic" (candidate  */
+/* elimination, deduction rules and guessing), "dlx" (Dancing Links) or      */
+/* "cdcl" (guessing that learns from each contradiction, so as not to run    */
+/* into it again, and jumps straight back to the guess behind it: slower     */
+/* per guess, but it can take far fewer on the hardest puzzles) or "auto",   */
+/* which runs the logic engine's deduction and then, from what is left,      */
+/* gives the search to the logic engine if it looks to need only a few       */
+/* guesses, or to dlx, and to dlx anyway if those few guesses don't do it.   */
+/* sudoku_set_branching() picks the heuristic the logic engine uses to       */
+/* choose where to guess, by name.  sudoku_set_rules() takes a               */
+/* comma-separated list of the logic engine's deduction rule names, in the   */
+/* order to try them, or "none".  The names known are listed by              */
+/* sudoku_engine_name(), sudoku_branching_name() and sudoku_rule_name(),     */
+/* which return NULL past the end; the first engine and heuristic listed are */
+/* the defaults.                                                             */
+/*                                                                           */
+/* sudoku_set_kernel() picks how the logic engine propagates fixed values:   */
+/* "avx2" or "sse2" (vector code, x86 only) or "scalar".  All give the same  */
+/* results.  A new context uses the fastest the processor supports, and a    */
+/* kernel it doesn't support can't be picked.  sudoku_kernel_name() lists    */
+/* those built in.                                                           */
+/*                                                                           */
+/* sudoku_set_threads() sets how many threads sudoku_solve() and             */
+/* sudoku_solve_jobs() may use, 1 to SUDOKU_MAX_THREADS.  Only the logic     */
+/* engine can split a single puzzle between threads.  The library is built   */
+/* without threads if NO_THREADS is defined, and then only ever uses one.    */
+/*                                                                           */
+/* sudoku_set_lockstep() turns lockstep solving of batches on or off (it is  */
+/* off in a new context).  With the logic or auto engine,                    */
+/* sudoku_solve_jobs() then packs puzzles together and runs the deduction on */
+/* the whole pack at once with vector instructions, and only guesses, one    */
+/* puzzle at a time, on those the deduction doesn't finish.  The results are */
+/* the same either way; it is much faster on batches of easy puzzles.  It    */
+/* needs a compiler with GCC-style vector extensions, and can't be turned on */
+/* without one, or with another engine selected.  Changing the engine        */
+/* afterwards to one without it leaves it on but unused.                     */
+/*                                                                           */
+/* sudoku_set_count() sets how many solutions solving looks for, 1 or more.  */
+/* A new context looks for 1, stopping at the first solution.  Given a       */
+/* larger limit, the search carries on until it has found that many or       */
+/* there are no more, so a limit of 2 is enough to tell whether a puzzle's   */
+/* solution is unique.  See sudoku_solutions().                              */
+/*                                                                           */
+/* sudoku_set_budget() limits each solve to a number of search nodes (one    */
+/* for each guess, plus one to start) and a number of seconds of wall-clock  */
+/* time, 0 meaning no limit, which a new context has for both.  A solve that */
+/* runs out gives up and reports SUDOKU_BUDGET_EXCEEDED, with the            */
+/* statistics as far as it got.  The time is only checked every few dozen    */
+/* nodes, so may run over slightly.  With threads, each gets an equal share  */
+/* of the nodes.                                                             */
+/*                                                                           */
+/* sudoku_set_restarts() picks how the logic engine restarts its search, by  */
+/* name: "none" (the default), "luby" or "geometric", with the nodes its     */
+/* first run may take, 1 or more (SUDOKU_RESTART_NODES in a new context).    */
+/* With a policy, each run of the search gives up after its share of nodes   */
+/* and the next starts again from the top in a different random order,       */
+/* Luby's runs being 1, 1, 2, 1, 1, 2, 4, ... times the first and geometric  */
+/* runs each half as long again as the last.  The values of each guess are   */
+/* tried in random order and ties in the branching heuristic broken at       */
+/* random, from random numbers seeded by sudoku_set_seed() (0 in a new       */
+/* context) afresh for each solve, so the same seed always gives the same    */
+/* result.  That takes the long tail off the time hard puzzles take, where a */
+/* fixed order is sometimes very unlucky.  Counting more than one solution   */
+/* ignores the policy, as restarting would find the same ones again, and so  */
+/* does a search split between threads.                                      */
+/* sudoku_restart_name() lists the policies.                                 */
+/*                                                                           */
+/* sudoku_set_portfolio() turns racing on or off (it is off in a new         */
+/* context).  With it on and more than one thread, sudoku_solve() runs a     */
+/* differently configured search of the whole puzzle on each thread rather   */
+/* than splitting one search between them: the first as configured, the      */
+/* rest restarting with the Luby and geometric policies in turn, each with   */
+/* a seed of its own, and some with a different branching heuristic.         */
+/* The result is that of the search needing the fewest nodes, not whichever  */
+/* happened to finish first, so it depends only on the configuration, the    */
+/* seed and the number of threads, and the statistics are that search's.     */
+/* Each search has the whole node budget.  It only applies to the logic      */
+/* engine, and not to batches, which already use the threads.                */
+/*                                                                           */
+/* sudoku_set_size() sets the size of the grid: 4, 9, 16 or 25, a grid of    */
+/* size N having N blocks of N entries.  A new context's grid is 9x9, and    */
+/* setting the size empties it.  Other sizes have a solver of their own,     */
+/* with a copy for each size built for its masks, which propagates fixed     */
+/* values, fixes hidden singles and guesses at the entry with the fewest     */
+/* candidates.  Only the count and budget apply to it: the engine, kernel,   */
+/* branching, rules, threads and cache are for 9x9 grids only.  Batches are  */
+/* always 9x9, whatever the size.  It also returns 0 if it's out of memory.  */
+/*                                                                           */
+/* sudoku_set_variant() picks the kind of puzzle by name, and so the units   */
+/* that must each hold every value once: "standard" (the rows, columns and   */
+/* blocks, the default), "x" (the two long diagonals as well), "windoku"     */
+/* (the four windows as well) or "jigsaw" (regions in place of the blocks).  */
+/* sudoku_variant_name() lists them.  A jigsaw puzzle's regions are given by */
+/* sudoku_set_regions(), numbering each entry's region from 1; it returns 0  */
+/* unless the variant is jigsaw and each region has SUDOKU_SIZE entries.     */
+/* Until then the regions are the blocks.  Both empty the grid.  Every       */
+/* engine, kernel, rule and heuristic works for every variant, and so do     */
+/* batches and generating, but the cache only helps with standard puzzles.   */
+/* Variants are 9x9 only.                                                    */
+/*****************************************************************************/
+int sudoku_set_engine(sudoku_solver_t *solver, const char *name);
+int sudoku_set_kernel(sudoku_solver_t *solver, const char *name);
+int sudoku_set_branching(sudoku_solver_t *solver, const char *name);
+int sudoku_set_rules(sudoku_solver_t *solver, const char *list);
+int sudoku_set_threads(sudoku_solver_t *solver, int threads);
+int sudoku_set_lockstep(sudoku_solver_t *solver, int on);
+int sudoku_set_count(sudoku_solver_t *solver, long limit);
+int sudoku_set_budget(sudoku_solver_t *solver, long nodes, double seconds);
+int sudoku_set_restarts(sudoku_solver_t *solver, const char *name, long nodes);
+int sudoku_set_seed(sudoku_solver_t *solver, unsigned long seed);
+int sudoku_set_portfolio(sudoku_solver_t *solver, int on);
+int sudoku_set_size(sudoku_solver_t *solver, int size);
+int sudoku_set_variant(sudoku_solver_t *solver, const char *name);
+int sudoku_set_regions(sudoku_solver_t *solver,
+                       const int regions[SUDOKU_CELLS]);
+const char *sudoku_engine_name(int index);
+const char *sudoku_kernel_name(int index);
+const char *sudoku_branching_name(int index);
+const char *sudoku_restart_name(int index);
+const char *sudoku_route_name(int index);
+const char *sudoku_rule_name(int index);
+const char *sudoku_variant_name(int index);
+
+/*****************************************************************************/
+/* Loading a puzzle, replacing any previous one.  sudoku_load() takes the    */
+/* values row by row, 0 for unknown.  sudoku_load_line() takes SUDOKU_CELLS  */
+/* characters, each a digit or '0' or '.' for unknown, optionally followed   */
+/* by white space or a comma and anything else.  Each returns 0 if the input */
+/* isn't in that form.  Clashing givens aren't detected until solving.       */
+/*                                                                           */
+/* For a grid of size N other than 9, sudoku_load() takes N * N values and   */
+/* sudoku_load_line() N * N characters, values from 10 up being letters      */
+/* from 'A', in either case.  Arrays passed to the functions below likewise  */
+/* have N * N elements.                                                      */
+/*****************************************************************************/
+int sudoku_load(sudoku_solver_t *solver, const int values[SUDOKU_CELLS]);
+int sudoku_load_line(sudoku_solver_t *solver, const char *line);
+
+/*****************************************************************************/
+/* Solves the loaded puzzle, returning SUDOKU_SOLVED, SUDOKU_NO_SOLUTION or  */
+/* SUDOKU_BUDGET_EXCEEDED.                                                   */
+/*****************************************************************************/
+int sudoku_solve(sudoku_solver_t *solver);
+
+/*****************************************************************************/
+/* Solves a batch of puzzles, independently of anything loaded, using the    */
+/* context's configuration and threads.  The context's own puzzle and        */
+/* statistics are lost.                                                      */
+/*****************************************************************************/
+void sudoku_solve_jobs(sudoku_solver_t *solver,
+                       sudoku_job_t *jobs,
+                       long count);
+
+/*****************************************************************************/
+/* Generating puzzles.  sudoku_generate_jobs() fills each job of a batch     */
+/* with a new puzzle that has a unique solution, in the single-line format   */
+/* with '.' for unknown entries, using the context's threads.  Each starts   */
+/* from a random complete grid and has clues taken away, in random order,    */
+/* for as long as the solution stays unique, as checked within the budget by */
+/* the logic engine's search whatever the selected engine (the check rules   */
+/* candidates out, which only that engine can search from).  Job N of the    */
+/* batch is generated from seed + N alone, so the same seed always gives the */
+/* same puzzles, however many threads there are, and a long run can be split */
+/* into several calls.  The status is SUDOKU_SOLVED, or                      */
+/* SUDOKU_BUDGET_EXCEEDED if the puzzle still has more clues than the target */
+/* after many attempts (it is the one with the fewest found).  The counters  */
+/* cover all the solving it took.                                            */
+/*                                                                           */
+/* sudoku_set_symmetry() makes the clues symmetric, by name: "none" (the     */
+/* default), "rotational" (a half turn), "quarter" (a quarter turn),         */
+/* "mirror" (left to right) or "diagonal".  sudoku_symmetry_name() lists     */
+/* them.  sudoku_set_clues() sets the most clues to leave, 0 (the default)   */
+/* meaning as few as possible: clues are then taken away until none can be.  */
+/* Below 20 or so, a target is rarely met.                                   */
+/*****************************************************************************/
+int sudoku_set_symmetry(sudoku_solver_t *solver, const char *name);
+int sudoku_set_clues(sudoku_solver_t *solver, int clues);
+const char *sudoku_symmetry_name(int index);
+void sudoku_generate_jobs(sudoku_solver_t *solver,
+                          sudoku_job_t *jobs,
+                          long count,
+                          unsigned long seed);
+
+/*****************************************************************************/
+/* Result cache.  A context with a cache looks each puzzle up before solving */
+/* it, and keeps the result afterwards.  Puzzles are looked up by their      */
+/* canonical form, so a puzzle is found not only if it has been solved       */
+/* before but also if one that differs only by relabelling the values,       */
+/* reordering rows within a band, bands, columns within a stack or stacks,   */
+/* or transposing, has been.  A result found in the cache has counters of 0. */
+/* Results cut short by the budget aren't kept, and a result kept while      */
+/* looking for fewer solutions than are now wanted is only used if it found  */
+/* all there are.  Looking a puzzle up takes some microseconds, so a cache   */
+/* only pays when puzzles come round again.  Lockstep solving isn't used     */
+/* with a cache.                                                             */
+/*                                                                           */
+/* sudoku_cache_init() creates a cache holding up to capacity results,       */
+/* throwing away the least recently used when it's full, and returns NULL if */
+/* there isn't the memory.  One cache can be shared by any number of         */
+/* contexts, even on different threads, and must outlive them.               */
+/* sudoku_set_cache() gives a context a cache, or takes it away if NULL.     */
+/* sudoku_cache_stats() gives the number of results held, and of lookups     */
+/* that found one and that didn't.                                           */
+/*                                                                           */
+/* sudoku_cache_export() writes the results into a buffer, in a compact form */
+/* that doesn't depend on the machine, if the buffer is big enough, and      */
+/* returns the size needed.  sudoku_cache_import() adds the results in such  */
+/* a buffer to a cache, as the most recently used, and returns how many, or  */
+/* -1 (adding none) if the buffer isn't an exported cache.                   */
+/*****************************************************************************/
+typedef struct sudoku_cache sudoku_cache_t;
+
+sudoku_cache_t *sudoku_cache_init(long capacity);
+void sudoku_cache_free(sudoku_cache_t *cache);
+int sudoku_set_cache(sudoku_solver_t *solver, sudoku_cache_t *cache);
+void sudoku_cache_stats(sudoku_cache_t *cache,
+                        long *entries,
+                        long *hits,
+                        long *misses);
+size_t sudoku_cache_export(sudoku_cache_t *cache,
+                           unsigned char *buffer,
+                           size_t size);
+long sudoku_cache_import(sudoku_cache_t *cache,
+                         const unsigned char *data,
+                         size_t size);
+
+/*****************************************************************************/
+/* Results.  sudoku_result() gives the value of every entry, row by row, or  */
+/* 0 where it isn't known: after loading these are the givens, and after a   */
+/* successful solve the solution.  sudoku_candidates() gives each entry's    */
+/* remaining candidates as a mask, bit N-1 set if N is possible.             */
+/*****************************************************************************/
+void sudoku_result(const sudoku_solver_t *solver, int values[SUDOKU_CELLS]);
+void sudoku_candidates(const sudoku_solver_t *solver,
+                       unsigned int masks[SUDOKU_CELLS]);
+
+/*****************************************************************************/
+/* How many solutions the last solve found, up to the limit set by           */
+/* sudoku_set_count().  The solution sudoku_result() gives is the first of   */
+/* them.                                                                     */
+/*****************************************************************************/
+long sudoku_solutions(const sudoku_solver_t *solver);
+
+/*****************************************************************************/
+/* Statistics for the last solve: the counters above, the deepest recursion  */
+/* reached, and for each active deduction rule, in order, its name and how   */
+/* many times it made progress.  sudoku_rule_hits() returns NULL past the    */
+/* last active rule, or straight away if the engine doesn't use the rules or */
+/* the auto engine gave the puzzle to dlx.                                   */
+/*****************************************************************************/
+void sudoku_get_stats(const sudoku_solver_t *solver, sudoku_stats_t *stats);
+int sudoku_max_depth(const sudoku_solver_t *solver);
+const char *sudoku_rule_hits(const sudoku_solver_t *solver,
+                             int index,
+                             long *hits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,262 @@
+/*****************************************************************************/
+/* Units of the puzzle variants.  See units.h.                               */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Header files.                                                             */
+/*****************************************************************************/
+#include <string.h>
+#include "units.h"
+
+/*****************************************************************************/
+/* Handy constants.                                                          */
+/*****************************************************************************/
+#define SIZE SUDOKU_SIZE
+#define BLOCK_SIZE 3
+#define TRUE 1
+#define FALSE 0
+
+/*****************************************************************************/
+/* Which of the three stripes of windoku groups a row or column is in: that  */
+/* of the first windows, that of the second, or those between and around     */
+/* them.                                                                     */
+/*****************************************************************************/
+#define STRIPE(X) \
+  ((((X) % (BLOCK_SIZE + 1)) == 0) ? 2 : ((X) / (BLOCK_SIZE + 1)))
+
+/*****************************************************************************/
+/* Prototypes.                                                               */
+/*****************************************************************************/
+static int add_groups(struct units *, const int *);
+static void add_peers(struct units *, int);
+static void add_crossings(struct units *, int);
+
+/*****************************************************************************/
+/* Builds the tables for a variant.                                          */
+/*****************************************************************************/
+int units_build(struct units *units,
+                const int *regions,
+                int diagonals,
+                int windows)
+{
+  int group[SIZE*SIZE];
+  int seen[SIZE];
+  int ii;
+  int jj;
+  int nn;
+
+  /***************************************************************************/
+  /* Check the regions first, so that bad ones leave the tables alone.       */
+  /***************************************************************************/
+  if (regions != NULL)
+  {
+    memset(seen, 0, sizeof(seen));
+
+    for (nn=0; nn < (SIZE*SIZE); nn++)
+    {
+      if ((regions[nn] < 1) ||
+          (regions[nn] > SIZE) ||
+          (++seen[regions[nn] - 1] > SIZE))
+      {
+        return (FALSE);
+      }
+    }
+  }
+
+  units->count = 0;
+  memset(units->num_of, 0, sizeof(units->num_of));
+
+  /***************************************************************************/
+  /* The rows, the columns and the boxes.                                    */
+  /***************************************************************************/
+  for (ii=0; ii < SIZE; ii++)
+  {
+    for (jj=0; jj < SIZE; jj++)
+    {
+      group[(ii * SIZE) + jj] = ii;
+    }
+  }
+  (void)add_groups(units, group);
+
+  for (ii=0; ii < SIZE; ii++)
+  {
+    for (jj=0; jj < SIZE; jj++)
+    {
+      group[(jj * SIZE) + ii] = ii;
+    }
+  }
+  (void)add_groups(units, group);
+
+  for (nn=0; nn < (SIZE*SIZE); nn++)
+  {
+    group[nn] = (regions != NULL) ? (regions[nn] - 1) :
+                ((((nn / SIZE) / BLOCK_SIZE) * BLOCK_SIZE) +
+                 ((nn % SIZE) / BLOCK_SIZE));
+  }
+  units->regular = add_groups(units, group);
+
+  /***************************************************************************/
+  /* The extra units of the other variants.                                  */
+  /***************************************************************************/
+  if (diagonals)
+  {
+    for (ii=0; ii < SIZE; ii++)
+    {
+      units->entries[units->count][ii] = (unsigned char)((ii * SIZE) + ii);
+      units->entries[units->count + 1][ii] =
+        (unsigned char)((ii * SIZE) + (SIZE - 1 - ii));
+    }
+
+    for (ii=0; ii < 2; ii++, units->count++)
+    {
+      for (jj=0; jj < SIZE; jj++)
+      {
+        nn = units->entries[units->count][jj];
+        units->of[nn][units->num_of[nn]++] = (unsigned char)units->count;
+      }
+    }
+    units->regular = FALSE;
+  }
+
+  if (windows)
+  {
+    for (nn=0; nn < (SIZE*SIZE); nn++)
+    {
+      group[nn] = (STRIPE(nn / SIZE) * BLOCK_SIZE) + STRIPE(nn % SIZE);
+    }
+    (void)add_groups(units, group);
+    units->regular = FALSE;
+  }
+
+  for (nn=0; nn < (SIZE*SIZE); nn++)
+  {
+    add_peers(units, nn);
+  }
+
+  units->num_crossings = 0;
+
+  for (ii=0; ii < units->count; ii++)
+  {
+    add_crossings(units, ii);
+  }
+  return (TRUE);
+}
+
+/*****************************************************************************/
+/* Adds SIZE units, unit N being the entries in group N, and returns TRUE if */
+/* they are the standard blocks.                                             */
+/*****************************************************************************/
+static int add_groups(struct units *units, const int *group)
+{
+  int filled[SIZE];
+  int uu;
+  int nn;
+  int blocks = TRUE;
+
+  memset(filled, 0, sizeof(filled));
+
+  for (nn=0; nn < (SIZE*SIZE); nn++)
+  {
+    uu = units->count + group[nn];
+    units->entries[uu][filled[group[nn]]++] = (unsigned char)nn;
+    units->of[nn][units->num_of[nn]++] = (unsigned char)uu;
+
+    if (group[nn] != ((((nn / SIZE) / BLOCK_SIZE) * BLOCK_SIZE) +
+                      ((nn % SIZE) / BLOCK_SIZE)))
+    {
+      blocks = FALSE;
+    }
+  }
+
+  units->count += SIZE;
+  return (blocks);
+}
+
+/*****************************************************************************/
+/* Lists an entry's peers: every other entry of each of its units in turn,   */
+/* leaving out any already listed for an earlier one.                        */
+/*****************************************************************************/
+static void add_peers(struct units *units, int nn)
+{
+  unsigned char listed[SIZE*SIZE];
+  int uu;
+  int kk;
+  int peer;
+
+  memset(listed, 0, sizeof(listed));
+  listed[nn] = TRUE;
+  units->num_peers[nn] = 0;
+
+  for (uu=0; uu < units->num_of[nn]; uu++)
+  {
+    for (kk=0; kk < SIZE; kk++)
+    {
+      peer = units->entries[units->of[nn][uu]][kk];
+
+      if (listed[peer] == FALSE)
+      {
+        listed[peer] = TRUE;
+        units->peers[nn][units->num_peers[nn]++] = (unsigned char)peer;
+      }
+    }
+  }
+  return;
+}
+
+/*****************************************************************************/
+/* Records where a unit crosses each later unit in more than one entry.      */
+/*****************************************************************************/
+static void add_crossings(struct units *units, int first)
+{
+  unsigned short first_places[UNITS_MAX];
+  unsigned short second_places[UNITS_MAX];
+  int count[UNITS_MAX];
+  struct crossing *crossing;
+  int second;
+  int nn;
+  int kk;
+  int ll;
+  int uu;
+
+  memset(count, 0, sizeof(count));
+
+  for (kk=0; kk < SIZE; kk++)
+  {
+    nn = units->entries[first][kk];
+
+    for (uu=0; uu < units->num_of[nn]; uu++)
+    {
+      second = units->of[nn][uu];
+
+      if (second <= first)
+      {
+        continue;
+      }
+
+      for (ll=0; units->entries[second][ll] != nn; ll++)
+      {
+      }
+
+      if (count[second]++ == 0)
+      {
+        first_places[second] = 0;
+        second_places[second] = 0;
+      }
+      first_places[second] |= (unsigned short)(1 << kk);
+      second_places[second] |= (unsigned short)(1 << ll);
+    }
+  }
+
+  for (second=first+1; second < units->count; second++)
+  {
+    if (count[second] > 1)
+    {
+      crossing = &units->crossings[units->num_crossings++];
+      crossing->first = (unsigned char)first;
+      crossing->second = (unsigned char)second;
+      crossing->first_places = first_places[second];
+      crossing->second_places = second_places[second];
+    }
+  }
+  return;
+}
@@ -0,0 +1,88 @@
+/*****************************************************************************/
+/* Units of the puzzle variants, used by the library's engines.  Not part of */
+/* the public interface.                                                     */
+/*                                                                           */
+/* A unit is a set of SUDOKU_SIZE entries that must hold every value once.   */
+/* Every variant has the rows, then the columns, then its boxes: the blocks, */
+/* or for a jigsaw puzzle the regions drawn on its grid.  X-Sudoku adds the  */
+/* two long diagonals.  Windoku adds its four windows and the five groups    */
+/* they imply: the entries the windows leave in the same three rows as one   */
+/* and the same three columns as another also hold every value once.         */
+/*                                                                           */
+/* The tables are built once for each variant, or for each jigsaw layout,    */
+/* and everything that works through the units reads them rather than        */
+/* knowing their shape: each entry's units and peers for propagation and     */
+/* branching, the units themselves for the rules and checks, and the places  */
+/* where two units cross for the locked candidates rules.                    */
+/*****************************************************************************/
+#ifndef UNITS_H
+#define UNITS_H
+
+#include "sudoku.h"
+
+/*****************************************************************************/
+/* Most units there can be, most any one entry is in, and most peers (other  */
+/* entries sharing a unit with it) it can have.  Every entry's first peers   */
+/* are the rest of its row, in order, then the rest of its column, so the    */
+/* first UNITS_LINE_PEERS are its row and the next as many its column.       */
+/*****************************************************************************/
+#define UNITS_MAX (4 * SUDOKU_SIZE)
+#define UNITS_PER_ENTRY 5
+#define UNITS_LINE_PEERS (SUDOKU_SIZE - 1)
+#define UNITS_MAX_PEERS (UNITS_PER_ENTRY * (SUDOKU_SIZE - 1))
+
+/*****************************************************************************/
+/* Two units crossing in more than one entry: the units, and for each a mask */
+/* of its positions in the crossing.  Each unit crosses at most half as many */
+/* others as there are other units for its entries to be in.                 */
+/*****************************************************************************/
+#define UNITS_MAX_CROSSINGS \
+  ((UNITS_MAX * (UNITS_PER_ENTRY - 1) * SUDOKU_SIZE) / 4)
+
+struct crossing
+{
+  unsigned char first;
+  unsigned char second;
+  unsigned short first_places;
+  unsigned short second_places;
+};
+
+struct units
+{
+  /***************************************************************************/
+  /* How many units there are, and whether they are just the standard rows,  */
+  /* columns and blocks, in which case the engines can take short cuts.      */
+  /***************************************************************************/
+  int count;
+  int regular;
+
+  /***************************************************************************/
+  /* Each unit's entries (row * SUDOKU_SIZE + column) in row-major order.    */
+  /***************************************************************************/
+  unsigned char entries[UNITS_MAX][SUDOKU_SIZE];
+
+  /***************************************************************************/
+  /* Each entry's units, in the order above, and its peers.                  */
+  /***************************************************************************/
+  unsigned char num_of[SUDOKU_CELLS];
+  unsigned char of[SUDOKU_CELLS][UNITS_PER_ENTRY];
+  unsigned char num_peers[SUDOKU_CELLS];
+  unsigned char peers[SUDOKU_CELLS][UNITS_MAX_PEERS];
+
+  /***************************************************************************/
+  /* The crossings, ordered by first unit and then second.                   */
+  /***************************************************************************/
+  int num_crossings;
+  struct crossing crossings[UNITS_MAX_CROSSINGS];
+};
+
+/*****************************************************************************/
+/* units_build() builds the tables.  regions gives each entry's region,      */
+/* numbered from 1, for a jigsaw puzzle, or is NULL for the blocks; the      */
+/* other two say whether to add the diagonals or the windows (not both).     */
+/* Returns 0, leaving the tables as they were, if the regions aren't         */
+/* SUDOKU_SIZE entries each.                                                 */
+/*****************************************************************************/
+int units_build(struct units *, const int *, int, int);
+
+#endif